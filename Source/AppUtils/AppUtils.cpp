@@ -317,3 +317,54 @@ BString RootPathAtDepth(const char *pathStr, size_t pathStrLen, size_t depth)
     BString none;
     return none;
 }
+
+
+static int64 DaysFromCivil(int64 year, int32 month, int32 day)
+{
+    // Days since 1970-01-01 in the proleptic Gregorian calendar, month being 1-12
+    year -= month <= 2;
+    int64 const era = (year >= 0 ? year : year - 399) / 400;
+    int64 const yearOfEra = year - era * 400;
+    int64 const dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    int64 const dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+
+time_t LocalTimeToTime(struct tm* timeStruct)
+{
+    // Same result as mktime() but mktime() is only asked for the UTC offset once per wall-clock hour;
+    // the offsets are cached as "hour << 20 | offset + 2^19" so parser threads can share them
+    static int64 offsetCache[64];
+
+    assert(timeStruct);
+    if (timeStruct->tm_mon < 0 || timeStruct->tm_mon > 11)
+        return mktime(timeStruct);
+
+    int64 const wallTime = DaysFromCivil(timeStruct->tm_year + 1900LL, timeStruct->tm_mon + 1, timeStruct->tm_mday)
+                           * 86400 + timeStruct->tm_hour * 3600 + timeStruct->tm_min * 60 + timeStruct->tm_sec;
+    int64 wallHour = wallTime / 3600;
+    if (wallTime % 3600 < 0)
+        --wallHour;
+
+    int64* slot = &offsetCache[wallHour & 63];
+    uint64 const tag = (uint64)wallHour << 20;
+    uint64 cached = (uint64)atomic_get64(slot);
+    if ((cached & 0xfffff) == 0 || (cached & ~(uint64)0xfffff) != tag)
+    {
+        struct tm localStruct = *timeStruct;
+        localStruct.tm_isdst = -1;
+        time_t const timeValue = mktime(&localStruct);
+        if (timeValue == (time_t)-1)
+            return timeValue;
+
+        int64 const offset = wallTime - timeValue;
+        if (offset <= -(1 << 19) || offset >= (1 << 19))
+            return timeValue;
+
+        cached = tag | (uint64)(offset + (1 << 19));
+        atomic_set64(slot, (int64)cached);
+    }
+
+    return (time_t)(wallTime - ((int64)(cached & 0xfffff) - (1 << 19)));
+}
@@ -7,6 +7,8 @@
 
 #include <String.h>
 
+#include <ctime>
+
 extern BString        StringFromBytes(uint64 bytes);
 extern BString        StringFromDigitalSize(char *size, char *unit);
 extern int8           MonthStrToNum(const char* month);
@@ -22,5 +24,6 @@ extern BString        SupressWildcardSet(const char* str);
 extern bool           IsPermString(const char *str, size_t len);
 extern void           StrReverse(char *str, size_t len);
 extern BString        RootPathAtDepth(const char *pathStr, size_t pathStrLen, size_t depth);
+extern time_t         LocalTimeToTime(struct tm* timeStruct);
 
 #endif /* _APP_UTILS_H */
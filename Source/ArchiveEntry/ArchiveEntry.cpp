@@ -6,8 +6,6 @@
 #include "ArchiveEntry.h"
 #include "AppUtils.h"
 
-#include <DateTimeFormat.h>
-
 #include <cstdio>
 #include <cstdlib> // gcc2
 
@@ -24,7 +22,6 @@ ArchiveEntry::ArchiveEntry(bool dir, const char* pathStr, const char* sizeStr, c
     m_sizeStr(strdup(sizeStr)),     // bytes as a string.
     m_packedStr(strdup(packedStr)), // bytes as a string.
     m_ratioStr((char*)malloc(8)),
-    m_dateStr(NULL),
     m_methodStr(methodStr ? strdup(methodStr) : NULL),
     m_crcStr(crcStr ? strdup(crcStr) : NULL),
     m_dirStr(NULL),
@@ -43,12 +40,6 @@ ArchiveEntry::ArchiveEntry(bool dir, const char* pathStr, const char* sizeStr, c
         m_dirStr[len] = 0;
     }
 
-    // Format date using system settings
-    BString dateBuf;
-    if (BDateTimeFormat().Format(dateBuf, timeValue, B_SHORT_DATE_FORMAT, B_SHORT_TIME_FORMAT) != B_OK)
-        dateBuf = "???";
-    m_dateStr = strdup(dateBuf.String());
-
     // Calculate ratio and update m_ratioStr
     RecalculateRatio();
 }
@@ -62,7 +53,6 @@ ArchiveEntry::~ArchiveEntry()
     free(m_sizeStr);
     free(m_packedStr);
     free(m_ratioStr);
-    free(m_dateStr);
     free(m_methodStr);
     free(m_crcStr);
 }
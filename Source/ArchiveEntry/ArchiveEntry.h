@@ -23,7 +23,6 @@ class ArchiveEntry
                           *m_sizeStr,     // bytes as a string.
                           *m_packedStr,   // bytes as a string.
                           *m_ratioStr,
-                          *m_dateStr,
                           *m_methodStr,
                           *m_crcStr,
                           *m_dirStr;
@@ -12,8 +12,10 @@
 #include "AppConstants.h"
 #include "KeyedMenuItem.h"
 
+#include <DateTimeFormat.h>
 #include <Directory.h>
 #include <File.h>
+#include <Locker.h>
 #include <Menu.h>
 #include <MenuItem.h>
 #include <PathFinder.h>
@@ -29,7 +31,216 @@
 #define B_TRANSLATE(x) x
 #endif
 
+#include <cctype>
+#include <cmath>
+#include <cstdio>
 #include <cstdlib> // needed for gcc2
+#include <cstring>
+
+static const size_t kParseChunkSize = 64 * 1024;
+static const size_t kMaxParseLineLength = B_PATH_NAME_LENGTH + 511;
+static const int32 kParseQueueSize = 16;
+static const int32 kMaxParseWorkers = 8;
+static const int32 kMaxIconExtensionLength = 15;
+static const size_t kEntropyWindowSize = 16 * 1024;
+static const int32 kMaxSampledFiles = 256;
+static const int32 kTarSampleWindows = 32;
+static const size_t kHashBufferSize = 64 * 1024;
+static const int32 kMaxHashWorkers = 8;
+static const off_t kMinDuplicateSize = 4 * 1024;
+
+// Positions of the file icons in the icon list handed to SetIconList()
+enum
+{
+    kBinaryIcon = 1,
+    kHtmlIcon,
+    kTextIcon,
+    kSourceIcon,
+    kAudioIcon,
+    kArchiveIcon,
+    kPackageIcon,
+    kPdfIcon,
+    kImageIcon
+};
+
+
+struct ExtensionIcon
+{
+    const char*         extension;
+    int32               icon;
+};
+
+
+// Sorted by extension for bsearch(); entries from the user's K_SETTINGS_FILE_ICONS file take precedence
+static const ExtensionIcon kExtensionIcons[] =
+{
+    { "7z",    kArchiveIcon },
+    { "aiff",  kAudioIcon },
+    { "bmp",   kImageIcon },
+    { "bz2",   kArchiveIcon },
+    { "c",     kSourceIcon },
+    { "cc",    kSourceIcon },
+    { "cpp",   kSourceIcon },
+    { "cxx",   kSourceIcon },
+    { "doc",   kTextIcon },
+    { "flac",  kAudioIcon },
+    { "gif",   kImageIcon },
+    { "gz",    kArchiveIcon },
+    { "gzip",  kArchiveIcon },
+    { "h",     kSourceIcon },
+    { "hpkg",  kPackageIcon },
+    { "hpp",   kSourceIcon },
+    { "htm",   kHtmlIcon },
+    { "html",  kHtmlIcon },
+    { "jpeg",  kImageIcon },
+    { "jpg",   kImageIcon },
+    { "md",    kTextIcon },
+    { "mid",   kAudioIcon },
+    { "midi",  kAudioIcon },
+    { "mod",   kAudioIcon },
+    { "mp2",   kAudioIcon },
+    { "mp3",   kAudioIcon },
+    { "ogg",   kAudioIcon },
+    { "opus",  kAudioIcon },
+    { "pdf",   kPdfIcon },
+    { "pkg",   kPackageIcon },
+    { "png",   kImageIcon },
+    { "py",    kSourceIcon },
+    { "rar",   kArchiveIcon },
+    { "rb",    kSourceIcon },
+    { "riff",  kAudioIcon },
+    { "sh",    kTextIcon },
+    { "tar",   kArchiveIcon },
+    { "tga",   kImageIcon },
+    { "tgz",   kArchiveIcon },
+    { "tiff",  kImageIcon },
+    { "txt",   kTextIcon },
+    { "txz",   kArchiveIcon },
+    { "wav",   kAudioIcon },
+    { "webp",  kImageIcon },
+    { "xhtml", kHtmlIcon },
+    { "xz",    kArchiveIcon },
+    { "z",     kArchiveIcon },
+    { "zip",   kArchiveIcon },
+    { "zst",   kArchiveIcon }
+};
+
+
+static int CompareExtensionIcons(const void* a, const void* b)
+{
+    return strcmp(((const ExtensionIcon*)a)->extension, ((const ExtensionIcon*)b)->extension);
+}
+
+
+static int CompareUserIcons(const void* a, const void* b)
+{
+    // BList::SortItems() and bsearch() over BList::Items() hand us pointers to the items
+    return strcmp((*(ExtensionIcon* const*)a)->extension, (*(ExtensionIcon* const*)b)->extension);
+}
+
+
+// A run of complete lines from a listing and the entries parsed out of them
+struct ParseBatch
+{
+    int32               index;
+    char*               text;
+    size_t              size;
+    BList               entries;
+    bool                endReached;
+};
+
+
+// A file that may repeat another one, along with the hash of its first block once read
+struct DuplicateFile
+{
+    char*               path;
+    off_t               size;
+    uint64              hash;
+    bool                hashed;
+};
+
+
+struct HashJob
+{
+    BList*              files;
+    int32               nextFile;
+    volatile bool*      cancel;
+};
+
+
+// Bounded queue passing batches between the stages of ReadOpenParallel(). The semaphores block
+// producers while it is full and consumers while it is empty; the lock only guards the indices
+class ParseQueue
+{
+    public:
+        ParseQueue(int32 capacity);
+        ~ParseQueue();
+
+        void                Push(ParseBatch* batch);
+        ParseBatch*         Pop();
+
+    private:
+        ParseBatch**        m_items;
+        int32               m_capacity,
+                            m_head,
+                            m_tail;
+        sem_id              m_freeSem,
+                            m_usedSem;
+        BLocker             m_lock;
+};
+
+
+struct ParsePipeline
+{
+    Archiver*           archiver;
+    FILE*               fp;
+    const char*         endMarker;
+    ParseQueue*         lines;
+    ParseQueue*         parsed;
+    int32               workerCount;
+};
+
+
+ParseQueue::ParseQueue(int32 capacity)
+    : m_items(new ParseBatch*[capacity]),
+      m_capacity(capacity),
+      m_head(0),
+      m_tail(0),
+      m_freeSem(create_sem(capacity, "parse_queue_free")),
+      m_usedSem(create_sem(0, "parse_queue_used"))
+{
+}
+
+
+ParseQueue::~ParseQueue()
+{
+    delete_sem(m_freeSem);
+    delete_sem(m_usedSem);
+    delete[] m_items;
+}
+
+
+void ParseQueue::Push(ParseBatch* batch)
+{
+    acquire_sem(m_freeSem);
+    m_lock.Lock();
+    m_items[m_tail] = batch;
+    m_tail = (m_tail + 1) % m_capacity;
+    m_lock.Unlock();
+    release_sem(m_usedSem);
+}
+
+
+ParseBatch* ParseQueue::Pop()
+{
+    acquire_sem(m_usedSem);
+    m_lock.Lock();
+    ParseBatch* batch = m_items[m_head];
+    m_head = (m_head + 1) % m_capacity;
+    m_lock.Unlock();
+    release_sem(m_freeSem);
+    return batch;
+}
 
 
 Archiver::Archiver()
@@ -78,8 +289,10 @@ void Archiver::Init()
     m_packageBmp              = NULL;
     m_pdfBmp                  = NULL;
     m_imageBmp                = NULL;
+    m_dateFormat              = new BDateTimeFormat();
     m_foldingLevel            = 3;
     m_defaultCompressionLevel = -1;
+    m_entriesPending          = 0;
 
     m_error                 = B_OK;
 }
@@ -103,7 +316,9 @@ Archiver::~Archiver()
     for (int32 i = 0; i < entryCount; i++)
         delete reinterpret_cast<ArchiveEntry*>(m_entriesList.ItemAtFast(i));
 
+    ClearExtensionIcons();
     delete m_hashTable;
+    delete m_dateFormat;
 
     int32 const mimeCount = m_mimeList.CountItems();
     for (int32 i = 0; i < mimeCount; i++)
@@ -270,6 +485,14 @@ void Archiver::FillLists(BList* files, BList* dirs)
     // Reset cache before filling our lists - bug fixed
     ResetCache();
 
+    // Take the entries listed so far, while an open is streaming them more may be added meanwhile
+    BList entriesList;
+    atomic_set(&m_entriesPending, 0);
+    m_entriesLock.Lock();
+    entriesList.AddList(&m_entriesList);
+    m_entriesList.MakeEmpty();
+    m_entriesLock.Unlock();
+
     // Dynamically size the hash table for improved performance
     // 'tableSizeMultiple' is the hash table size factor multiplier.
     // We allocate 'tableSizeMultiple' times the entry count (since we shall
@@ -277,7 +500,7 @@ void Archiver::FillLists(BList* files, BList* dirs)
     // Currently, the multiplier is just a rough estimate.
     float const tableSizeMultiple = 0.25;
 
-    int32 const entryCount = m_entriesList.CountItems();
+    int32 const entryCount = entriesList.CountItems();
     int32 const tableSize = entryCount + (int32)(entryCount * tableSizeMultiple);
     if (!m_hashTable)
     {
@@ -291,7 +514,7 @@ void Archiver::FillLists(BList* files, BList* dirs)
     // When opening any archive for the first time, since hash entries will be 0
     // we won't reallocate needlessly below.
     int32 const hashEntryCount = m_hashTable->CountItems();
-    if (CanPartiallyOpen() == false && hashEntryCount > 0)
+    if (CanPartiallyOpen() == false && hashEntryCount > 0 && m_entriesMessenger.IsValid() == false)
     {
         m_hashTable->DeleteAll();
         m_fileList.MakeEmpty();
@@ -306,12 +529,17 @@ void Archiver::FillLists(BList* files, BList* dirs)
         }
     }
 
+    // Entries that are streamed in batches outgrow a table sized for the first one
+    int32 const neededSize = m_hashTable->CountItems() + tableSize;
+    if (neededSize > m_hashTable->TableSize() && m_hashTable->TableSize() < HashTable::MaxCapacity())
+        m_hashTable->Resize(HashTable::OptimalSize(neededSize));
+
     // Create the file items in our list
     BList fileList;
     BList dirList;
     for (int32 i = 0; i < entryCount; i++)
     {
-        ArchiveEntry* entry = reinterpret_cast<ArchiveEntry*>(m_entriesList.ItemAtFast(i));
+        ArchiveEntry* entry = reinterpret_cast<ArchiveEntry*>(entriesList.ItemAtFast(i));
         if (entry->m_dirStr != NULL)
             AddDirPathToTable(&dirList, entry->m_dirStr);
 
@@ -325,8 +553,8 @@ void Archiver::FillLists(BList* files, BList* dirs)
                 entry->m_dirStr[strlen(entry->m_dirStr) - 1] = '\0';
 
             // Get size and packed as human-readable size strings (MiB, KiB etc).
-            unsigned long bytesSize = strtoul(entry->m_sizeStr, NULL, 10 /* radix */);
-            unsigned long packedSize = strtoul(entry->m_packedStr, NULL, 10 /* radix */);
+            off_t bytesSize = strtoll(entry->m_sizeStr, NULL, 10 /* radix */);
+            off_t packedSize = strtoll(entry->m_packedStr, NULL, 10 /* radix */);
             BString const bytesStr = StringFromBytes(bytesSize);
             BString const packedStr = StringFromBytes(packedSize);
 
@@ -335,9 +563,9 @@ void Archiver::FillLists(BList* files, BList* dirs)
             BBitmap* icon = BitmapForExtension(entry->m_nameStr);
             ListEntry* listItem;
             listItem = new ListEntry(0, false, false, icon, entry->m_nameStr, bytesStr.String(), packedStr.String(),
-                                     entry->m_ratioStr, entry->m_dirStr, entry->m_dateStr, entry->m_methodStr,
+                                     entry->m_ratioStr, entry->m_dirStr, entry->m_methodStr,
                                      entry->m_crcStr, entry->m_dirStr, entry->m_pathStr, bytesSize, packedSize,
-                                     entry->m_timeValue);
+                                     entry->m_timeValue, m_dateFormat);
 
             // If file doesn't exist simply set its HashItem to have its listentry
             if (item != NULL)
@@ -362,8 +590,6 @@ void Archiver::FillLists(BList* files, BList* dirs)
         delete entry;
     }
 
-    m_entriesList.MakeEmpty();
-
     // Create folder items also add to hash table for quick finding & uniqueness
     int32 uniqueDirCount = dirList.CountItems();
     for (int32 k = 0L; k < uniqueDirCount; k++)
@@ -387,7 +613,8 @@ void Archiver::FillLists(BList* files, BList* dirs)
         // Get parent's path without the slash (true = truncate slash)
         char* parentDirPath = ParentPath(dirPath, true);
         ListEntry* itemEntry = new ListEntry(level, true, expand, m_folderBmp, LeafFromPath(dirPath),
-                                             NULL, NULL, NULL, NULL, NULL, NULL, NULL, parentDirPath, dirPath, 0, 0, 0);
+                                             NULL, NULL, NULL, NULL, NULL, NULL, parentDirPath, dirPath, 0, 0, 0,
+                                             m_dateFormat);
         item->m_clvItem = itemEntry;
         free((char*)parentDirPath);
     }
@@ -476,39 +703,97 @@ HashEntry* Archiver::AddFilePathToTable(BList* fileList, const char* path)
 
 BBitmap* Archiver::BitmapForExtension(const char* str) const
 {
-    // It seems this is fine, implementing a hashmap or similar structure won't give a significant speed
-    // boost according to NathanW of BeShare
-    char* extn = Extension(str, 4);
-    BBitmap* icon = m_binaryBmp;
-    if (extn)
-    {
-        if (strcmp(extn, "htm") == 0|| strcmp(extn, "html") == 0)
-            icon = m_htmlBmp;
-        else if (strcmp(extn, "cpp") == 0 || strcmp(extn, "c") == 0 || strcmp(extn, "h") == 0 ||
-                 strcmp(extn, "py") == 0 || strcmp(extn, "rb") == 0)
-            icon = m_sourceBmp;
-        else if (strcmp(extn, "txt") == 0 || strcmp(extn, "sh") == 0 || strcmp(extn, "doc") == 0)
-            icon = m_textBmp;
-        else if (strcmp(extn, "bmp") == 0 || strcmp(extn, "gif") == 0 || strcmp(extn, "png") == 0    ||
-                 strcmp(extn, "jpg") == 0 || strcmp(extn, "jpeg") == 0 || strcmp(extn, "tga") == 0 ||
-                 strcmp(extn, "tiff") == 0)
-            icon = m_imageBmp;
-        else if (strcmp(extn, "z") == 0 || strcmp(extn, "zip") == 0 || strcmp(extn, "gz") == 0 ||
-                 strcmp(extn, "gzip") == 0 || strcmp(extn, "tgz") == 0 || strcmp(extn, "xz") == 0 || strcmp(extn, "txz") == 0)
-            icon = m_archiveBmp;
-        else if (strcmp(extn, "wav") == 0 || strcmp(extn, "mp3") == 0 || strcmp(extn, "mp2") == 0    ||
-                 strcmp(extn, "aiff") == 0 || strcmp(extn, "riff") == 0 || strcmp(extn, "ogg") == 0 ||
-                 strcmp(extn, "mod") == 0 || strcmp(extn, "mid") == 0 || strcmp(extn, "midi") == 0)
-            icon = m_audioBmp;
-        else if (strcmp(extn, "pdf") == 0)
-            icon = m_pdfBmp;
-        else if (strcmp(extn, "pkg") == 0)
-            icon = m_packageBmp;
-
-        delete[] extn;
-    }
-
-    return icon;
+    if (m_iconList == NULL)
+        return NULL;
+
+    int32 icon = kBinaryIcon;
+    const char* dot = strrchr(str, '.');
+    if (dot != NULL)
+    {
+        char extension[kMaxIconExtensionLength + 1];
+        int32 length = 0;
+        for (const char* c = dot + 1; *c != '\0' && length <= kMaxIconExtensionLength; c++)
+            extension[length++] = tolower((unsigned char)*c);
+
+        if (length > 0 && length <= kMaxIconExtensionLength)
+        {
+            extension[length] = '\0';
+            ExtensionIcon const key = { extension, 0 };
+            const ExtensionIcon* const keyItem = &key;
+            ExtensionIcon* const* userIcon = (ExtensionIcon* const*)bsearch(&keyItem, m_extensionIcons.Items(),
+                                                                            m_extensionIcons.CountItems(),
+                                                                            sizeof(void*), CompareUserIcons);
+            if (userIcon != NULL)
+                icon = (*userIcon)->icon;
+            else
+            {
+                size_t const iconCount = sizeof(kExtensionIcons) / sizeof(kExtensionIcons[0]);
+                const ExtensionIcon* builtInIcon = (const ExtensionIcon*)bsearch(&key, kExtensionIcons, iconCount,
+                                                                                 sizeof(ExtensionIcon),
+                                                                                 CompareExtensionIcons);
+                if (builtInIcon != NULL)
+                    icon = builtInIcon->icon;
+            }
+        }
+    }
+
+    return (BBitmap*)m_iconList->ItemAtFast(icon);
+}
+
+
+void Archiver::LoadExtensionIcons()
+{
+    // Each line of the file maps an extension to one of the icon names below, e.g. "webm audio"
+    static const char* const kIconNames[] = { "folder", "binary", "html", "text", "source", "audio", "archive",
+                                              "package", "pdf", "image" };
+
+    ClearExtensionIcons();
+    if (m_settingsDirectoryPath == NULL)
+        return;
+
+    BString filePath = m_settingsDirectoryPath;
+    filePath << "/" << K_SETTINGS_FILE_ICONS;
+    FILE* fp = fopen(filePath.String(), "r");
+    if (fp == NULL)
+        return;
+
+    char line[256];
+    while (fgets(line, sizeof(line), fp) != NULL)
+    {
+        char extension[kMaxIconExtensionLength + 1], iconName[16];
+        if (line[0] == '#' || sscanf(line, "%15s %15s", extension, iconName) != 2)
+            continue;
+
+        for (int32 i = kBinaryIcon; i < (int32)(sizeof(kIconNames) / sizeof(kIconNames[0])); i++)
+        {
+            if (strcasecmp(iconName, kIconNames[i]) != 0)
+                continue;
+
+            for (char* c = extension; *c != '\0'; c++)
+                *c = tolower((unsigned char)*c);
+
+            ExtensionIcon* userIcon = new ExtensionIcon;
+            userIcon->extension = strdup(extension[0] == '.' ? extension + 1 : extension);
+            userIcon->icon = i;
+            m_extensionIcons.AddItem(userIcon);
+            break;
+        }
+    }
+
+    fclose(fp);
+    m_extensionIcons.SortItems(CompareUserIcons);
+}
+
+
+void Archiver::ClearExtensionIcons()
+{
+    for (int32 i = m_extensionIcons.CountItems() - 1; i >= 0; i--)
+    {
+        ExtensionIcon* userIcon = (ExtensionIcon*)m_extensionIcons.ItemAtFast(i);
+        free((char*)userIcon->extension);
+        delete userIcon;
+    }
+    m_extensionIcons.MakeEmpty();
 }
 
 
@@ -517,16 +802,21 @@ status_t Archiver::ReadErrStream(FILE* fp, const char* escapeSeq)
     // Read entire stream into a BString, check for errors
     BString fullErrorString;
     ReadStream(fp, fullErrorString);
+    return ReadErrString(fullErrorString, escapeSeq);
+}
+
 
-    if ((fullErrorString.Length() > 0L))
+status_t Archiver::ReadErrString(BString const& errorString, const char* escapeSeq)
+{
+    if ((errorString.Length() > 0L))
     {
         // An option string to escape ("Empty archive warning" lines etc. can be passed here)
         // and in general any line which must not be treated as an error
-        if (escapeSeq && fullErrorString.FindFirst(escapeSeq) >= 0L)
+        if (escapeSeq && errorString.FindFirst(escapeSeq) >= 0L)
             return BZR_DONE;
 
         m_errorDetails.RemoveName(kErrorString);
-        m_errorDetails.AddString(kErrorString, fullErrorString.String());
+        m_errorDetails.AddString(kErrorString, errorString.String());
         return BZR_ERRSTREAM_FOUND;
     }
 
@@ -548,6 +838,227 @@ void Archiver::ReadStream(FILE* fp, BString& str) const
 }
 
 
+status_t Archiver::ReadOpenParallel(FILE* fp, const char* endMarker)
+{
+    system_info sysInfo;
+    int32 maxWorkers = 1;
+    if (get_system_info(&sysInfo) == B_OK && sysInfo.cpu_count > 1)
+        maxWorkers = min_c((int32)sysInfo.cpu_count - 1, kMaxParseWorkers);
+
+    ParseQueue lines(kParseQueueSize);
+    ParseQueue parsed(kParseQueueSize + maxWorkers);
+    ParsePipeline pipeline = { this, fp, endMarker, &lines, &parsed, 0 };
+
+    thread_id* workers = new thread_id[maxWorkers];
+    for (int32 i = 0; i < maxWorkers; i++)
+    {
+        thread_id tid = spawn_thread(_parseWorker, "_parse_worker", B_NORMAL_PRIORITY, (void*)&pipeline);
+        if (tid < B_OK)
+            break;
+
+        workers[pipeline.workerCount++] = tid;
+        resume_thread(tid);
+    }
+
+    if (pipeline.workerCount == 0)
+    {
+        delete[] workers;
+        return B_NO_MORE_THREADS;
+    }
+
+    thread_id reader = spawn_thread(_parseReader, "_parse_reader", B_NORMAL_PRIORITY, (void*)&pipeline);
+    if (reader >= B_OK)
+        resume_thread(reader);
+    else
+    {
+        for (int32 i = 0; i < pipeline.workerCount; i++)
+            lines.Push(NULL);
+    }
+
+    // Batches finish out of order, hold back the ones parsed ahead of their turn
+    BList pending;
+    int32 nextIndex = 0;
+    int32 finishedWorkers = 0;
+    bool endReached = false;
+    while (finishedWorkers < pipeline.workerCount)
+    {
+        ParseBatch* batch = parsed.Pop();
+        if (batch == NULL)
+        {
+            finishedWorkers++;
+            continue;
+        }
+
+        pending.AddItem(batch);
+        for (int32 i = 0; i < pending.CountItems(); i++)
+        {
+            batch = (ParseBatch*)pending.ItemAtFast(i);
+            if (batch->index != nextIndex)
+                continue;
+
+            pending.RemoveItem(i);
+            if (endReached == false)
+            {
+                m_entriesLock.Lock();
+                m_entriesList.AddList(&batch->entries);
+                m_entriesLock.Unlock();
+
+                // One notification at a time, whoever takes the entries (FillLists) gets them all
+                if (m_entriesMessenger.IsValid() && atomic_or(&m_entriesPending, 1) == 0)
+                    m_entriesMessenger.SendMessage(BZR_ENTRIES_READY);
+            }
+            else
+            {
+                for (int32 j = 0; j < batch->entries.CountItems(); j++)
+                    delete (ArchiveEntry*)batch->entries.ItemAtFast(j);
+            }
+
+            endReached = endReached || batch->endReached;
+            delete batch;
+            nextIndex++;
+            i = -1;
+        }
+    }
+
+    status_t exitCode;
+    if (reader >= B_OK)
+        wait_for_thread(reader, &exitCode);
+
+    for (int32 i = 0; i < pipeline.workerCount; i++)
+        wait_for_thread(workers[i], &exitCode);
+
+    delete[] workers;
+    return reader >= B_OK ? BZR_DONE : reader;
+}
+
+
+ArchiveEntry* Archiver::ParseOpenLine(char* /*line*/)
+{
+    return NULL;
+}
+
+
+int32 Archiver::_parseReader(void* arg)
+{
+    ParsePipeline* pipeline = reinterpret_cast<ParsePipeline*>(arg);
+
+    // Only complete lines are handed on, a trailing partial line is carried over to the next chunk
+    char* carry = NULL;
+    size_t carrySize = 0;
+    int32 index = 0;
+    for (;;)
+    {
+        char* text = (char*)malloc(carrySize + kParseChunkSize + 1);
+        if (text == NULL)
+            break;
+
+        if (carrySize > 0)
+            memcpy(text, carry, carrySize);
+
+        free(carry);
+        carry = NULL;
+
+        size_t const readSize = fread(text + carrySize, 1, kParseChunkSize, pipeline->fp);
+        size_t const size = carrySize + readSize;
+        size_t lineEnd = size;
+        carrySize = 0;
+        if (readSize > 0)
+        {
+            while (lineEnd > 0 && text[lineEnd - 1] != '\n')
+                lineEnd--;
+
+            // A line longer than the chunk, keep reading
+            if (lineEnd == 0)
+            {
+                carry = text;
+                carrySize = size;
+                continue;
+            }
+
+            if (lineEnd < size)
+            {
+                carrySize = size - lineEnd;
+                carry = (char*)malloc(carrySize);
+                if (carry == NULL)
+                    carrySize = 0;
+                else
+                    memcpy(carry, text + lineEnd, carrySize);
+            }
+        }
+
+        if (lineEnd == 0)
+        {
+            free(text);
+            break;
+        }
+
+        text[lineEnd] = '\0';
+
+        ParseBatch* batch = new ParseBatch;
+        batch->index = index++;
+        batch->text = text;
+        batch->size = lineEnd;
+        batch->endReached = false;
+        pipeline->lines->Push(batch);
+
+        if (readSize == 0)
+            break;
+    }
+
+    free(carry);
+    for (int32 i = 0; i < pipeline->workerCount; i++)
+        pipeline->lines->Push(NULL);
+
+    return 0;
+}
+
+
+int32 Archiver::_parseWorker(void* arg)
+{
+    ParsePipeline* pipeline = reinterpret_cast<ParsePipeline*>(arg);
+
+    ParseBatch* batch;
+    while ((batch = pipeline->lines->Pop()) != NULL)
+    {
+        char* line = batch->text;
+        char* const textEnd = batch->text + batch->size;
+        while (line < textEnd)
+        {
+            char* lineEnd = (char*)memchr(line, '\n', textEnd - line);
+            if (lineEnd == NULL)
+                lineEnd = textEnd;
+
+            *lineEnd = '\0';
+            if (pipeline->endMarker != NULL && strstr(line, pipeline->endMarker) != NULL)
+            {
+                batch->endReached = true;
+                break;
+            }
+
+            // Add-ons parse into buffers sized for lines no longer than this
+            if ((size_t)(lineEnd - line) > kMaxParseLineLength)
+                line[kMaxParseLineLength] = '\0';
+
+            if (lineEnd > line)
+            {
+                ArchiveEntry* entry = pipeline->archiver->ParseOpenLine(line);
+                if (entry != NULL)
+                    batch->entries.AddItem(entry);
+            }
+
+            line = lineEnd + 1;
+        }
+
+        free(batch->text);
+        batch->text = NULL;
+        pipeline->parsed->Push(batch);
+    }
+
+    pipeline->parsed->Push(NULL);
+    return 0;
+}
+
+
 BList Archiver::HiddenColumns(BList const& /*columns*/) const
 {
     // By default return all columns as available (ie empty hidden list) columns for the archiver
@@ -587,6 +1098,22 @@ bool Archiver::CanAddFiles() const
 }
 
 
+bool Archiver::CanAddUnderPath() const
+{
+    // Tar, for example, can rename files while adding them (kArchiveSubPath in the file list), so
+    // files can be added into a folder inside the archive without first copying them to a temp dir
+    return false;
+}
+
+
+bool Archiver::CanAddStagedLinks() const
+{
+    // Files staged in the temp dir can be symbolic links to the originals when the archiver follows
+    // links on being told so (kStagedLinks in the file list), otherwise they are copied there
+    return false;
+}
+
+
 bool Archiver::CanReplaceFiles() const
 {
     // Tar, for example, can't replace existing files while adding new ones with the same name,
@@ -612,6 +1139,14 @@ bool Archiver::NeedsTempDirectory() const
 }
 
 
+bool Archiver::HasSolidBlocks() const
+{
+    // 7z, for example, packs many files into one solid block and has to rewrite all of it
+    // to delete any one of them; the UI warns about that before deleting
+    return false;
+}
+
+
 bool Archiver::SupportsFolderEntity() const
 {
     // An ugly thing we need to do for zip-because zip binary will not delete all files under
@@ -636,6 +1171,14 @@ BString Archiver::Password() const
 }
 
 
+void Archiver::SetEntriesMessenger(BMessenger const& messenger)
+{
+    // Entries listed by ReadOpenParallel() are announced here as they come in, so that the
+    // caller can show them while the rest are still being listed
+    m_entriesMessenger = messenger;
+}
+
+
 bool Archiver::SupportsPassword() const
 {
     return false;
@@ -694,6 +1237,7 @@ void Archiver::SetSettingsDirectoryPath(const char* path)
         free((char*)m_settingsDirectoryPath);
 
     m_settingsDirectoryPath = strdup(path);
+    LoadExtensionIcons();
 }
 
 
@@ -806,8 +1350,9 @@ void Archiver::MakeTime(struct tm* timeStruct, time_t* timeValue, const char* da
     timeStruct->tm_mon = numMonth;
     timeStruct->tm_year = numYear;
     timeStruct->tm_mday = atoi(day);
+    timeStruct->tm_isdst = -1;
 
-    *timeValue = mktime(timeStruct);
+    *timeValue = LocalTimeToTime(timeStruct);
 }
 
 
@@ -886,3 +1431,316 @@ int32 Archiver::GetDefaultCompressionLevel()
 {
     return m_defaultCompressionLevel;
 }
+
+
+float Archiver::SampleEntropy(BFile* file, off_t offset)
+{
+    uint8 buffer[kEntropyWindowSize];
+    ssize_t const bytesRead = file->ReadAt(offset, buffer, sizeof(buffer));
+    if (bytesRead <= 0)
+        return -1.0f;
+
+    uint32 counts[256];
+    memset(counts, 0, sizeof(counts));
+    for (ssize_t i = 0; i < bytesRead; i++)
+        counts[buffer[i]]++;
+
+    float entropy = 0.0f;
+    for (int32 i = 0; i < 256; i++)
+    {
+        if (counts[i] > 0)
+        {
+            float const p = (float)counts[i] / bytesRead;
+            entropy -= p * log2f(p);
+        }
+    }
+
+    return entropy;
+}
+
+
+static void SampleFiles(const char* path, int32& sampledCount, off_t& totalBytes, off_t& compressedBytes)
+{
+    BEntry entry(path);
+    struct stat st;
+    if (sampledCount >= kMaxSampledFiles || entry.GetStat(&st) != B_OK)
+        return;
+
+    if (S_ISDIR(st.st_mode))
+    {
+        BDirectory dir(&entry);
+        BEntry child;
+        BPath childPath;
+        while (sampledCount < kMaxSampledFiles && dir.GetNextEntry(&child) == B_OK)
+        {
+            if (child.GetPath(&childPath) == B_OK)
+                SampleFiles(childPath.Path(), sampledCount, totalBytes, compressedBytes);
+        }
+    }
+    else if (S_ISREG(st.st_mode) && st.st_size > 0)
+    {
+        // The start of a file is enough to tell media and archives from the rest
+        BFile file(&entry, B_READ_ONLY);
+        if (file.InitCheck() != B_OK)
+            return;
+
+        sampledCount++;
+        totalBytes += st.st_size;
+        if (Archiver::SampleEntropy(&file, 0) >= kCompressedEntropy)
+            compressedBytes += st.st_size;
+    }
+}
+
+
+int32 Archiver::ContentCompressionLevel(const char* relPath, BMessage* fileList, int32 fastLevel)
+{
+    int32 sampledCount = 0;
+    off_t totalBytes = 0;
+    off_t compressedBytes = 0;
+    const char* pathString;
+    for (int32 i = 0; fileList->FindString(kPath, i, &pathString) == B_OK; i++)
+    {
+        BString path;
+        if (relPath != NULL && pathString[0] != '/')
+            path << relPath << '/';
+        path << pathString;
+
+        SampleFiles(path.String(), sampledCount, totalBytes, compressedBytes);
+    }
+
+    // A strong level buys next to nothing on data that is mostly compressed already
+    if (totalBytes > 0 && compressedBytes >= totalBytes / 5 * 4)
+        return fastLevel;
+
+    return GetCompressionLevel();
+}
+
+
+int32 Archiver::ContentCompressionLevel(const char* path, int32 fastLevel)
+{
+    BFile file(path, B_READ_ONLY);
+    off_t size;
+    if (file.InitCheck() != B_OK || file.GetSize(&size) != B_OK || size <= 0)
+        return GetCompressionLevel();
+
+    // Windows spread over the whole file, most of them compressed means most of the data is
+    int32 windowCount = 0;
+    int32 compressedCount = 0;
+    off_t const lastOffset = max_c(size - (off_t)kEntropyWindowSize, 0);
+    for (int32 i = 0; i < kTarSampleWindows; i++)
+    {
+        float const entropy = SampleEntropy(&file, lastOffset * i / (kTarSampleWindows - 1));
+        if (entropy < 0)
+            break;
+
+        windowCount++;
+        if (entropy >= kCompressedEntropy)
+            compressedCount++;
+    }
+
+    if (windowCount > 0 && compressedCount >= windowCount * 4 / 5)
+        return fastLevel;
+
+    return GetCompressionLevel();
+}
+
+
+static void CollectDuplicateFiles(const char* path, BList& fileList)
+{
+    BEntry entry(path);
+    struct stat st;
+    if (entry.GetStat(&st) != B_OK)
+        return;
+
+    if (S_ISDIR(st.st_mode))
+    {
+        BDirectory dir(&entry);
+        BEntry child;
+        BPath childPath;
+        while (dir.GetNextEntry(&child) == B_OK)
+        {
+            if (child.GetPath(&childPath) == B_OK)
+                CollectDuplicateFiles(childPath.Path(), fileList);
+        }
+    }
+    else if (S_ISREG(st.st_mode) && st.st_size >= kMinDuplicateSize)
+    {
+        DuplicateFile* file = new DuplicateFile;
+        file->path = strdup(path);
+        file->size = st.st_size;
+        file->hash = 0;
+        file->hashed = false;
+        fileList.AddItem(file);
+    }
+}
+
+
+static int CompareDuplicateFiles(const void* a, const void* b)
+{
+    const DuplicateFile* fileA = *(const DuplicateFile**)a;
+    const DuplicateFile* fileB = *(const DuplicateFile**)b;
+    if (fileA->size != fileB->size)
+        return fileA->size < fileB->size ? -1 : 1;
+
+    if (fileA->hash != fileB->hash)
+        return fileA->hash < fileB->hash ? -1 : 1;
+
+    return 0;
+}
+
+
+static bool HashFileHead(DuplicateFile* file, uint8* buffer)
+{
+    BFile source(file->path, B_READ_ONLY);
+    if (source.InitCheck() != B_OK)
+        return false;
+
+    ssize_t const bytesRead = source.Read(buffer, kHashBufferSize);
+    if (bytesRead < 0)
+        return false;
+
+    // FNV-1a a word at a time, a collision only costs the comparison that follows anyway
+    uint64 hash = 0xcbf29ce484222325ULL;
+    ssize_t i = 0;
+    for (; i + 8 <= bytesRead; i += 8)
+    {
+        uint64 word;
+        memcpy(&word, buffer + i, sizeof(word));
+        hash = (hash ^ word) * 0x100000001b3ULL;
+    }
+
+    for (; i < bytesRead; i++)
+        hash = (hash ^ buffer[i]) * 0x100000001b3ULL;
+
+    file->hash = hash;
+    return true;
+}
+
+
+static bool SameContent(const DuplicateFile* fileA, const DuplicateFile* fileB, uint8* bufferA, uint8* bufferB)
+{
+    BFile sourceA(fileA->path, B_READ_ONLY);
+    BFile sourceB(fileB->path, B_READ_ONLY);
+    if (sourceA.InitCheck() != B_OK || sourceB.InitCheck() != B_OK)
+        return false;
+
+    for (;;)
+    {
+        ssize_t const bytesRead = sourceA.Read(bufferA, kHashBufferSize);
+        if (bytesRead < 0 || sourceB.Read(bufferB, kHashBufferSize) != bytesRead)
+            return false;
+
+        if (bytesRead == 0)
+            return true;
+
+        if (memcmp(bufferA, bufferB, bytesRead) != 0)
+            return false;
+    }
+}
+
+
+bool Archiver::HasDuplicates(const char* relPath, BMessage* fileList, volatile bool* cancel)
+{
+    BList allFiles;
+    const char* pathString;
+    for (int32 i = 0; fileList->FindString(kPath, i, &pathString) == B_OK; i++)
+    {
+        BString path;
+        if (relPath != NULL && pathString[0] != '/')
+            path << relPath << '/';
+        path << pathString;
+
+        CollectDuplicateFiles(path.String(), allFiles);
+    }
+
+    // A file can only repeat one of the same size, the others are never read
+    allFiles.SortItems(CompareDuplicateFiles);
+    BList files;
+    int32 const allCount = allFiles.CountItems();
+    for (int32 i = 0; i < allCount; i++)
+    {
+        DuplicateFile* file = (DuplicateFile*)allFiles.ItemAtFast(i);
+        if ((i > 0 && ((DuplicateFile*)allFiles.ItemAtFast(i - 1))->size == file->size)
+            || (i + 1 < allCount && ((DuplicateFile*)allFiles.ItemAtFast(i + 1))->size == file->size))
+            files.AddItem(file);
+    }
+
+    system_info sysInfo;
+    int32 workerCount = 1;
+    if (get_system_info(&sysInfo) == B_OK && sysInfo.cpu_count > 1)
+        workerCount = min_c((int32)sysInfo.cpu_count, kMaxHashWorkers);
+    workerCount = min_c(workerCount, files.CountItems());
+
+    HashJob job = { &files, 0, cancel };
+    thread_id workers[kMaxHashWorkers];
+    int32 spawnedCount = 0;
+    for (int32 i = 1; i < workerCount; i++)
+    {
+        thread_id tid = spawn_thread(_hashWorker, "_hash_worker", B_NORMAL_PRIORITY, (void*)&job);
+        if (tid < B_OK)
+            break;
+
+        workers[spawnedCount++] = tid;
+        resume_thread(tid);
+    }
+
+    _hashWorker(&job);
+    for (int32 i = 0; i < spawnedCount; i++)
+    {
+        status_t exitCode;
+        wait_for_thread(workers[i], &exitCode);
+    }
+
+    // Files with equal first blocks are compared in full against each earlier file of their run, as
+    // A and B may differ while B and C match; the first match settles it
+    files.SortItems(CompareDuplicateFiles);
+    bool found = false;
+    uint8* bufferA = new uint8[kHashBufferSize];
+    uint8* bufferB = new uint8[kHashBufferSize];
+    int32 runStart = 0;
+    for (int32 i = 0; i < files.CountItems() && found == false && *cancel == false; i++)
+    {
+        DuplicateFile* file = (DuplicateFile*)files.ItemAtFast(i);
+        DuplicateFile* runFirst = (DuplicateFile*)files.ItemAtFast(runStart);
+        if (CompareDuplicateFiles(&runFirst, &file) != 0)
+            runStart = i;
+
+        if (file->hashed == false)
+            continue;
+
+        for (int32 j = runStart; j < i && found == false && *cancel == false; j++)
+        {
+            DuplicateFile* earlier = (DuplicateFile*)files.ItemAtFast(j);
+            if (earlier->hashed == true)
+                found = SameContent(earlier, file, bufferA, bufferB);
+        }
+    }
+
+    delete[] bufferA;
+    delete[] bufferB;
+    for (int32 i = 0; i < allCount; i++)
+    {
+        DuplicateFile* file = (DuplicateFile*)allFiles.ItemAtFast(i);
+        free(file->path);
+        delete file;
+    }
+
+    return found == true && *cancel == false;
+}
+
+
+int32 Archiver::_hashWorker(void* arg)
+{
+    HashJob* job = (HashJob*)arg;
+    uint8* buffer = new uint8[kHashBufferSize];
+    int32 const count = job->files->CountItems();
+    for (int32 i = atomic_add(&job->nextFile, 1); i < count && *job->cancel == false;
+         i = atomic_add(&job->nextFile, 1))
+    {
+        DuplicateFile* file = (DuplicateFile*)job->files->ItemAtFast(i);
+        file->hashed = HashFileHead(file, buffer);
+    }
+
+    delete[] buffer;
+    return 0;
+}
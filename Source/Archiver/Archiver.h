@@ -21,16 +21,21 @@
 
 #include <Entry.h>
 #include <List.h>
+#include <Locker.h>
 #include <Message.h>
+#include <Messenger.h>
 #include <Path.h>
 #include <String.h>
 
 #include <cstdio>
 
+class ArchiveEntry;
 class HashTable;
 class HashEntry;
 
 class BBitmap;
+class BDateTimeFormat;
+class BFile;
 class BMenu;
 
 
@@ -40,6 +45,9 @@ class BMenu;
 static const char* const kCompressionLevelKey = "bzr:CompressionLevel";
 #pragma GCC diagnostic pop
 
+// Bits per byte at and above which sampled data is taken to be compressed already (media, archives)
+const float kCompressedEntropy = 7.5f;
+
 
 class Archiver
 {
@@ -64,6 +72,7 @@ class Archiver
         const char*         ArchiveExtension() const;
         void                GetLists(BList*& fileList, BList*& folderList) const;
         void                FillLists(BList* fileList = NULL, BList* dirList = NULL);
+        BBitmap*            BitmapForExtension(const char* str) const;
         BMenu*              SettingsMenu() const;
         void                SaveSettingsMenu();
         void                LoadSettingsMenu();
@@ -71,6 +80,7 @@ class Archiver
         const char*         TempDirectoryPath() const;
         void                SetPassword(const char* password);
         BString             Password() const;
+        void                SetEntriesMessenger(BMessenger const& messenger);
 
         // Optionally-overridable functions
         virtual status_t    ArchiveSettings(BMessage& message);
@@ -85,16 +95,21 @@ class Archiver
         virtual bool        CanDeleteFiles() const;
         virtual bool        CanAddEmptyFolders() const;
         virtual bool        CanAddFiles() const;
+        virtual bool        CanAddUnderPath() const;
+        virtual bool        CanAddStagedLinks() const;
         virtual bool        SupportsPassword() const;
         virtual bool        PasswordRequired() const;
         virtual bool        NeedsTempDirectory() const;
+        virtual bool        HasSolidBlocks() const;
         virtual status_t    GetComment(char*& commentStr);
         virtual status_t    SetComment(char* commentStr, const char* tempDirPath);
 
         // Helper functions
         virtual status_t    ReadErrStream(FILE* fp, const char* escapeLine = NULL);
         virtual void        ReadStream(FILE* fp, BString& str) const;
+        status_t            ReadErrString(BString const& errorString, const char* escapeLine = NULL);
         bool                GetBinaryPath(char* destPath, const char* binaryFileName) const;
+        static float        SampleEntropy(BFile* file, off_t offset);
 
         // Abstract functions
         virtual status_t    Open(entry_ref* ref, BMessage* fileList = NULL) = 0;
@@ -114,11 +129,26 @@ class Archiver
 
     protected:
         void                TerminateThread(thread_id tid) const;
-        void                FormatDate(char* dateStr, size_t bufSize, struct tm* timeStruct);
         void                MakeTime(struct tm* timeStruct, time_t* timeValue, const char* day, const char* month,
                                      const char* year, const char* hour, const char* min, const char* sec);
         time_t              ArchiveModificationTime() const;
 
+        // Reads a helper program's listing in large chunks on one thread, hands batches of lines
+        // to ParseOpenLine() on several others and adds the entries in listing order, sending
+        // BZR_ENTRIES_READY to the entries messenger as they come. Nothing from the first line
+        // containing 'endMarker' onwards is parsed
+        status_t            ReadOpenParallel(FILE* fp, const char* endMarker = NULL);
+        virtual ArchiveEntry* ParseOpenLine(char* line);
+
+        // The chosen compression level, or 'fastLevel' when most of the files (or a tar) sample as compressed
+        int32               ContentCompressionLevel(const char* relPath, BMessage* fileList, int32 fastLevel);
+        int32               ContentCompressionLevel(const char* path, int32 fastLevel);
+
+        // Whether a file of 'fileList' repeats the content of another file there. Only files whose size
+        // matches another's are read: their first blocks are hashed on several threads and matching
+        // ones compared in full until one pair turns out the same
+        bool                HasDuplicates(const char* relPath, BMessage* fileList, volatile bool* cancel);
+
         const char*         m_typeStr,
                            *m_extensionStr,
                            *m_settingsLangStr,
@@ -137,11 +167,15 @@ class Archiver
 
     private:
         void                Init();
+        static int32        _parseReader(void* arg);
+        static int32        _parseWorker(void* arg);
+        static int32        _hashWorker(void* arg);
         static int          CompareHashEntries(const void* a, const void* b);
         void                AddDirPathToTable(BList* dirList, const char* path);
         HashEntry*          AddFilePathToTable(BList* fileList, const char* path);
         void                ResetCache();
-        BBitmap*            BitmapForExtension(const char* str) const;
+        void                LoadExtensionIcons();
+        void                ClearExtensionIcons();
 
         BMessage*           m_metaDataMsg;
         HashTable*          m_hashTable;
@@ -149,6 +183,7 @@ class Archiver
         const char*         m_cachedPath;
         BList               m_fileList,
                             m_folderList,
+                            m_extensionIcons,
                            *m_iconList;
         BBitmap*            m_folderBmp,
                            *m_binaryBmp,
@@ -160,8 +195,12 @@ class Archiver
                            *m_packageBmp,
                            *m_pdfBmp,
                            *m_imageBmp;
+        BDateTimeFormat*    m_dateFormat;
         int8                m_foldingLevel;
         int32               m_defaultCompressionLevel;
+        BMessenger          m_entriesMessenger;
+        BLocker             m_entriesLock;
+        int32 volatile      m_entriesPending;
 };
 
 extern "C" _BZR_IMPEXP Archiver* load_archiver(BMessage* metaDataMsg);
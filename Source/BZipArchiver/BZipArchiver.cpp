@@ -6,6 +6,7 @@
 #include "BZipArchiver.h"
 #include "ArchiveEntry.h"
 #include "AppUtils.h"
+#include "KeyedMenuItem.h"
 
 #include <NodeInfo.h>
 #include <Messenger.h>
@@ -18,9 +19,15 @@
 #define B_TRANSLATION_CONTEXT "BZipArchiver"
 #else
 #define B_TRANSLATE(x) x
+#define B_TRANSLATE_MARK(x) x
+#define B_TRANSLATE_NOCOLLECT(x) x
 #endif
 
 
+static const char
+    *kAutoLevel        = B_TRANSLATE_MARK("Use fastest level for already compressed data");
+
+
 Archiver* load_archiver(BMessage* metaDataMsg)
 {
     return new BZipArchiver(metaDataMsg);
@@ -39,6 +46,10 @@ BZipArchiver::BZipArchiver(BMessage* metaDataMsg)
         m_error = BZR_BINARY_MISSING;
         return;
     }
+
+    // Optional, compresses on all cores when present
+    if (GetBinaryPath(m_lbzipPath, "lbzip2") == false)
+        m_lbzipPath[0] = '\0';
 }
 
 
@@ -47,15 +58,8 @@ status_t BZipArchiver::Open(entry_ref* ref, BMessage* fileList)
     m_archiveRef = *ref;
     m_archivePath.SetTo(ref);
 
-    // We are redirecting (>) shell output to file, therefore we need to use /bin/sh -c <command>
     BString destPath = InitTarFilePath(ref->name);
-    BString cmd;
-    cmd << "\"" << m_bzipPath << "\"" << " -c -d \"" << m_archivePath.Path() << "\" > " << "\"" <<
-    m_tarFilePath << "\"";
-
-    m_pipeMgr.FlushArgs();
-    m_pipeMgr << "/bin/sh" << "-c" << cmd.String();
-    m_pipeMgr.Pipe();
+    DecompressToTemp();
 
     if (TarArchiver::IsTarArchive(destPath.String()))
     {
@@ -124,6 +128,9 @@ status_t BZipArchiver::Extract(entry_ref* refToDir, BMessage* message, BMessenge
     }
     else
     {
+        if (BEntry(m_tarFilePath).Exists() == false)
+            DecompressToTemp();
+
         m_archivePath = m_tarFilePath;
         status_t exitCode = TarArchiver::Extract(refToDir, message, progress, cancel);
         m_archivePath = m_arkFilePath;
@@ -184,6 +191,9 @@ status_t BZipArchiver::Add(bool createMode, const char* relativePath, BMessage*
 {
     if (m_tarArk == true)
     {
+        if (BEntry(m_tarFilePath).Exists() == false)
+            DecompressToTemp();
+
         m_archivePath = m_tarFilePath;
         status_t exitCode = TarArchiver::Add(createMode, relativePath, message, addedPaths, progress, cancel);
         m_archivePath = m_arkFilePath;
@@ -201,6 +211,9 @@ status_t BZipArchiver::Delete(char*& outputStr, BMessage* message, BMessenger* p
 {
     if (m_tarArk == true)
     {
+        if (BEntry(m_tarFilePath).Exists() == false)
+            DecompressToTemp();
+
         m_archivePath = m_tarFilePath;
         status_t exitCode = TarArchiver::Delete(outputStr, message, progress, cancel);
         m_archivePath = m_arkFilePath;
@@ -225,7 +238,14 @@ status_t BZipArchiver::Create(BPath* archivePath, const char* relPath, BMessage*
     strcpy(m_arkFilePath, m_archivePath.Path());
     InitTarFilePath((char*)archivePath->Leaf());
 
-    status_t result = Add(true, relPath, fileList, addedPaths, progress, cancel);
+    // tar is piped straight into the compressor, the tar in temp is only unpacked again if needed later
+    BEntry(m_tarFilePath).Remove();
+    int32 level = GetCompressionLevel();
+    if (m_settingsMenu->FindItem(B_TRANSLATE_NOCOLLECT(kAutoLevel))->IsMarked() == true)
+        level = ContentCompressionLevel(relPath, fileList, 1);
+
+    status_t result = CreateCompressed(CompressProgram(level).String(), relPath, fileList, addedPaths, progress,
+                                       cancel);
 
     // Once creating is done, set m_archiveRef to pointed to the existing archive file
     if (result == BZR_DONE)
@@ -273,6 +293,8 @@ void BZipArchiver::BuildMenu(BMessage& message)
 
     // Add sub-menus to settings menu
     m_settingsMenu->AddItem(m_compressionMenu);
+    m_settingsMenu->AddItem(new KeyedMenuItem("bzr:AutoLevel", B_TRANSLATE_NOCOLLECT(kAutoLevel),
+                                              message, false, new BMessage(BZR_MENUITEM_SELECTED)));
 }
 
 
@@ -325,14 +347,35 @@ BList BZipArchiver::HiddenColumns(BList const& columns) const
 
 void BZipArchiver::CompressFromTemp()
 {
-    // Get the compression ratio from the settings menu
-    BString levelStr;
-    levelStr.SetToFormat(" -%d ", GetCompressionLevel());
-
     // Re-compress file, from .tar in temp to gzip
+    int32 level = GetCompressionLevel();
+    if (m_settingsMenu->FindItem(B_TRANSLATE_NOCOLLECT(kAutoLevel))->IsMarked() == true)
+        level = ContentCompressionLevel(m_tarFilePath, 1);
+
     BString cmd;
-    cmd << "\"" << m_bzipPath << "\"" << " -c " << levelStr << "\"" << m_tarFilePath << "\" > " << "\"" <<
-    m_archivePath.Path() << "\"";
+    cmd << CompressProgram(level) << " -c \"" << m_tarFilePath << "\" > \"" << m_archivePath.Path() << "\"";
+
+    m_pipeMgr.FlushArgs();
+    m_pipeMgr << "/bin/sh" << "-c" << cmd.String();
+    m_pipeMgr.Pipe();
+}
+
+
+BString BZipArchiver::CompressProgram(int32 level)
+{
+    // lbzip2 compresses on all cores and writes plain bzip2 streams
+    BString program;
+    program.SetToFormat("\"%s\" -%d", m_lbzipPath[0] != '\0' ? m_lbzipPath : m_bzipPath, level);
+    return program;
+}
+
+
+void BZipArchiver::DecompressToTemp()
+{
+    // We are redirecting (>) shell output to file, therefore we need to use /bin/sh -c <command>
+    BString cmd;
+    cmd << "\"" << m_bzipPath << "\"" << " -c -d \"" << m_archivePath.Path() << "\" > " << "\"" <<
+    m_tarFilePath << "\"";
 
     m_pipeMgr.FlushArgs();
     m_pipeMgr << "/bin/sh" << "-c" << cmd.String();
@@ -38,10 +38,13 @@ class BZipArchiver : public TarArchiver
         status_t           ReadDelete(FILE* fp, char*& outputStr,    BMessenger* progress, volatile bool* cancel);
 
         void               CompressFromTemp();
+        BString            CompressProgram(int32 level);
+        void               DecompressToTemp();
         BString            InitTarFilePath(char* fileName);
         void               SendProgressMessage(BMessenger* progress) const;
 
         char               m_bzipPath[B_PATH_NAME_LENGTH];
+        char               m_lbzipPath[B_PATH_NAME_LENGTH];
         char               m_tarFilePath[B_PATH_NAME_LENGTH];
         char               m_arkFilePath[B_PATH_NAME_LENGTH];
         bool               m_tarArk;
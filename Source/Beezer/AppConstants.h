@@ -39,6 +39,8 @@
 #define K_SETTINGS_INTERFACE                 "interface_settings"
 #define K_SETTINGS_RECENT_SPLIT_FILES         "recent_split_files"
 #define K_SETTINGS_RECENT_SPLIT_DIRS          "recent_split_folders"
+#define K_SETTINGS_FILE_ICONS                "file_icons"
+#define K_SETTINGS_ADDON_INDEX               "addons_index"
 
 #define K_UI_ATTRIBUTE                       "bzr:ui"
 #define K_ARK_ATTRIBUTE                      "bzr:ark"
@@ -8,9 +8,11 @@
 #include "ArchiverMgr.h"
 #include "BeezerApp.h"
 #include "BitmapPool.h"
+#include "FormatSniffer.h"
 #include "FSUtils.h"
 #include "MsgConstants.h"
 
+#include <Autolock.h>
 #include <NodeInfo.h>
 #include <Window.h>
 
@@ -67,10 +69,17 @@ status_t ArchiveRep::InitArchiver(entry_ref* ref, char* mimeString)
 
         if (!mimeString)
         {
-            update_mime_info(m_archivePath.Path(), false, true, false);
-            BNode node(&m_archiveEntry);
-            BNodeInfo nodeInfo(&node);
-            nodeInfo.GetType(type);
+            // Identify well known formats by their content, anything else is left to the registrar
+            const char* sniffedType = SniffArchiveType(m_archivePath.Path());
+            if (sniffedType != NULL)
+                strcpy(type, sniffedType);
+            else
+            {
+                update_mime_info(m_archivePath.Path(), false, true, false);
+                BNode node(&m_archiveEntry);
+                BNodeInfo nodeInfo(&node);
+                nodeInfo.GetType(type);
+            }
         }
         else
             strcpy(type, mimeString);
@@ -86,8 +95,9 @@ status_t ArchiveRep::InitArchiver(entry_ref* ref, char* mimeString)
     if (m_archiver == NULL)        // Archiver not found for type
         return errCode;
 
+    // Add-ons report BZR_DONE on success, missing optional binaries are not fatal either
     errCode = m_archiver->InitCheck();
-    if (errCode != B_OK)
+    if (errCode != BZR_DONE && errCode != BZR_OPTIONAL_BINARY_MISSING)
         return errCode;
 
     if (m_archiver)
@@ -206,7 +216,13 @@ int32 ArchiveRep::_opener(void* arg)
     msg->FindPointer(kArchiverPtr, reinterpret_cast<void**>(&ark));
     msg->FindRef(kRef, &ref);
 
-    status_t const result = ark->Open(&ref);
+    // Listing may chdir() before spawning the archiver binary, the batch extractor and compare
+    // windows list under the same lock
+    status_t result;
+    {
+        BAutolock autoLocker(_ark_locker);
+        result = ark->Open(&ref);
+    }
     delete msg;
 
     BMessage backMessage(M_OPEN_PART_TWO);
@@ -6,14 +6,16 @@
 #include "ArchiverMgr.h"
 #include "AppConstants.h"
 #include "Archiver.h"
-#include "BeezerApp.h"
 #include "CommonStrings.h"
 #include "MsgConstants.h"
 #include "RuleMgr.h"
 
 #include <Alert.h>
 #include <Autolock.h>
+#include <Directory.h>
+#include <File.h>
 #include <MenuItem.h>
+#include <Path.h>
 #include <PopUpMenu.h>
 #include <Resources.h>
 
@@ -30,48 +32,64 @@
 
 BLocker _ark_locker("_ark_mgr_lock", true);
 
-
-ArchiverMgr* _archiverMgr()
-{
-    return (dynamic_cast<BeezerApp*>(be_app))->GetArchiverMgr();
-}
+static const int32 kAddOnIndexVersion = 1;
 
 
-ArchiverMgr::ArchiverMgr()
+ArchiverMgr::ArchiverMgr(BDirectory* archiversDir, BDirectory* settingsDir)
     :
     m_fullMetaDataMsg(new BMessage()),
-    m_ruleMgr(new RuleMgr(&(_bzr()->m_settingsDir), K_RULE_FILE))
+    m_mimeArchivers(new BMessage()),
+    m_addOnImages(new BMessage()),
+    m_ruleMgr(new RuleMgr(settingsDir, K_RULE_FILE))
 {
     // Load resource metadata from all of the add-ons and store it in global
 
-    // Operate in a critical section as we access global data like BDirectory of be_app
+    // Operate in a critical section as we access the caller's BDirectory
     BAutolock autoLocker(_ark_locker);
     if (autoLocker.IsLocked() == false)
         return;
 
-    // Get the Archiver dir and the path of the Binaries dir (both from _bzr())
-    BDirectory* archiversDir = &(_bzr()->m_addonsDir);
+    // Opening every add-on's resources is what makes startup slow, so the metadata is kept in an
+    // index in the settings folder and only gathered again when an add-on is added, removed or changed
+    BMessage stampsMsg;
     archiversDir->Rewind();
 
     BEntry entry;
     while (archiversDir->GetNextEntry(&entry, true) == B_OK)
     {
         BPath path;
-        entry.GetPath(&path);
-        BResources res(path.Path());
-        if (res.InitCheck() != B_OK)
+        struct stat st;
+        if (entry.GetPath(&path) != B_OK || entry.GetStat(&st) != B_OK)
             continue;
 
-        size_t dataSize;
-        const void* resData = res.LoadResource(B_MESSAGE_TYPE, "ArchiverMetaData", &dataSize);
-        if (resData == NULL)
-            continue;
+        stampsMsg.AddInt64(path.Path(), st.st_mtime);
+        stampsMsg.AddInt64(path.Path(), st.st_size);
+    }
 
-        BMessage resMsg;
-        if (resMsg.Unflatten((const char*)resData) != B_OK)
-            continue;
+    if (ReadAddOnIndex(settingsDir, stampsMsg) != B_OK)
+    {
+        m_fullMetaDataMsg->MakeEmpty();
+
+        char* addOnPath;
+        for (int32 i = 0; stampsMsg.GetInfo(B_INT64_TYPE, i, &addOnPath, NULL) == B_OK; i++)
+        {
+            BResources res(addOnPath);
+            if (res.InitCheck() != B_OK)
+                continue;
+
+            size_t dataSize;
+            const void* resData = res.LoadResource(B_MESSAGE_TYPE, "ArchiverMetaData", &dataSize);
+            if (resData == NULL)
+                continue;
+
+            BMessage resMsg;
+            if (resMsg.Unflatten((const char*)resData) != B_OK)
+                continue;
+
+            m_fullMetaDataMsg->AddMessage(addOnPath, &resMsg);
+        }
 
-        m_fullMetaDataMsg->AddMessage(path.Path(), &resMsg);
+        WriteAddOnIndex(settingsDir, stampsMsg);
     }
 
     MergeArchiverRules();
@@ -81,10 +99,60 @@ ArchiverMgr::ArchiverMgr()
 ArchiverMgr::~ArchiverMgr()
 {
     delete m_fullMetaDataMsg;
+    delete m_mimeArchivers;
+    delete m_addOnImages;
     delete m_ruleMgr;
 }
 
 
+status_t ArchiverMgr::ReadAddOnIndex(BDirectory* settingsDir, const BMessage& stampsMsg)
+{
+    BFile indexFile(settingsDir, K_SETTINGS_ADDON_INDEX, B_READ_ONLY);
+    BMessage indexMsg;
+    status_t result = indexFile.InitCheck();
+    if (result == B_OK)
+        result = indexMsg.Unflatten(&indexFile);
+
+    if (result != B_OK)
+        return result;
+
+    // The index is only good if it was written for exactly the add-ons we have now
+    int32 version;
+    BMessage indexStampsMsg;
+    if (indexMsg.FindInt32("version", &version) != B_OK || version != kAddOnIndexVersion
+            || indexMsg.FindMessage("stamps", &indexStampsMsg) != B_OK
+            || indexStampsMsg.CountNames(B_INT64_TYPE) != stampsMsg.CountNames(B_INT64_TYPE))
+        return B_BAD_DATA;
+
+    char* addOnPath;
+    for (int32 i = 0; stampsMsg.GetInfo(B_INT64_TYPE, i, &addOnPath, NULL) == B_OK; i++)
+    {
+        // Modification time and size
+        for (int32 stamp = 0; stamp < 2; stamp++)
+            if (indexStampsMsg.GetInt64(addOnPath, stamp, -1) != stampsMsg.GetInt64(addOnPath, stamp, 0))
+                return B_BAD_DATA;
+    }
+
+    return indexMsg.FindMessage("metadata", m_fullMetaDataMsg);
+}
+
+
+status_t ArchiverMgr::WriteAddOnIndex(BDirectory* settingsDir, const BMessage& stampsMsg) const
+{
+    BMessage indexMsg;
+    indexMsg.AddInt32("version", kAddOnIndexVersion);
+    indexMsg.AddMessage("stamps", &stampsMsg);
+    indexMsg.AddMessage("metadata", m_fullMetaDataMsg);
+
+    BFile indexFile(settingsDir, K_SETTINGS_ADDON_INDEX, B_WRITE_ONLY | B_CREATE_FILE | B_ERASE_FILE);
+    status_t result = indexFile.InitCheck();
+    if (result == B_OK)
+        result = indexMsg.Flatten(&indexFile);
+
+    return result;
+}
+
+
 Archiver* ArchiverMgr::InstantiateArchiver(const char* path)
 {
     BMessage metaDataMsg;
@@ -92,9 +160,19 @@ Archiver* ArchiverMgr::InstantiateArchiver(const char* path)
     if (m_fullMetaDataMsg->FindMessage(path, &metaDataMsg) != B_OK)
         return NULL;
 
-    image_id addonID = load_add_on(path);
-    if (addonID <= 0L)
-        return NULL;
+    // Each add-on is loaded the first time its format is needed and then shared by every window
+    image_id addonID;
+    {
+        BAutolock autoLocker(_ark_locker);
+        if (m_addOnImages->FindInt32(path, &addonID) != B_OK)
+        {
+            addonID = load_add_on(path);
+            if (addonID <= 0L)
+                return NULL;
+
+            m_addOnImages->AddInt32(path, addonID);
+        }
+    }
 
     // Archiver loaded successfully
     Archiver *(*load_archiver)(BMessage*);
@@ -107,30 +185,12 @@ Archiver* ArchiverMgr::InstantiateArchiver(const char* path)
 
 Archiver* ArchiverMgr::ArchiverForMime(const char* mimeType)
 {
-    // Finds an archiver given its mime type
-    if (m_fullMetaDataMsg == NULL)
+    // Finds an archiver given its mime type, MergeArchiverRules() maps the types to the add-ons
+    const char* arkPath;
+    if (m_mimeArchivers->FindString(mimeType, &arkPath) != B_OK)
         return NULL;
 
-    char* arkPath;
-    for (int32 msgIdx = 0; m_fullMetaDataMsg->GetInfo(B_MESSAGE_TYPE, msgIdx, &arkPath, NULL) == B_OK; msgIdx++)
-    {
-        BMessage arkMsg;
-        if (m_fullMetaDataMsg->FindMessage(arkPath, &arkMsg) != B_OK)
-            continue;
-
-        BMessage typesMsg;
-        if (arkMsg.FindMessage("FileTypes", &typesMsg) != B_OK)
-            continue;
-
-        char* foundMimeType;
-        for (int32 mimeIdx = 0; typesMsg.GetInfo(B_MESSAGE_TYPE, mimeIdx, &foundMimeType, NULL) == B_OK; mimeIdx++)
-        {
-            if (strcmp(mimeType, foundMimeType) == 0)
-                return InstantiateArchiver(arkPath);
-        }
-    }
-
-    return NULL;
+    return InstantiateArchiver(arkPath);
 }
 
 
@@ -207,6 +267,10 @@ status_t ArchiverMgr::MergeArchiverRules()
         // iterate our loaded mime rules and add them to the rule manager
         for (int32 idx = 0; fileTypesMsg.GetInfo(B_MESSAGE_TYPE, idx, &mimeType, NULL) == B_OK; idx++)
         {
+            // The first add-on to claim a type handles it
+            if (m_mimeArchivers->HasString(mimeType) == false)
+                m_mimeArchivers->AddString(mimeType, arkPath);
+
             BMessage mimeMsg;
             fileTypesMsg.FindMessage(mimeType, &mimeMsg);
             const char* extension = NULL;
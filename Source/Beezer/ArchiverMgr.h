@@ -8,6 +8,7 @@
 
 #include <SupportDefs.h>
 
+class BDirectory;
 class BHandler;
 class BList;
 class BLocker;
@@ -25,7 +26,7 @@ extern BLocker _ark_locker;
 class ArchiverMgr
 {
     public:
-                        ArchiverMgr();
+                        ArchiverMgr(BDirectory* archiversDir, BDirectory* settingsDir);
                         ~ArchiverMgr();
 
         Archiver*       ArchiverForMime(const char* mimeType);
@@ -38,8 +39,12 @@ class ArchiverMgr
 
     private:
         status_t        MergeArchiverRules();
+        status_t        ReadAddOnIndex(BDirectory* settingsDir, const BMessage& stampsMsg);
+        status_t        WriteAddOnIndex(BDirectory* settingsDir, const BMessage& stampsMsg) const;
 
         BMessage*       m_fullMetaDataMsg;
+        BMessage*       m_mimeArchivers;
+        BMessage*       m_addOnImages;
         RuleMgr*        m_ruleMgr;
 
 };
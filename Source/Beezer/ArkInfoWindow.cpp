@@ -28,6 +28,8 @@
 #include <String.h>
 #include <StringView.h>
 
+#include <cstring>
+
 #ifdef HAIKU_ENABLE_I18N
 #include <Catalog.h>
 
@@ -109,6 +111,13 @@ ArkInfoWindow::ArkInfoWindow(BWindow* callerWindow, Archiver* archiver, BEntry*
     m_totalCountStr = new BStringView("ArkInfoWindow:TotalCountStr", "0");
     m_totalCountStr->SetExplicitMaxSize(BSize(B_SIZE_UNLIMITED, B_SIZE_UNSET));
 
+    BStringView* duplicateStr = new BStringView("ArkInfoWindow:_DuplicateStr", B_TRANSLATE("Duplicate files:"));
+    duplicateStr->SetAlignment(B_ALIGN_RIGHT);
+    duplicateStr->SetExplicitMaxSize(BSize(B_SIZE_UNLIMITED, B_SIZE_UNSET));
+
+    m_duplicateStr = new BStringView("ArkInfoWindow:DuplicateStr", "-");
+    m_duplicateStr->SetExplicitMaxSize(BSize(B_SIZE_UNLIMITED, B_SIZE_UNSET));
+
     // Other file infos like path, type, created, modified etc.
     BStringView* typeStr = new BStringView("ArkInfoWindow:_TypeStr", B_TRANSLATE("Type:"));
     typeStr->SetAlignment(B_ALIGN_RIGHT);
@@ -160,6 +169,8 @@ ArkInfoWindow::ArkInfoWindow(BWindow* callerWindow, Archiver* archiver, BEntry*
                   .Add(m_folderCountStr, 1, 3)
                   .Add(totalCountStr, 0, 4)
                   .Add(m_totalCountStr, 1, 4)
+                  .Add(duplicateStr, 0, 5)
+                  .Add(m_duplicateStr, 1, 5)
                   .SetColumnWeight(0, 0)
                  )
              .AddStrut(10)
@@ -299,4 +310,60 @@ void ArkInfoWindow::FillDetails()
 
 
     m_compressRatioBar->Update(ratio, NULL, buf);
+
+    FillDuplicates();
+}
+
+
+static int CompareContents(const void* a, const void* b)
+{
+    ListEntry* itemA = *(ListEntry**)a;
+    ListEntry* itemB = *(ListEntry**)b;
+    if (itemA->m_length != itemB->m_length)
+        return itemA->m_length < itemB->m_length ? -1 : 1;
+
+    return strcmp(itemA->GetColumnContentText(9), itemB->GetColumnContentText(9));
+}
+
+
+void ArkInfoWindow::FillDuplicates()
+{
+    // Files are told apart by the size and CRC the archiver listed, formats without CRCs can't be told
+    BList items;
+    int32 count = m_fileList->CountItems();
+    for (int32 i = 0; i < count; i++)
+    {
+        ListEntry* item = ((HashEntry*)m_fileList->ItemAtFast(i))->m_clvItem;
+        if (item == NULL || item->m_length == 0)
+            continue;
+
+        const char* crc = item->GetColumnContentText(9);
+        if (crc != NULL && crc[0] != '\0')
+            items.AddItem(item);
+    }
+
+    if (items.IsEmpty())
+        return;
+
+    items.SortItems(CompareContents);
+    int32 duplicateCount = 0;
+    off_t duplicateSize = 0;
+    for (int32 i = 1; i < items.CountItems(); i++)
+    {
+        ListEntry* previous = (ListEntry*)items.ItemAtFast(i - 1);
+        ListEntry* item = (ListEntry*)items.ItemAtFast(i);
+        if (CompareContents(&previous, &item) == 0)
+        {
+            duplicateCount++;
+            duplicateSize += item->m_length;
+        }
+    }
+
+    BString buf;
+    if (BNumberFormat().Format(buf, duplicateCount) != B_OK)
+        buf = "???";
+    if (duplicateCount > 0)
+        buf << " (" << StringFromBytes(duplicateSize) << ")";
+
+    m_duplicateStr->SetText(buf);
 }
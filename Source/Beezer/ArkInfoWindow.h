@@ -26,6 +26,7 @@ class ArkInfoWindow : public BWindow
 
     private:
         void                FillDetails();
+        void                FillDuplicates();
 
         Archiver*           m_archiver;
 
@@ -40,6 +41,7 @@ class ArkInfoWindow : public BWindow
                             *m_fileCountStr,
                             *m_folderCountStr,
                             *m_totalCountStr,
+                            *m_duplicateStr,
                             *m_typeStr,
                             *m_pathStr,
                             *m_createdStr,
@@ -0,0 +1,267 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2002 Ramshankar (aka Teknomancer).
+// All rights reserved.
+
+#include "BatchExtractWindow.h"
+#include "AppConstants.h"
+#include "BatchExtractor.h"
+#include "CommonStrings.h"
+#include "MsgConstants.h"
+#include "Shared.h"
+#include "UIConstants.h"
+
+#include <Button.h>
+#include <GroupLayoutBuilder.h>
+#include <Messenger.h>
+#include <ScrollView.h>
+#include <StatusBar.h>
+#include <String.h>
+#include <StringView.h>
+#include <TextView.h>
+
+#ifdef HAIKU_ENABLE_I18N
+#include <Catalog.h>
+
+#undef B_TRANSLATION_CONTEXT
+#define B_TRANSLATION_CONTEXT "BatchExtractWindow"
+#else
+#define B_TRANSLATE(x) x
+#endif
+
+
+// Progress bar for one worker slot, the archiver talks to it directly (synchronously)
+class BatchSlotBar : public BStatusBar
+{
+    public:
+        BatchSlotBar(const char* name)
+            : BStatusBar(name, NULL, NULL),
+              m_fileCount(0),
+              m_progressCount(0)
+        {
+            SetBarHeight(K_PROGRESSBAR_HEIGHT);
+            SetBarColor(K_PROGRESS_COLOR);
+        }
+
+        virtual void MessageReceived(BMessage* message)
+        {
+            switch (message->what)
+            {
+                case M_BATCH_SLOT_RESET:
+                {
+                    m_fileCount = message->FindInt32(kCount);
+                    m_progressCount = 0;
+                    Reset(message->FindString(kText));
+                    SetMaxValue(m_fileCount > 0 ? m_fileCount : 1);
+                    break;
+                }
+
+                case BZR_UPDATE_PROGRESS:
+                {
+                    BString fileCountUpdateStr;
+                    fileCountUpdateStr.SetToFormat("%d of %d", ++m_progressCount, m_fileCount);
+
+                    const char* mainText;
+                    if (message->FindString("text", &mainText) != B_OK)
+                        mainText = "";
+
+                    Update(1.0, mainText, fileCountUpdateStr);
+                    message->SendReply('repl');
+                    break;
+                }
+
+                default:
+                    BStatusBar::MessageReceived(message);
+                    break;
+            }
+        }
+
+    private:
+        int32               m_fileCount,
+                            m_progressCount;
+};
+
+
+BatchExtractWindow::BatchExtractWindow(BatchExtractor* extractor)
+    : BWindow(BRect(0, 0, 420, 0), B_TRANSLATE("Batch extract"), B_TITLED_WINDOW_LOOK, B_NORMAL_WINDOW_FEEL,
+              B_ASYNCHRONOUS_CONTROLS | B_NOT_ZOOMABLE | B_AUTO_UPDATE_SIZE_LIMITS),
+    m_extractor(extractor),
+    m_doneCount(0),
+    m_failedCount(0),
+    m_finished(false),
+    m_quitPending(false)
+{
+    SetLayout(new BGroupLayout(B_VERTICAL, 0));
+
+    int32 const jobCount = m_extractor->CountJobs();
+    int32 const slotCount = m_extractor->CountWorkers();
+
+    BStringView* strView = new BStringView("BatchExtractWindow:StringView", B_TRANSLATE("Extracting archives" B_UTF8_ELLIPSIS));
+    strView->SetFont(be_bold_font);
+    strView->SetHighColor(K_STARTUP_MAIN_HEADING);
+
+    m_totalBar = new BStatusBar("BatchExtractWindow:TotalBar", NULL, NULL);
+    m_totalBar->SetBarHeight(K_PROGRESSBAR_HEIGHT);
+    m_totalBar->SetBarColor(K_PROGRESS_COLOR);
+    m_totalBar->SetMaxValue(jobCount);
+
+    BGroupLayoutBuilder slotLayout(B_VERTICAL, 0);
+    m_slotBars = new BStatusBar*[slotCount];
+    for (int32 i = 0; i < slotCount; i++)
+    {
+        m_slotBars[i] = new BatchSlotBar("BatchExtractWindow:SlotBar");
+        slotLayout.Add(m_slotBars[i]);
+    }
+
+    m_logView = new BTextView("BatchExtractWindow:LogView", be_plain_font, NULL, B_WILL_DRAW | B_FRAME_EVENTS);
+    m_logView->SetWordWrap(false);
+    m_logView->MakeEditable(false);
+    BScrollView* scrollView = new BScrollView("BatchExtractWindow:ScrollView", m_logView, B_WILL_DRAW, true, true,
+                                              B_PLAIN_BORDER);
+    scrollView->SetExplicitMinSize(BSize(B_SIZE_UNSET, 100));
+
+    m_button = new BButton("BatchExtractWindow:Button", BZ_TR(kCancelString), new BMessage(M_STOP_OPERATION));
+
+    AddChild(BGroupLayoutBuilder(B_VERTICAL)
+             .Add(strView)
+             .Add(m_totalBar)
+             .Add(slotLayout)
+             .Add(scrollView)
+             .AddGroup(B_HORIZONTAL)
+             .AddGlue()
+             .Add(m_button, 0)
+             .End()
+             .SetInsets(4 * K_MARGIN, 2 * K_MARGIN, 4 * K_MARGIN, 2 * K_MARGIN)
+            );
+
+    BString totalStr;
+    totalStr.SetToFormat("0 of %d", (int)jobCount);
+    m_totalBar->SetTrailingText(totalStr.String());
+
+    // The slot bars must be attached to the window before messengers can target them
+    m_slotMessengers = new BMessenger[slotCount];
+    for (int32 i = 0; i < slotCount; i++)
+        m_slotMessengers[i] = BMessenger(m_slotBars[i]);
+
+    CenterOnScreen();
+    Show();
+
+    m_extractor->Start(BMessenger(this), m_slotMessengers);
+}
+
+
+BatchExtractWindow::~BatchExtractWindow()
+{
+    delete m_extractor;
+    delete[] m_slotMessengers;
+    delete[] m_slotBars;
+}
+
+
+bool BatchExtractWindow::QuitRequested()
+{
+    if (m_finished)
+        return true;
+
+    // Workers talk to our views synchronously, so we can't go away under them;
+    // cancel and close once they have all reported back
+    m_quitPending = true;
+    m_extractor->Cancel();
+    m_button->SetEnabled(false);
+    return false;
+}
+
+
+void BatchExtractWindow::Quit()
+{
+    be_app_messenger.SendMessage(M_CLOSE_BATCH);
+    return BWindow::Quit();
+}
+
+
+void BatchExtractWindow::MessageReceived(BMessage* message)
+{
+    switch (message->what)
+    {
+        case M_BATCH_JOB_DONE:
+        {
+            entry_ref ref;
+            message->FindRef(kRef, &ref);
+            status_t result = message->FindInt32(kResult);
+
+            BString logLine;
+            if (result == BZR_DONE || result == B_OK)
+            {
+                logLine = B_TRANSLATE("Extracted: %name%");
+                m_doneCount++;
+            }
+            else if (result == BZR_CANCEL_ARCHIVER || result == BZR_CANCEL)
+                logLine = B_TRANSLATE("Cancelled: %name%");
+            else
+            {
+                if (result == BZR_NOT_SUPPORTED)
+                    logLine = B_TRANSLATE("Skipped (not an archive or unsupported type): %name%");
+                else
+                    logLine = B_TRANSLATE("Failed: %name%");
+
+                const char* errorStr;
+                if (message->FindString(kErrorString, &errorStr) == B_OK)
+                    logLine << "\n" << errorStr;
+                m_failedCount++;
+            }
+
+            logLine.ReplaceAll("%name%", ref.name);
+            AddToLog(logLine.String());
+
+            BString totalStr;
+            totalStr.SetToFormat("%d of %d", (int)(m_doneCount + m_failedCount), (int)m_extractor->CountJobs());
+            m_totalBar->Update(1.0, NULL, totalStr.String());
+            break;
+        }
+
+        case M_BATCH_DONE:
+        {
+            m_finished = true;
+            m_extractor->WaitForWorkers();
+
+            BString summary(B_TRANSLATE("%done% of %total% archive(s) extracted, %failed% failed."));
+            BString numStr;
+            numStr.SetToFormat("%d", (int)m_doneCount);
+            summary.ReplaceAll("%done%", numStr);
+            numStr.SetToFormat("%d", (int)m_extractor->CountJobs());
+            summary.ReplaceAll("%total%", numStr);
+            numStr.SetToFormat("%d", (int)m_failedCount);
+            summary.ReplaceAll("%failed%", numStr);
+            AddToLog(summary.String());
+
+            for (int32 i = 0; i < m_extractor->CountWorkers(); i++)
+                m_slotBars[i]->Hide();
+
+            m_button->SetLabel(B_TRANSLATE("Close"));
+            m_button->SetMessage(new BMessage(B_QUIT_REQUESTED));
+            m_button->SetEnabled(true);
+
+            if (m_quitPending)
+                PostMessage(B_QUIT_REQUESTED);
+            break;
+        }
+
+        case M_STOP_OPERATION:
+        {
+            m_extractor->Cancel();
+            m_button->SetEnabled(false);
+            break;
+        }
+
+        default:
+            BWindow::MessageReceived(message);
+            break;
+    }
+}
+
+
+void BatchExtractWindow::AddToLog(const char* text)
+{
+    m_logView->Insert(m_logView->TextLength(), text, strlen(text));
+    m_logView->Insert(m_logView->TextLength(), "\n", 1);
+    m_logView->ScrollToOffset(m_logView->TextLength());
+}
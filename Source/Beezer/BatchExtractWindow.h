@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2002 Ramshankar (aka Teknomancer).
+// All rights reserved.
+
+#ifndef _BATCH_EXTRACT_WINDOW_H
+#define _BATCH_EXTRACT_WINDOW_H
+
+#include <Window.h>
+
+class BButton;
+class BMessenger;
+class BStatusBar;
+class BTextView;
+
+class BatchExtractor;
+
+class BatchExtractWindow : public BWindow
+{
+    public:
+        BatchExtractWindow(BatchExtractor* extractor);
+        virtual ~BatchExtractWindow();
+
+        // Inherited hooks
+        virtual bool        QuitRequested();
+        virtual void        Quit();
+        virtual void        MessageReceived(BMessage* message);
+
+    private:
+        void                AddToLog(const char* text);
+
+        BatchExtractor*     m_extractor;
+        BStatusBar*         m_totalBar;
+        BStatusBar**        m_slotBars;
+        BMessenger*         m_slotMessengers;
+        BTextView*          m_logView;
+        BButton*            m_button;
+        int32               m_doneCount,
+                            m_failedCount;
+        bool                m_finished,
+                            m_quitPending;
+};
+
+#endif /* _BATCH_EXTRACT_WINDOW_H */
@@ -0,0 +1,274 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2002 Ramshankar (aka Teknomancer).
+// All rights reserved.
+
+#include "BatchExtractor.h"
+#include "ArchiveRep.h"
+#include "Archiver.h"
+#include "ArchiverMgr.h"
+#include "MsgConstants.h"
+
+#include <Autolock.h>
+#include <Directory.h>
+#include <Path.h>
+#include <String.h>
+
+#include <cstdlib>
+#include <cstring>
+
+
+BatchExtractor::BatchExtractor(BMessage* refsMessage, entry_ref* destDirRef)
+    : m_destDirRef(*destDirRef),
+      m_slotMessengers(NULL),
+      m_threads(NULL),
+      m_workerCount(0),
+      m_nextJob(0),
+      m_activeWorkers(0),
+      m_cancel(false)
+{
+    // Build the job list, folders are expanded one level so that a folder full of
+    // archives can be dropped in one go
+    entry_ref ref;
+    for (int32 i = 0; refsMessage->FindRef("refs", i, &ref) == B_OK; i++)
+    {
+        BEntry entry(&ref, true);
+        if (entry.InitCheck() != B_OK || entry.Exists() == false)
+            continue;
+
+        if (entry.IsDirectory())
+        {
+            BDirectory dir(&entry);
+            BEntry childEntry;
+            while (dir.GetNextEntry(&childEntry, true) == B_OK)
+            {
+                if (childEntry.IsFile() && childEntry.GetRef(&ref) == B_OK)
+                    m_jobList.AddItem(new entry_ref(ref));
+            }
+        }
+        else if (entry.GetRef(&ref) == B_OK)
+            m_jobList.AddItem(new entry_ref(ref));
+    }
+
+    m_workerCount = OptimalWorkerCount();
+}
+
+
+BatchExtractor::~BatchExtractor()
+{
+    Cancel();
+    WaitForWorkers();
+
+    for (int32 i = 0; i < m_jobList.CountItems(); i++)
+        delete (entry_ref*)m_jobList.ItemAtFast(i);
+
+    delete[] m_threads;
+}
+
+
+int32 BatchExtractor::CountJobs() const
+{
+    return m_jobList.CountItems();
+}
+
+
+int32 BatchExtractor::CountWorkers() const
+{
+    return m_workerCount;
+}
+
+
+entry_ref* BatchExtractor::JobAt(int32 index) const
+{
+    return (entry_ref*)m_jobList.ItemAt(index);
+}
+
+
+int32 BatchExtractor::OptimalWorkerCount() const
+{
+    // One worker per core, but limited by how many volumes are involved as the work is
+    // mostly I/O bound when the archive and destination share a disk
+    system_info sysInfo;
+    int32 cpuCount = 1;
+    if (get_system_info(&sysInfo) == B_OK && sysInfo.cpu_count > 0)
+        cpuCount = sysInfo.cpu_count;
+
+    BList devices;
+    devices.AddItem((void*)(addr_t)m_destDirRef.device);
+    for (int32 i = 0; i < m_jobList.CountItems(); i++)
+    {
+        void* device = (void*)(addr_t)((entry_ref*)m_jobList.ItemAtFast(i))->device;
+        if (devices.HasItem(device) == false)
+            devices.AddItem(device);
+    }
+
+    int32 workers = devices.CountItems() * kMaxBatchWorkersPerVolume;
+    workers = min_c(workers, cpuCount);
+    workers = min_c(workers, m_jobList.CountItems());
+    return max_c(workers, 1);
+}
+
+
+status_t BatchExtractor::Start(BMessenger const& observer, BMessenger* slotMessengers)
+{
+    if (m_threads != NULL || m_jobList.CountItems() == 0)
+        return B_ERROR;
+
+    m_observer = observer;
+    m_slotMessengers = slotMessengers;
+    m_threads = new thread_id[m_workerCount];
+    m_activeWorkers = m_workerCount;
+
+    for (int32 i = 0; i < m_workerCount; i++)
+    {
+        BMessage* msg = new BMessage('work');
+        msg->AddPointer("extractor", (void*)this);
+        msg->AddInt32(kBatchSlot, i);
+
+        m_threads[i] = spawn_thread(_worker, "_batch_extractor", B_NORMAL_PRIORITY, (void*)msg);
+        resume_thread(m_threads[i]);
+    }
+
+    return B_OK;
+}
+
+
+void BatchExtractor::Cancel()
+{
+    m_cancel = true;
+}
+
+
+void BatchExtractor::WaitForWorkers()
+{
+    if (m_threads == NULL)
+        return;
+
+    for (int32 i = 0; i < m_workerCount; i++)
+    {
+        status_t exitCode;
+        wait_for_thread(m_threads[i], &exitCode);
+    }
+}
+
+
+int32 BatchExtractor::_worker(void* arg)
+{
+    BatchExtractor* extractor = NULL;
+    int32 slot = 0;
+
+    BMessage* msg = reinterpret_cast<BMessage*>(arg);
+    msg->FindPointer("extractor", reinterpret_cast<void**>(&extractor));
+    msg->FindInt32(kBatchSlot, &slot);
+    delete msg;
+
+    extractor->Run(slot);
+    return 0;
+}
+
+
+void BatchExtractor::Run(int32 slot)
+{
+    BMessenger* progress = m_slotMessengers ? &m_slotMessengers[slot] : NULL;
+    int32 jobIndex;
+    while (m_cancel == false && (jobIndex = atomic_add(&m_nextJob, 1)) < m_jobList.CountItems())
+    {
+        entry_ref* ref = (entry_ref*)m_jobList.ItemAtFast(jobIndex);
+
+        BMessage startMsg(M_BATCH_JOB_STARTED);
+        startMsg.AddInt32(kBatchSlot, slot);
+        startMsg.AddRef(kRef, ref);
+        m_observer.SendMessage(&startMsg);
+
+        BString errorStr;
+        status_t result = ExtractOne(ref, progress, errorStr);
+
+        BMessage doneMsg(M_BATCH_JOB_DONE);
+        doneMsg.AddInt32(kBatchSlot, slot);
+        doneMsg.AddRef(kRef, ref);
+        doneMsg.AddInt32(kResult, result);
+        if (errorStr.Length() > 0)
+            doneMsg.AddString(kErrorString, errorStr);
+        m_observer.SendMessage(&doneMsg);
+    }
+
+    // The last worker out reports the end of the whole batch
+    if (atomic_add(&m_activeWorkers, -1) == 1)
+    {
+        BMessage batchDoneMsg(M_BATCH_DONE);
+        batchDoneMsg.AddBool(kCancel, m_cancel);
+        m_observer.SendMessage(&batchDoneMsg);
+    }
+}
+
+
+status_t BatchExtractor::ExtractOne(entry_ref* ref, BMessenger* progress, BString& errorStr)
+{
+    ArchiveRep rep;
+    BPath archivePath(ref);
+
+    // Detecting the type and listing spawns the archiver binary, some add-ons chdir() before
+    // doing so, and chdir() is process-wide; keep this part serialized with every other window
+    // and run only the extraction itself concurrently
+    status_t result;
+    {
+        BAutolock autoLocker(_ark_locker);
+        char* mime = _archiverMgr()->ValidateFileType(&archivePath);
+        result = rep.InitArchiver(ref, mime);
+        delete[] mime;
+
+        if (rep.Ark() != NULL && (result == BZR_DONE || result == BZR_OPTIONAL_BINARY_MISSING))
+            result = rep.Open();
+    }
+
+    if (rep.Ark() == NULL)
+        return BZR_NOT_SUPPORTED;
+
+    if (result != BZR_DONE && result != B_OK)
+    {
+        rep.Ark()->ErrorMessage()->FindString(kErrorString, &errorStr);
+        return result;
+    }
+
+    // Each archive goes into its own sub-folder named after the archive
+    BString folderName = archivePath.Leaf();
+    const char* extension = rep.Ark()->ArchiveExtension();
+    if (extension != NULL)
+    {
+        int32 const found = folderName.IFindLast(extension);
+        if (found > 0 && found == folderName.Length() - (int32)strlen(extension))
+            folderName.Truncate(found);
+    }
+
+    BDirectory destDir(&m_destDirRef);
+    BDirectory subDir;
+    if (destDir.CreateDirectory(folderName.String(), &subDir) != B_OK)
+    {
+        BEntry subDirEntry(&destDir, folderName.String(), true);
+        if (subDirEntry.IsDirectory() == false || subDir.SetTo(&subDirEntry) != B_OK)
+            return BZR_EXTRACT_DIR_INIT_ERROR;
+    }
+
+    BEntry subDirEntry;
+    entry_ref subDirRef;
+    subDir.GetEntry(&subDirEntry);
+    subDirEntry.GetRef(&subDirRef);
+
+    if (progress != NULL)
+    {
+        BList* fileList;
+        BList* dirList;
+        rep.Ark()->FillLists();
+        rep.Ark()->GetLists(fileList, dirList);
+
+        BMessage resetMsg(M_BATCH_SLOT_RESET);
+        resetMsg.AddInt32(kCount, fileList->CountItems());
+        resetMsg.AddString(kText, archivePath.Leaf());
+        progress->SendMessage(&resetMsg);
+    }
+
+    result = rep.Ark()->Extract(&subDirRef, NULL, progress, &m_cancel);
+    if (result != BZR_DONE && result != B_OK)
+        rep.Ark()->ErrorMessage()->FindString(kErrorString, &errorStr);
+
+    return result;
+}
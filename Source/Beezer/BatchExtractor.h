@@ -0,0 +1,49 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2002 Ramshankar (aka Teknomancer).
+// All rights reserved.
+
+#ifndef _BATCH_EXTRACTOR_H
+#define _BATCH_EXTRACTOR_H
+
+#include <Entry.h>
+#include <List.h>
+#include <Messenger.h>
+
+class BString;
+
+// Upper bound on concurrent extractions (per volume involved) so that many small archives
+// don't thrash a single disk with competing seeks
+const int32 kMaxBatchWorkersPerVolume = 2;
+
+class BatchExtractor
+{
+    public:
+        BatchExtractor(BMessage* refsMessage, entry_ref* destDirRef);
+        virtual ~BatchExtractor();
+
+        int32               CountJobs() const;
+        int32               CountWorkers() const;
+        entry_ref*          JobAt(int32 index) const;
+        status_t            Start(BMessenger const& observer, BMessenger* slotMessengers);
+        void                Cancel();
+        void                WaitForWorkers();
+
+    private:
+        int32               OptimalWorkerCount() const;
+        status_t            ExtractOne(entry_ref* ref, BMessenger* progress, BString& errorStr);
+        void                Run(int32 slot);
+
+        static int32        _worker(void* arg);
+
+        BList               m_jobList;
+        entry_ref           m_destDirRef;
+        BMessenger          m_observer;
+        BMessenger*         m_slotMessengers;
+        thread_id*          m_threads;
+        int32               m_workerCount;
+        int32 volatile      m_nextJob,
+                            m_activeWorkers;
+        bool volatile       m_cancel;
+};
+
+#endif /* _BATCH_EXTRACTOR_H */
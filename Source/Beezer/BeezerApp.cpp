@@ -9,6 +9,8 @@
 #include "Alert.h"
 #include "AppConstants.h"
 #include "ArchiverMgr.h"
+#include "BatchExtractWindow.h"
+#include "BatchExtractor.h"
 #include "BitmapPool.h"
 #include "CommonStrings.h"
 #include "FileJoinerWindow.h"
@@ -50,6 +52,8 @@
 #include <os/add-ons/tracker/TrackerAddOn.h>
 #include <support/parsedate.h>
 
+#include <cstdio>
+
 
 BeezerApp* _bzr()
 {
@@ -57,6 +61,12 @@ BeezerApp* _bzr()
 }
 
 
+ArchiverMgr* _archiverMgr()
+{
+    return _bzr()->GetArchiverMgr();
+}
+
+
 BeezerApp::BeezerApp()
     : BApplication(K_APP_SIGNATURE),
       m_aboutWnd(NULL),
@@ -67,6 +77,7 @@ BeezerApp::BeezerApp()
       m_addOnWnd(NULL),
       m_nextWindowID(0L),
       m_nWindows(0L),
+      m_nBatchWindows(0L),
       m_openFilePanel(NULL),
       m_createFilePanel(NULL),
       m_windowMgr(new WindowMgr()),
@@ -91,7 +102,7 @@ BeezerApp::BeezerApp()
     InitPrefs();
     _glob_bitmap_pool = new BitmapPool();
 
-    m_archiverMgr = new ArchiverMgr(); // must be done after paths are set up
+    m_archiverMgr = new ArchiverMgr(&m_addonsDir, &m_settingsDir); // must be done after paths are set up
 
     // Load preferences, recents and all that stuff
     int8 numArk, numExt;
@@ -165,7 +176,7 @@ void BeezerApp::Quit()
 
 void BeezerApp::ReadyToRun()
 {
-    if (m_nWindows == 0 && m_startupWnd == NULL && m_addOnWnd == NULL)
+    if (m_nWindows == 0 && m_startupWnd == NULL && m_addOnWnd == NULL && m_nBatchWindows == 0)
         m_startupWnd = new StartupWindow(m_recentMgr, true);
 
     return BApplication::ReadyToRun();
@@ -209,7 +220,35 @@ void BeezerApp::MessageReceived(BMessage* message)
         case M_CLOSE_ADDON:
         {
             m_addOnWnd = NULL;
-            if (m_startupWnd == NULL)
+            if (m_startupWnd == NULL && m_nBatchWindows == 0)
+                PostMessage(B_QUIT_REQUESTED);
+            break;
+        }
+
+        case M_BATCH_EXTRACT:
+        {
+            entry_ref destRef;
+            if (message->FindRef(kBatchDestination, &destRef) != B_OK)
+                break;
+
+            BatchExtractor* extractor = new BatchExtractor(message, &destRef);
+            if (extractor->CountJobs() == 0)
+            {
+                delete extractor;
+                if (m_nWindows == 0 && m_startupWnd == NULL && m_addOnWnd == NULL && m_nBatchWindows == 0)
+                    PostMessage(B_QUIT_REQUESTED);
+                break;
+            }
+
+            m_nBatchWindows++;
+            new BatchExtractWindow(extractor);
+            break;
+        }
+
+        case M_CLOSE_BATCH:
+        {
+            m_nBatchWindows--;
+            if (m_nWindows == 0 && m_startupWnd == NULL && m_addOnWnd == NULL && m_nBatchWindows == 0)
                 PostMessage(B_QUIT_REQUESTED);
             break;
         }
@@ -521,6 +560,32 @@ void BeezerApp::UnRegisterWindow(bool closeApp)
 
 void BeezerApp::ArgvReceived(int32 argc, char** argv)
 {
+    // Beezer --batch-extract <destination folder> <archives or folders of archives...>
+    if (argc > 3 && strcmp(argv[1], "--batch-extract") == 0)
+    {
+        BEntry destEntry(argv[2], true);
+        entry_ref destRef;
+        if (destEntry.IsDirectory() == false || destEntry.GetRef(&destRef) != B_OK)
+        {
+            fprintf(stderr, "%s: not a folder\n", argv[2]);
+            return;
+        }
+
+        BMessage batchMsg(M_BATCH_EXTRACT);
+        batchMsg.AddRef(kBatchDestination, &destRef);
+        for (int32 arg = 3; arg < argc; arg++)
+        {
+            BEntry entry(argv[arg], true);
+            entry_ref ref;
+            if (entry.InitCheck() == B_OK && entry.Exists() && entry.GetRef(&ref) == B_OK)
+                batchMsg.AddRef("refs", &ref);
+        }
+
+        // Handled right away so that ReadyToRun() doesn't bring up the startup window
+        MessageReceived(&batchMsg);
+        return;
+    }
+
     for (int32 arg = 1; arg < argc; arg++)
     {
         BEntry entry(argv[arg], true);         // Traverse link
@@ -73,7 +73,8 @@ class BeezerApp : public BApplication
         AddOnWindow*        m_addOnWnd;
 
         uint32              m_nextWindowID,
-                            m_nWindows;
+                            m_nWindows,
+                            m_nBatchWindows;
         BRect               m_defaultWindowRect,
                             m_newWindowRect;
         BFilePanel*         m_openFilePanel,
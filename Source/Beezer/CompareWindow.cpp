@@ -0,0 +1,570 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2002 Ramshankar (aka Teknomancer).
+// All rights reserved.
+
+#include "CompareWindow.h"
+#include "AppUtils.h"
+#include "ArchiveRep.h"
+#include "Archiver.h"
+#include "ArchiverMgr.h"
+#include "FSUtils.h"
+#include "HashTable.h"
+#include "ListEntry.h"
+#include "MsgConstants.h"
+#include "UIConstants.h"
+
+#include <Autolock.h>
+#include <Button.h>
+#include <Directory.h>
+#include <File.h>
+#include <LayoutBuilder.h>
+#include <ListView.h>
+#include <MenuField.h>
+#include <MenuItem.h>
+#include <PopUpMenu.h>
+#include <ScrollView.h>
+#include <StringView.h>
+#include <TextControl.h>
+
+#include <cstring>
+#include <strings.h>
+
+#ifdef HAIKU_ENABLE_I18N
+#include <Catalog.h>
+
+#undef B_TRANSLATION_CONTEXT
+#define B_TRANSLATION_CONTEXT "CompareWindow"
+#else
+#define B_TRANSLATE(x) x
+#endif
+
+
+// States of a file, in the order of the filter menu (which has "All differences" first)
+enum
+{
+    kStateAdded = 0,
+    kStateRemoved,
+    kStateChanged,
+    kStateUnverified,
+    kStateSame
+};
+
+static const size_t kCompareBufferSize = 64 * 1024;
+static const char* const kChangedField = "changed";
+static const char* const kSameField = "same";
+static const char* const kMissingField = "missing";
+
+
+struct CompareRow
+{
+    BString             path;
+    int32               state;
+    off_t               oldSize,
+                        newSize;
+};
+
+
+// One archive of a content comparison, extracted into its own temporary folder
+struct CompareSide
+{
+    entry_ref           ref;
+    BMessage*           paths;
+    BDirectory*         destDir;
+    BString             destPath;
+    status_t            result;
+    BString             errorStr;
+    volatile bool*      cancel;
+};
+
+
+static int CompareRows(const void* a, const void* b)
+{
+    return strcmp((*(CompareRow**)a)->path.String(), (*(CompareRow**)b)->path.String());
+}
+
+
+// The field of the done message a compared file goes in. A file missing from either extraction
+// (an add-on may drop or flatten paths) or unreadable tells nothing about its contents
+static const char* CompareFiles(const char* pathA, const char* pathB, uint8* bufferA, uint8* bufferB)
+{
+    BFile fileA(pathA, B_READ_ONLY);
+    BFile fileB(pathB, B_READ_ONLY);
+    if (fileA.InitCheck() != B_OK || fileB.InitCheck() != B_OK)
+        return kMissingField;
+
+    for (;;)
+    {
+        ssize_t const bytesRead = fileA.Read(bufferA, kCompareBufferSize);
+        if (bytesRead < 0)
+            return kMissingField;
+
+        ssize_t const bytesReadB = fileB.Read(bufferB, kCompareBufferSize);
+        if (bytesReadB < 0)
+            return kMissingField;
+
+        if (bytesReadB != bytesRead)
+            return kChangedField;
+
+        if (bytesRead == 0)
+            return kSameField;
+
+        if (memcmp(bufferA, bufferB, bytesRead) != 0)
+            return kChangedField;
+    }
+}
+
+
+CompareWindow::CompareWindow(BWindow* callerWindow, Archiver* oldArchiver, entry_ref* oldRef,
+                             Archiver* newArchiver, entry_ref* newRef)
+    : BWindow(BRect(0, 0, 520, 420), B_TRANSLATE("Compare archives"), B_TITLED_WINDOW_LOOK, B_NORMAL_WINDOW_FEEL,
+              B_ASYNCHRONOUS_CONTROLS | B_AUTO_UPDATE_SIZE_LIMITS | B_CLOSE_ON_ESCAPE),
+    m_oldRef(*oldRef),
+    m_newRef(*newRef),
+    m_thread(-1),
+    m_cancel(false),
+    m_uncomparedCount(0)
+{
+    BString headerStr;
+    headerStr << m_oldRef.name << "  \xE2\x86\x92  " << m_newRef.name;
+    BStringView* headerView = new BStringView("CompareWindow:HeaderView", headerStr.String());
+    headerView->SetFont(be_bold_font);
+
+    BMenu* filterMenu = new BPopUpMenu("");
+    filterMenu->AddItem(new BMenuItem(B_TRANSLATE("All differences"), new BMessage(M_COMPARE_FILTER)));
+    filterMenu->AddItem(new BMenuItem(B_TRANSLATE("Added"), new BMessage(M_COMPARE_FILTER)));
+    filterMenu->AddItem(new BMenuItem(B_TRANSLATE("Removed"), new BMessage(M_COMPARE_FILTER)));
+    filterMenu->AddItem(new BMenuItem(B_TRANSLATE("Changed"), new BMessage(M_COMPARE_FILTER)));
+    filterMenu->AddItem(new BMenuItem(B_TRANSLATE("Possibly changed"), new BMessage(M_COMPARE_FILTER)));
+    filterMenu->SetLabelFromMarked(true);
+    filterMenu->ItemAt(0L)->SetMarked(true);
+    m_filterField = new BMenuField("CompareWindow:FilterField", B_TRANSLATE("Show:"), filterMenu);
+
+    m_filterControl = new BTextControl("CompareWindow:FilterControl", B_TRANSLATE("Path contains:"), "", NULL);
+    m_filterControl->SetModificationMessage(new BMessage(M_COMPARE_FILTER));
+
+    m_listView = new BListView("CompareWindow:ListView", B_SINGLE_SELECTION_LIST);
+    BScrollView* scrollView = new BScrollView("CompareWindow:ScrollView", m_listView, 0, true, true);
+
+    m_summaryStr = new BStringView("CompareWindow:SummaryStr", "");
+    m_summaryStr->SetExplicitMaxSize(BSize(B_SIZE_UNLIMITED, B_SIZE_UNSET));
+
+    // Same size but a different date and no CRC to go by, only the contents can tell these apart
+    m_contentsButton = new BButton("CompareWindow:ContentsButton", B_TRANSLATE("Compare contents"),
+                                   new BMessage(M_COMPARE_CONTENTS));
+
+    BLayoutBuilder::Group<>(this, B_VERTICAL, B_USE_DEFAULT_SPACING)
+        .SetInsets(B_USE_WINDOW_INSETS)
+        .Add(headerView)
+        .AddGroup(B_HORIZONTAL)
+            .Add(m_filterField)
+            .Add(m_filterControl)
+        .End()
+        .Add(scrollView)
+        .AddGroup(B_HORIZONTAL)
+            .Add(m_summaryStr)
+            .Add(m_contentsButton)
+        .End();
+
+    CompareListings(oldArchiver, newArchiver);
+    FillList();
+    UpdateSummary();
+
+    if (callerWindow != NULL)
+    {
+        BRect callerRect(callerWindow->Frame());
+        MoveTo(callerRect.left + K_MARGIN * 4, callerRect.top + K_MARGIN * 4);
+    }
+    else
+        CenterOnScreen();
+
+    Show();
+}
+
+
+CompareWindow::~CompareWindow()
+{
+    for (int32 i = 0; i < m_listView->CountItems(); i++)
+        delete m_listView->ItemAt(i);
+
+    for (int32 i = 0; i < m_rows.CountItems(); i++)
+        delete (CompareRow*)m_rows.ItemAtFast(i);
+}
+
+
+bool CompareWindow::QuitRequested()
+{
+    if (m_thread >= B_OK)
+    {
+        m_cancel = true;
+        status_t exitCode;
+        wait_for_thread(m_thread, &exitCode);
+        m_thread = -1;
+    }
+
+    return BWindow::QuitRequested();
+}
+
+
+void CompareWindow::MessageReceived(BMessage* message)
+{
+    switch (message->what)
+    {
+        case M_COMPARE_FILTER:
+        {
+            FillList();
+            break;
+        }
+
+        case M_COMPARE_CONTENTS:
+        {
+            CompareContents();
+            break;
+        }
+
+        case M_COMPARE_CONTENTS_DONE:
+        {
+            CompareContentsDone(message);
+            break;
+        }
+
+        default:
+            BWindow::MessageReceived(message);
+            break;
+    }
+}
+
+
+void CompareWindow::CompareListings(Archiver* oldArchiver, Archiver* newArchiver)
+{
+    // A hash join over the path tables the archivers already keep, each listing is walked once
+    BList* oldFileList;
+    BList* oldDirList;
+    BList* newFileList;
+    BList* newDirList;
+    oldArchiver->GetLists(oldFileList, oldDirList);
+    newArchiver->GetLists(newFileList, newDirList);
+
+    HashTable* oldTable = oldArchiver->Table();
+    HashTable* newTable = newArchiver->Table();
+
+    int32 count = oldFileList->CountItems();
+    for (int32 i = 0; i < count; i++)
+    {
+        ListEntry* oldItem = ((HashEntry*)oldFileList->ItemAtFast(i))->m_clvItem;
+        if (oldItem == NULL)
+            continue;
+
+        HashEntry* match = newTable->Find(oldItem->m_fullPath.String());
+        ListEntry* newItem = match != NULL ? match->m_clvItem : NULL;
+        if (newItem == NULL || newItem->IsSuperItem() == true)
+            AddRow(oldItem->m_fullPath.String(), kStateRemoved, oldItem, NULL);
+        else
+        {
+            int32 const state = EntryState(oldItem, newItem);
+            if (state != kStateSame)
+                AddRow(oldItem->m_fullPath.String(), state, oldItem, newItem);
+        }
+    }
+
+    count = newFileList->CountItems();
+    for (int32 i = 0; i < count; i++)
+    {
+        ListEntry* newItem = ((HashEntry*)newFileList->ItemAtFast(i))->m_clvItem;
+        if (newItem == NULL)
+            continue;
+
+        HashEntry* match = oldTable->Find(newItem->m_fullPath.String());
+        if (match == NULL || match->m_clvItem == NULL || match->m_clvItem->IsSuperItem() == true)
+            AddRow(newItem->m_fullPath.String(), kStateAdded, NULL, newItem);
+    }
+
+    m_rows.SortItems(CompareRows);
+}
+
+
+int32 CompareWindow::EntryState(ListEntry* oldItem, ListEntry* newItem) const
+{
+    if (oldItem->m_length != newItem->m_length)
+        return kStateChanged;
+
+    const char* oldCrc = oldItem->GetColumnContentText(9);
+    const char* newCrc = newItem->GetColumnContentText(9);
+    if (oldCrc != NULL && newCrc != NULL && oldCrc[0] != '\0' && newCrc[0] != '\0')
+        return strcasecmp(oldCrc, newCrc) == 0 ? kStateSame : kStateChanged;
+
+    // Without CRCs an untouched date is taken as unchanged, anything else needs the contents
+    return oldItem->m_timeValue == newItem->m_timeValue ? kStateSame : kStateUnverified;
+}
+
+
+void CompareWindow::AddRow(const char* path, int32 state, ListEntry* oldItem, ListEntry* newItem)
+{
+    CompareRow* row = new CompareRow;
+    row->path = path;
+    row->state = state;
+    row->oldSize = oldItem != NULL ? oldItem->m_length : 0;
+    row->newSize = newItem != NULL ? newItem->m_length : 0;
+    m_rows.AddItem(row);
+}
+
+
+void CompareWindow::FillList()
+{
+    int32 const filterState = m_filterField->Menu()->IndexOf(m_filterField->Menu()->FindMarked()) - 1;
+    const char* filterText = m_filterControl->Text();
+
+    for (int32 i = 0; i < m_listView->CountItems(); i++)
+        delete m_listView->ItemAt(i);
+    m_listView->MakeEmpty();
+
+    BList items;
+    int32 const count = m_rows.CountItems();
+    for (int32 i = 0; i < count; i++)
+    {
+        CompareRow* row = (CompareRow*)m_rows.ItemAtFast(i);
+        if (row->state == kStateSame || (filterState >= 0 && row->state != filterState))
+            continue;
+
+        if (filterText[0] != '\0' && row->path.IFindFirst(filterText) < 0)
+            continue;
+
+        BString text;
+        switch (row->state)
+        {
+            case kStateAdded:
+                text << B_TRANSLATE("Added") << ": " << row->path << "  (" << StringFromBytes(row->newSize) << ")";
+                break;
+
+            case kStateRemoved:
+                text << B_TRANSLATE("Removed") << ": " << row->path << "  (" << StringFromBytes(row->oldSize) << ")";
+                break;
+
+            case kStateChanged:
+                text << B_TRANSLATE("Changed") << ": " << row->path;
+                if (row->oldSize != row->newSize)
+                    text << "  (" << StringFromBytes(row->oldSize) << " \xE2\x86\x92 " << StringFromBytes(row->newSize) << ")";
+                break;
+
+            default:
+                text << B_TRANSLATE("Possibly changed") << ": " << row->path;
+                break;
+        }
+
+        items.AddItem(new BStringItem(text.String()));
+    }
+
+    m_listView->AddList(&items);
+}
+
+
+void CompareWindow::UpdateSummary()
+{
+    int32 counts[kStateSame + 1];
+    memset(counts, 0, sizeof(counts));
+    for (int32 i = 0; i < m_rows.CountItems(); i++)
+        counts[((CompareRow*)m_rows.ItemAtFast(i))->state]++;
+
+    BString summary(B_TRANSLATE("%added% added, %removed% removed, %changed% changed, %unverified% possibly changed"));
+    summary.ReplaceAll("%added%", (BString() << counts[kStateAdded]).String());
+    summary.ReplaceAll("%removed%", (BString() << counts[kStateRemoved]).String());
+    summary.ReplaceAll("%changed%", (BString() << counts[kStateChanged]).String());
+    summary.ReplaceAll("%unverified%", (BString() << counts[kStateUnverified]).String());
+    if (m_uncomparedCount > 0)
+    {
+        BString uncomparedStr(B_TRANSLATE(" (%uncompared% not extracted, could not be compared)"));
+        uncomparedStr.ReplaceAll("%uncompared%", (BString() << m_uncomparedCount).String());
+        summary << uncomparedStr;
+    }
+    m_summaryStr->SetText(summary.String());
+
+    m_contentsButton->SetEnabled(counts[kStateUnverified] > 0 && m_thread < B_OK);
+}
+
+
+void CompareWindow::CompareContents()
+{
+    if (m_thread >= B_OK)
+        return;
+
+    m_cancel = false;
+    m_thread = spawn_thread(_contentComparer, "_content_comparer", B_NORMAL_PRIORITY, (void*)this);
+    if (m_thread < B_OK)
+        return;
+
+    m_contentsButton->SetEnabled(false);
+    m_summaryStr->SetText(B_TRANSLATE("Comparing contents" B_UTF8_ELLIPSIS));
+    resume_thread(m_thread);
+}
+
+
+void CompareWindow::CompareContentsDone(BMessage* message)
+{
+    status_t exitCode;
+    wait_for_thread(m_thread, &exitCode);
+    m_thread = -1;
+
+    int32 index;
+    for (int32 i = 0; message->FindInt32(kChangedField, i, &index) == B_OK; i++)
+        ((CompareRow*)m_rows.ItemAt(index))->state = kStateChanged;
+
+    for (int32 i = 0; message->FindInt32(kSameField, i, &index) == B_OK; i++)
+        ((CompareRow*)m_rows.ItemAt(index))->state = kStateSame;
+
+    // Those stay "Possibly changed"
+    type_code type;
+    if (message->GetInfo(kMissingField, &type, &m_uncomparedCount) != B_OK)
+        m_uncomparedCount = 0;
+
+    FillList();
+    UpdateSummary();
+
+    // Say which archive could not be extracted, the rows are left as they were
+    entry_ref ref;
+    status_t result;
+    if (message->FindInt32(kResult, &result) == B_OK && message->FindRef(kRef, &ref) == B_OK)
+    {
+        BString errorLine;
+        if (result == BZR_NOT_SUPPORTED)
+            errorLine = B_TRANSLATE("Comparing contents failed, %name% could not be opened");
+        else
+            errorLine = B_TRANSLATE("Comparing contents failed, %name% could not be extracted");
+        errorLine.ReplaceAll("%name%", ref.name);
+
+        const char* errorStr;
+        if (message->FindString(kErrorString, &errorStr) == B_OK)
+            errorLine << ": " << errorStr;
+
+        m_summaryStr->SetText(errorLine.String());
+    }
+}
+
+
+int32 CompareWindow::_contentComparer(void* arg)
+{
+    CompareWindow* wnd = reinterpret_cast<CompareWindow*>(arg);
+
+    // Only the members the listings could not settle are extracted, from both archives at once
+    BMessage paths;
+    BList candidates;
+    int32 const count = wnd->m_rows.CountItems();
+    for (int32 i = 0; i < count; i++)
+    {
+        CompareRow* row = (CompareRow*)wnd->m_rows.ItemAtFast(i);
+        if (row->state == kStateUnverified)
+        {
+            paths.AddString(kPath, row->path.String());
+            candidates.AddItem((void*)(addr_t)i);
+        }
+    }
+
+    CompareSide oldSide = { wnd->m_oldRef, &paths, NULL, "", BZR_DONE, "", &wnd->m_cancel };
+    CompareSide newSide = { wnd->m_newRef, &paths, NULL, "", BZR_DONE, "", &wnd->m_cancel };
+    oldSide.destPath = CreateTempDirectory(NULL, &oldSide.destDir, true);
+    newSide.destPath = CreateTempDirectory(NULL, &newSide.destDir, true);
+
+    thread_id tid = spawn_thread(_sideExtractor, "_side_extractor", B_NORMAL_PRIORITY, (void*)&newSide);
+    if (tid >= B_OK)
+        resume_thread(tid);
+
+    _sideExtractor(&oldSide);
+
+    status_t exitCode;
+    if (tid >= B_OK)
+        wait_for_thread(tid, &exitCode);
+    else
+        newSide.result = tid;
+
+    BMessage doneMessage(M_COMPARE_CONTENTS_DONE);
+    if (oldSide.result == BZR_DONE && newSide.result == BZR_DONE && wnd->m_cancel == false)
+    {
+        uint8* bufferA = new uint8[kCompareBufferSize];
+        uint8* bufferB = new uint8[kCompareBufferSize];
+        for (int32 i = 0; i < candidates.CountItems() && wnd->m_cancel == false; i++)
+        {
+            int32 const index = (int32)(addr_t)candidates.ItemAtFast(i);
+            CompareRow* row = (CompareRow*)wnd->m_rows.ItemAtFast(index);
+
+            BString oldPath, newPath;
+            oldPath << oldSide.destPath << '/' << row->path;
+            newPath << newSide.destPath << '/' << row->path;
+            doneMessage.AddInt32(CompareFiles(oldPath.String(), newPath.String(), bufferA, bufferB), index);
+        }
+
+        delete[] bufferA;
+        delete[] bufferB;
+    }
+    else
+    {
+        CompareSide* failedSide = oldSide.result != BZR_DONE ? &oldSide : &newSide;
+        if (failedSide->result != BZR_DONE)
+        {
+            doneMessage.AddInt32(kResult, failedSide->result);
+            doneMessage.AddRef(kRef, &failedSide->ref);
+            if (failedSide->errorStr.Length() > 0)
+                doneMessage.AddString(kErrorString, failedSide->errorStr);
+        }
+    }
+
+    CompareSide* sides[] = { &oldSide, &newSide };
+    for (int32 i = 0; i < 2; i++)
+    {
+        if (sides[i]->destDir != NULL)
+        {
+            RemoveDirectory(sides[i]->destDir);
+            delete sides[i]->destDir;
+        }
+    }
+
+    if (wnd->m_cancel == false)
+        wnd->PostMessage(&doneMessage);
+
+    return BZR_DONE;
+}
+
+
+int32 CompareWindow::_sideExtractor(void* arg)
+{
+    CompareSide* side = reinterpret_cast<CompareSide*>(arg);
+    if (side->destDir == NULL)
+    {
+        side->result = BZR_EXTRACT_DIR_INIT_ERROR;
+        return side->result;
+    }
+
+    // Listing spawns the archiver binary and some add-ons chdir() first, so that part is serialized
+    // like in the batch extractor; the two extractions then run side by side
+    ArchiveRep rep;
+    {
+        BAutolock autoLocker(_ark_locker);
+        BPath archivePath(&side->ref);
+        char* mime = _archiverMgr()->ValidateFileType(&archivePath);
+        side->result = rep.InitArchiver(&side->ref, mime);
+        delete[] mime;
+
+        if (rep.Ark() != NULL && (side->result == BZR_DONE || side->result == BZR_OPTIONAL_BINARY_MISSING))
+            side->result = rep.Open();
+    }
+
+    if (rep.Ark() == NULL)
+        side->result = BZR_NOT_SUPPORTED;
+
+    if (side->result != BZR_DONE && side->result != B_OK)
+    {
+        if (rep.Ark() != NULL)
+            rep.Ark()->ErrorMessage()->FindString(kErrorString, &side->errorStr);
+        return side->result;
+    }
+
+    BEntry destEntry;
+    entry_ref destRef;
+    side->destDir->GetEntry(&destEntry);
+    destEntry.GetRef(&destRef);
+
+    side->result = rep.Ark()->Extract(&destRef, side->paths, NULL, side->cancel);
+    if (side->result == B_OK)
+        side->result = BZR_DONE;
+    else if (side->result != BZR_DONE)
+        rep.Ark()->ErrorMessage()->FindString(kErrorString, &side->errorStr);
+
+    return side->result;
+}
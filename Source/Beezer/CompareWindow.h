@@ -0,0 +1,59 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2002 Ramshankar (aka Teknomancer).
+// All rights reserved.
+
+#ifndef _COMPARE_WINDOW_H
+#define _COMPARE_WINDOW_H
+
+#include <Entry.h>
+#include <List.h>
+#include <Window.h>
+
+class BButton;
+class BListView;
+class BMenuField;
+class BStringView;
+class BTextControl;
+
+class Archiver;
+class ListEntry;
+
+// Lists what changed from one open archive to another. The listings are compared when the window
+// is created and copied, so the windows of both archives can be closed while this one is open
+class CompareWindow : public BWindow
+{
+    public:
+        CompareWindow(BWindow* callerWindow, Archiver* oldArchiver, entry_ref* oldRef, Archiver* newArchiver,
+                      entry_ref* newRef);
+        virtual ~CompareWindow();
+
+        // Inherited hooks
+        virtual bool        QuitRequested();
+        virtual void        MessageReceived(BMessage* message);
+
+    private:
+        void                CompareListings(Archiver* oldArchiver, Archiver* newArchiver);
+        int32               EntryState(ListEntry* oldItem, ListEntry* newItem) const;
+        void                AddRow(const char* path, int32 state, ListEntry* oldItem, ListEntry* newItem);
+        void                FillList();
+        void                UpdateSummary();
+        void                CompareContents();
+        void                CompareContentsDone(BMessage* message);
+
+        static int32        _contentComparer(void* arg);
+        static int32        _sideExtractor(void* arg);
+
+        entry_ref           m_oldRef,
+                            m_newRef;
+        BList               m_rows;
+        BListView*          m_listView;
+        BMenuField*         m_filterField;
+        BTextControl*       m_filterControl;
+        BStringView*        m_summaryStr;
+        BButton*            m_contentsButton;
+        thread_id           m_thread;
+        volatile bool       m_cancel;
+        int32               m_uncomparedCount;
+};
+
+#endif /* _COMPARE_WINDOW_H */
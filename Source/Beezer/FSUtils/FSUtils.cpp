@@ -20,6 +20,7 @@
 #include <cassert>
 #include <cstdio>
 #include <cstdlib> // gcc2
+#include <unistd.h>
 
 // Global object declares
 BLocker _fs_utils_locker("_fs_utils_lock", true);
@@ -73,6 +74,121 @@ status_t CopyDirectory(BEntry* srcDir, BDirectory* destDir, BMessenger* progress
 }
 
 
+status_t LinkDirectory(BEntry* srcDir, BDirectory* destDir, BMessenger* progress, volatile bool* cancel,
+                       bool symbolic)
+{
+    BAutolock autoLocker(&_fs_utils_locker);
+    if (!autoLocker.IsLocked())
+        return B_ERROR;
+
+    // Directories can't be hard linked, so recreate the tree and only link the files within it
+    char subDirLeaf [B_FILE_NAME_LENGTH];
+    srcDir->GetName(subDirLeaf);
+    BDirectory subDir;
+
+    destDir->CreateDirectory(subDirLeaf, &subDir);
+    subDir.SetTo(destDir, subDirLeaf);
+    if (subDir.InitCheck() != B_OK)
+        return B_ERROR;
+
+    BNode srcNode(srcDir);
+    const size_t bufSize = 1024 * 16;
+    char* buffer = new char[bufSize];
+    CopyAttributes(&srcNode, &subDir, buffer, bufSize);
+    delete[] buffer;
+
+    BDirectory dir(srcDir);
+    BEntry entry;
+    status_t exitCode = BZR_DONE;
+    while (dir.GetNextEntry(&entry, false) == B_OK)
+    {
+        if (*cancel == true)
+            return BZR_CANCEL;
+
+        if (entry.IsDirectory() == false)
+            exitCode = LinkFile(&entry, &subDir, progress, cancel, symbolic);
+        else
+            exitCode = LinkDirectory(&entry, &subDir, progress, cancel, symbolic);
+
+        // A partly staged tree must not be added as if it were complete
+        if (exitCode != BZR_DONE)
+            return exitCode;
+    }
+
+    return exitCode;
+}
+
+
+status_t LinkFile(BEntry* srcEntry, BDirectory* destDir, BMessenger* progress, volatile bool* cancel,
+                  bool symbolic)
+{
+    BAutolock autoLocker(&_fs_utils_locker);
+    if (!autoLocker.IsLocked())
+        return B_ERROR;
+
+    // Symlinks are cheap to recreate and must not be resolved, leave them to CopyFile
+    if (srcEntry->IsFile() == false)
+        return CopyFile(srcEntry, destDir, progress, cancel);
+
+    char destLeaf [B_FILE_NAME_LENGTH];
+    srcEntry->GetName(destLeaf);
+
+    BPath srcPath;
+    BPath destPath;
+    BEntry destDirEntry;
+    destDir->GetEntry(&destDirEntry);
+    if (srcEntry->GetPath(&srcPath) != B_OK || destDirEntry.GetPath(&destPath) != B_OK
+            || destPath.Append(destLeaf) != B_OK)
+        return CopyFile(srcEntry, destDir, progress, cancel);
+
+    // A stale entry may itself be a link to the source, copying over it would truncate the source
+    BEntry staleEntry;
+    if (destDir->FindEntry(destLeaf, &staleEntry) == B_OK)
+        staleEntry.Remove();
+
+    // Hard links fail across volumes and on file systems without them, like BFS where the temp
+    // folder usually is. A symbolic link is only good when the archiver follows it while adding,
+    // otherwise we pay for a full copy of the data
+    if (link(srcPath.Path(), destPath.Path()) != 0
+            && (symbolic == false || symlink(srcPath.Path(), destPath.Path()) != 0))
+        return CopyFile(srcEntry, destDir, progress, cancel);
+
+    if (progress)
+    {
+        BMessage updateMessage(BZR_UPDATE_PROGRESS), reply('DUMB');
+        updateMessage.AddString("text", destLeaf);
+        updateMessage.AddFloat("delta", 1.0f);
+        progress->SendMessage(&updateMessage, &reply);
+    }
+
+    return BZR_DONE;
+}
+
+
+bool ContainsLinks(BEntry* srcEntry, volatile bool* cancel)
+{
+    // Whether srcEntry is, or a folder under it holds, a symbolic link
+    if (srcEntry->IsSymLink() == true)
+        return true;
+
+    if (srcEntry->IsDirectory() == false)
+        return false;
+
+    BDirectory dir(srcEntry);
+    BEntry entry;
+    while (dir.GetNextEntry(&entry, false) == B_OK)
+    {
+        if (cancel && *cancel == true)
+            return false;
+
+        if (ContainsLinks(&entry, cancel) == true)
+            return true;
+    }
+
+    return false;
+}
+
+
 void GetDirectoryInfo(BEntry* srcDir, int32& fileCount, int32& folderCount, off_t& totalSize,
                       volatile bool* cancel)
 {
@@ -27,6 +27,14 @@ extern "C" _FS_IMPEXP status_t CopyDirectory(BEntry* srcDir, BDirectory* destDir
 
 extern "C" _FS_IMPEXP status_t CopyFile(BEntry* src, BDirectory* destDir, BMessenger* progress, volatile bool* cancel);
 
+extern "C" _FS_IMPEXP status_t LinkDirectory(BEntry* srcDir, BDirectory* destDir, BMessenger* progress,
+                                             volatile bool* cancel, bool symbolic);
+
+extern "C" _FS_IMPEXP status_t LinkFile(BEntry* src, BDirectory* destDir, BMessenger* progress, volatile bool* cancel,
+                                        bool symbolic);
+
+extern "C" _FS_IMPEXP bool ContainsLinks(BEntry* src, volatile bool* cancel);
+
 extern "C" _FS_IMPEXP void GetDirectoryInfo(BEntry* srcDir, int32& fileCount, int32& folderCount, off_t& totalSize,
                                             volatile bool* cancel);
 
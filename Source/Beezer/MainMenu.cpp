@@ -112,6 +112,9 @@ MainMenu::MainMenu(BRect frame)
             .AddSeparator()
             .AddItem(B_TRANSLATE("Test"), M_ACTIONS_TEST, 'T')
             .AddItem(B_TRANSLATE("Search archive" B_UTF8_ELLIPSIS), M_ACTIONS_SEARCH_ARCHIVE, 'F')
+            .AddMenu(B_TRANSLATE("Compare with"))
+                .GetMenu(m_compareMenu)
+            .End()
             .AddItem(BZ_TR(kCommentString), M_ACTIONS_COMMENT, 'C', B_SHIFT_KEY)
             .AddSeparator()
             .AddItem(B_TRANSLATE("Add" B_UTF8_ELLIPSIS), M_ACTIONS_ADD, 'A', B_SHIFT_KEY)
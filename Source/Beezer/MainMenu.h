@@ -34,6 +34,7 @@ class MainMenu : public BMenuBar
                             *m_editMenu,
                             *m_selectAllMenu,
                             *m_actionsMenu,
+                            *m_compareMenu,
                             *m_columnsSubMenu,
                             *m_sortBySubMenu,
                             *m_sortOrderSubMenu,
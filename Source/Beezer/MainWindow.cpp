@@ -16,6 +16,7 @@
 #include "CLVColumnLabelView.h"
 #include "CommentWindow.h"
 #include "CommonStrings.h"
+#include "CompareWindow.h"
 #include "DirRefFilter.h"
 #include "FSUtils.h"
 #include "HashTable.h"
@@ -41,7 +42,10 @@
 #include "UIConstants.h"
 #include "WindowMgr.h"
 
+#include <Autolock.h>
+#include <Beep.h>
 #include <FindDirectory.h>
+#include <MessageRunner.h>
 #include <NodeInfo.h>
 #include <Resources.h>
 #include <Volume.h>
@@ -70,6 +74,9 @@ MainWindow::MainWindow(BRect frame, WindowMgr* windowMgr, RecentMgr* recentMgr,
       m_createMode(false),
       m_addStarted(false),
       m_dragExtract(false),
+      m_openInProgress(false),
+      m_listingShown(false),
+      m_addingListed(false),
       m_archiversDir(NULL),
       m_tempDir(NULL),
       m_tempDirPath(NULL),
@@ -219,57 +226,34 @@ void MainWindow::MessageReceived(BMessage* message)
 {
     switch (message->what)
     {
-        case M_ADD_FOLDERS:
+        case BZR_ENTRIES_READY:
         {
-            int32 i, totalItems;
-            if (message->FindInt32("start_index", &i) != B_OK)
-            {
-                i = 0L;
-                m_archiver->FillLists();
-                m_archiver->GetLists(m_fileList, m_dirList);
-            }
+            // The add-on has listed more entries while still opening the archive
+            if (m_openInProgress == false)
+                break;
 
-            i = AddFoldersFromList(i, &totalItems);
-            // Bug-fix it should be < not <= -Bug was found when opening BeIDE.zip
-            if (i < totalItems)
+            ShowListing();
+            m_archiver->FillLists(&m_listedFileList, &m_listedDirList);
+            if (m_addingListed == false)
             {
-                message->RemoveName("start_index");
-                message->AddInt32("start_index", i);
-                PostMessage(message);
+                m_addingListed = true;
+                PostMessage(M_ADD_LISTED);
             }
-            else
-                PostMessage(M_ADD_ITEMS);
 
             break;
         }
 
-        case M_ADD_ITEMS:
+        case M_ADD_LISTED:
         {
-            int32 index, totalItems;
-            if (message->FindInt32("start_index", &index) != B_OK)
-                index = 0L;
-            index = AddItemsFromList(index, &totalItems);
-
-            // Check if all items have been added
-            if (index < totalItems)
+            if (AddListedEntries() == true)
             {
-                message->RemoveName("start_index");
-                message->AddInt32("start_index", index);
-                PostMessage(message);
+                PostMessage(M_ADD_LISTED);
+                break;
             }
-            else
-            {
-                // Calculate the total size of the archive
-                for (int32 k = 0; k < totalItems; k++)
-                {
-                    ListEntry* item = ((HashEntry*)m_fileList->ItemAtFast(k))->m_clvItem;
-                    if (item)
-                        m_archiveSize += item->m_length;
-                }
-
-                m_infoBar->UpdateFilesDisplay(0L, totalItems + m_dirList->CountItems(), true);
-                m_infoBar->UpdateBytesDisplay(0L, m_archiveSize, true);
 
+            m_addingListed = false;
+            if (m_openInProgress == false)
+            {
                 SetBusyState(false);
                 PostMessage(M_OPEN_FINISHED);
             }
@@ -277,6 +261,15 @@ void MainWindow::MessageReceived(BMessage* message)
             break;
         }
 
+        case M_OPEN_SLOW:
+        {
+            // Nothing has been listed yet, let the user know we're on it
+            if (m_listingShown == false && m_statusWnd != NULL)
+                m_statusWnd->Show();
+
+            break;
+        }
+
         case M_BROADCAST_STATUS:
         {
             // Called from WindowMgr when some other windows modified
@@ -346,7 +339,12 @@ void MainWindow::MessageReceived(BMessage* message)
             status_t result;
             message->FindInt32(kResult, &result);
             OpenArchivePartTwo(result);
-            PostMessage(M_ADD_FOLDERS);
+            if (m_addingListed == false)
+            {
+                m_addingListed = true;
+                PostMessage(M_ADD_LISTED);
+            }
+
             break;
         }
 
@@ -516,7 +514,7 @@ void MainWindow::MessageReceived(BMessage* message)
             if (item)
             {
                 UpdateUIAsPerSelection();
-                m_infoBar->UpdateBy(1, item->m_length);
+                m_infoBar->UpdateBy(1, m_listView->EntryBytes(item));
             }
 
             break;
@@ -548,7 +546,7 @@ void MainWindow::MessageReceived(BMessage* message)
             int32 i = 0L;
             int32 fileCount = 0L;
             while ((selEntry =
-                    (ListEntry*)m_listView->FullListItemAt(m_listView->FullListCurrentSelection(i))) != NULL)
+                    (ListEntry*)m_listView->SelectedItemAt(i)) != NULL)
             {
                 if (!selEntry->IsSuperItem())
                 {
@@ -853,14 +851,19 @@ void MainWindow::MessageReceived(BMessage* message)
             else if (selectedItem->IsSuperItem() == false && selectedItem->OutlineLevel() == 0L)
                 addingAtRoot = true;
 
+            // If a folder item is selected, add files inside it otherwise add files inside
+            // the directory of the selected file item
+            const char* itemPath = NULL;
             if (addingAtRoot == false)
             {
-                // If a folder item is selected, add files inside it otherwise add files inside
-                // the directory of the selected file item
-                const char* itemPath = selectedItem->m_dirPath.String();
+                itemPath = selectedItem->m_dirPath.String();
                 if (selectedItem->IsSuperItem() == true)
                     itemPath = selectedItem->m_fullPath.String();
+            }
 
+            // Archivers that can rename while adding don't need the files staged under itemPath in temp
+            if (addingAtRoot == false && m_archiver->CanAddUnderPath() == false)
+            {
                 int32 count = 0L, skipped = 0L;
                 if (ConfirmAddOperation(itemPath, copyMsg, &count, &skipped) == false
                         || count == skipped)
@@ -885,6 +888,7 @@ void MainWindow::MessageReceived(BMessage* message)
                 copyMsg->AddString(kPreparing, B_TRANSLATE("Preparing to add" B_UTF8_ELLIPSIS));
                 copyMsg->AddPointer(kSuperItem, (void*)selectedItem);         // Will be used in M_ADD_DONE
                 copyMsg->AddString(kSuperItemPath, itemPath);                // Will be used in _copier
+                copyMsg->AddBool(kStagedLinks, m_archiver->CanAddStagedLinks());
 
                 m_progressWnd = new ProgressWindow(this, copyMsg, messenger, cancel);
 
@@ -896,18 +900,21 @@ void MainWindow::MessageReceived(BMessage* message)
                 m_logTextView->AddText(" ", false, false, false);
                 resume_thread(spawn_thread(_copier, "_copier", B_NORMAL_PRIORITY, (void*)copyMsg));
             }
-            else           // user is adding at the root of the archive so DON'T copy files to temp
+            else           // user is adding at the root of the archive (or archiver renames) so DON'T copy files to temp
             {
                 if (m_createMode == false)
                 {
                     int32 count = 0L, skipped = 0L;
-                    if (ConfirmAddOperation(NULL, copyMsg, &count, &skipped) == false || count == skipped)
+                    if (ConfirmAddOperation(itemPath, copyMsg, &count, &skipped) == false || count == skipped)
                     {
                         delete copyMsg;
                         break;
                     }
                 }
 
+                if (itemPath != NULL)
+                    copyMsg->AddString(kArchiveSubPath, itemPath);
+
                 copyMsg->what = M_READY_TO_ADD;
                 copyMsg->AddInt32(kResult, M_SKIPPED);         // Tell READY_TO_ADD we skipped the copying of files
 
@@ -946,6 +953,12 @@ void MainWindow::MessageReceived(BMessage* message)
                 m_logTextView->AddText(B_TRANSLATE("Cancelled"), false, false, false);
                 break;
             }
+            else if (result != BZR_DONE && result != (int32)M_SKIPPED)
+            {
+                // Some files could not be staged, don't add what is only part of them
+                m_logTextView->AddText(B_TRANSLATE("Failed!"), false, false, false);
+                break;
+            }
 
             if (result != (int32)M_SKIPPED)
                 m_logTextView->AddText(B_TRANSLATE("Done"), false, false, false);
@@ -1025,6 +1038,8 @@ void MainWindow::MessageReceived(BMessage* message)
             {
                 i = 0L;
                 m_archiver->FillLists(&m_addedFileList, &m_addedDirList);
+                // FillLists() updates entries that are already listed in place
+                m_listView->InvalidateSubtreeTotals();
                 if (m_createMode == true)
                     m_archiver->GetLists(m_fileList, m_dirList);
             }
@@ -1290,7 +1305,7 @@ void MainWindow::MessageReceived(BMessage* message)
             // Handle focus changed and selection
             if (m_listView->IsFocus() == true)
             {
-                if (m_listView->FullListCurrentSelection() >= 0L)
+                if (m_listView->CurrentSelection(0L) >= 0L)
                     UpdateFocusNeeders(true);
                 else
                     UpdateFocusNeeders(false);
@@ -1313,6 +1328,14 @@ void MainWindow::MessageReceived(BMessage* message)
             break;
         }
 
+        case M_ACTIONS_COMPARE:
+        {
+            MainWindow* otherWnd = NULL;
+            message->FindPointer(kWindowPtr, reinterpret_cast<void**>(&otherWnd));
+            CompareWith(otherWnd);
+            break;
+        }
+
         // We call SendSelectionMessage (true) because KeyDown of BeezerListView might have turned it off
         case M_EDIT_SELECT_ALL:    m_listView->SendSelectionMessage(true); m_listView->SelectAll(); break;
         case M_EDIT_SELECT_ALL_DIRS: m_listView->SendSelectionMessage(true); m_listView->SelectAllEx(true); break;
@@ -1898,6 +1921,7 @@ void MainWindow::UpdateValidArchiveNeeders(bool enable)
         item->SetEnabled(enable);
 
     m_mainMenu->m_actionsMenu->FindItem(M_ACTIONS_SEARCH_ARCHIVE)->SetEnabled(enable);
+    m_mainMenu->m_compareMenu->SetEnabled(enable);
     m_mainMenu->m_actionsMenu->FindItem(M_ACTIONS_TEST)->SetEnabled(enable);
 
     m_mainMenu->m_fileMenu->FindItem(M_FILE_DELETE)->SetEnabled(enable);
@@ -1924,12 +1948,13 @@ void MainWindow::UpdateUIAsPerSelection()
     bool enable = false;
     bool allDirs = true;
     bool atLeastOneSelection = false;
-    int32 selected, i = 0L;
+    int32 i = 0L;
+    CLVListItem* selected;
 
-    while ((selected = m_listView->FullListCurrentSelection(i++)) >= 0)
+    while ((selected = m_listView->SelectedItemAt(i++)) != NULL)
     {
         atLeastOneSelection = true;
-        ListEntry* item = dynamic_cast<ListEntry*>(m_listView->FullListItemAt(selected));
+        ListEntry* item = dynamic_cast<ListEntry*>(selected);
         if (item->IsSuperItem() == false)
         {
             enable = true;
@@ -2019,6 +2044,7 @@ void MainWindow::UpdateWindowsMenu()
     BMenu* wndMenu = m_mainMenu->m_windowsMenu;
     int32 wndCount = wndMenu->CountItems();
     m_mainMenu->m_windowsMenu->RemoveItems(0L, wndCount, true);
+    m_mainMenu->m_compareMenu->RemoveItems(0L, m_mainMenu->m_compareMenu->CountItems(), true);
 
     wndCount = m_windowMgr->CountWindows();
     for (int32 i = 0; i < wndCount; i++)
@@ -2033,6 +2059,12 @@ void MainWindow::UpdateWindowsMenu()
             wndMenu->AddItem(menuItem);
             if (wndPtr == this)
                 menuItem->SetMarked(true);
+            else
+            {
+                BMessage* compareMsg = new BMessage(M_ACTIONS_COMPARE);
+                compareMsg->AddPointer(kWindowPtr, wndPtr);
+                m_mainMenu->m_compareMenu->AddItem(new BMenuItem(wndPtr->Title(), compareMsg));
+            }
         }
     }
 }
@@ -2102,7 +2134,7 @@ void MainWindow::DeleteFilesFromArchive()
     int32 i = 0L;
     int32 count = 0L;
     while ((selEntry =
-            (ListEntry*)m_listView->FullListItemAt(m_listView->FullListCurrentSelection(i))) != NULL)
+            (ListEntry*)m_listView->SelectedItemAt(i)) != NULL)
     {
         if (m_publicThreadCancel == true)
             break;
@@ -2184,6 +2216,11 @@ void MainWindow::DeleteFilesFromArchive()
     // Ask confirmation!!
     BString alertStr(B_TRANSLATE("Delete the selected item(s)?"));
     alertStr << "\n" << B_TRANSLATE("This operation cannot be reverted.");
+    if (m_archiver->HasSolidBlocks())
+    {
+        alertStr << "\n\n" << B_TRANSLATE("This archive uses solid blocks, deleting even a single file rewrites "
+                                         "its whole block which may take a while.");
+    }
     BAlert* warnAlert = new BAlert("Warning", alertStr, B_TRANSLATE("Delete"), BZ_TR(kCancelString),
                                    NULL, B_WIDTH_AS_USUAL, B_EVEN_SPACING, B_WARNING_ALERT);
     warnAlert->SetDefaultButton(warnAlert->ButtonAt(1L));
@@ -2281,54 +2318,48 @@ void MainWindow::DeleteDone(BMessage* message)
 
 void MainWindow::DeleteUpdate()
 {
-    // Update all hash items, list view of the deleted items
-    ListEntry* selEntry(NULL);
-    size_t bytesRemoved = 0;
+    // Update all hash items, list view of the deleted items. Deleted entries are only marked here
+    // (they lose their list item) and each list is then compacted in a single pass, removing them
+    // one by one meant a linear search and shift in every list for every entry
+    off_t bytesRemoved = 0;
+    BList deadItems(m_deleteFileList->CountItems() + m_deleteDirList->CountItems());
 
     m_listView->SendSelectionMessage(false);
 
-    // Delete file items by looking it up from the hashtable
+    // Mark file items by looking them up from the hashtable
     for (int32 x = 0; x < m_deleteFileList->CountItems(); x++)
     {
-        selEntry = (ListEntry*)m_deleteFileList->ItemAtFast(x);
-        BString path = selEntry->m_fullPath;
-
-        // We put this in a while loop so that archivers like tar delete all occurrences of the file
-        // if there are duplicate files
-        HashEntry* entry(NULL);
-        while ((entry = m_archiver->Table()->Find(path.String())) != NULL)
+        ListEntry* selEntry = (ListEntry*)m_deleteFileList->ItemAtFast(x);
+        HashEntry* entry = m_archiver->Table()->Find(selEntry->m_fullPath.String());
+        if (entry != NULL && entry->m_clvItem != NULL)
         {
             bytesRemoved += entry->m_clvItem->m_length;
-            m_fileList->RemoveItem(entry);
-            m_listView->RemoveItem(entry->m_clvItem);
-
-            delete entry->m_clvItem;
-            m_archiver->Table()->Delete(entry);
-
-            // No need to waste time Find()ing selEntry again if the archiver has only
-            // unique files
-            if (m_archiver->CanReplaceFiles() == true)
-                break;
+            deadItems.AddItem(entry->m_clvItem);
+            entry->m_clvItem = NULL;
         }
     }
 
-    // Delete folder items -- we look-up the hashtable and find the CLVItem we need from the list
+    // Mark folder items -- we look-up the hashtable and find the CLVItem we need from the list
     // of HashTable folder items
     for (int32 x = 0; x < m_deleteDirList->CountItems(); x++)
     {
-        selEntry = (ListEntry*)m_deleteDirList->ItemAtFast(x);
+        ListEntry* selEntry = (ListEntry*)m_deleteDirList->ItemAtFast(x);
         HashEntry* entry = m_archiver->Table()->Find(selEntry->m_fullPath.String());
-        if (entry)
+        if (entry != NULL && entry->m_clvItem != NULL)
         {
-            bytesRemoved += selEntry->m_length;
-            m_dirList->RemoveItem(entry);
-            m_listView->RemoveItem(selEntry);
-
-            m_archiver->Table()->Delete(entry);     // Bug fixed
-            delete selEntry;
+            bytesRemoved += entry->m_clvItem->m_length;
+            deadItems.AddItem(entry->m_clvItem);
+            entry->m_clvItem = NULL;
         }
     }
 
+    m_listView->RemoveItemList(&deadItems);
+    RemoveDeadEntries(m_fileList);
+    RemoveDeadEntries(m_dirList);
+
+    for (int32 x = 0; x < deadItems.CountItems(); x++)
+        delete (ListEntry*)deadItems.ItemAtFast(x);
+
     // Update archive size, displays
     m_archiveSize -= bytesRemoved;
     m_infoBar->UpdateFilesDisplay(0L, m_fileList->CountItems() + m_dirList->CountItems(), true);
@@ -2340,6 +2371,24 @@ void MainWindow::DeleteUpdate()
 }
 
 
+void MainWindow::RemoveDeadEntries(BList* hashEntryList)
+{
+    // Drop the entries DeleteUpdate() took the list item away from, deleting them from the table too
+    int32 const count = hashEntryList->CountItems();
+    BList keptEntries(count);
+    for (int32 i = 0; i < count; i++)
+    {
+        HashEntry* entry = (HashEntry*)hashEntryList->ItemAtFast(i);
+        if (entry->m_clvItem != NULL)
+            keptEntries.AddItem(entry);
+        else
+            m_archiver->Table()->Delete(entry);
+    }
+
+    *hashEntryList = keptEntries;
+}
+
+
 //
 // --- Test Functions ---
 //
@@ -2583,7 +2632,7 @@ void MainWindow::ExtractArchive(entry_ref *refToDir, bool fullArchive)
         int32 i = 0L;
         int32 fileCount = 0L;
         while ((selEntry =
-                (ListEntry*)m_listView->FullListItemAt(m_listView->FullListCurrentSelection(i))) != NULL)
+                (ListEntry*)m_listView->SelectedItemAt(i)) != NULL)
         {
             if (selEntry->IsSuperItem() == false)               // File - no problems just add it!
             {
@@ -2770,110 +2819,6 @@ int32 MainWindow::AddFolderToMessage(ListEntry* item, BMessage* message, bool co
 }
 
 
-int32 MainWindow::AddFoldersFromList(int32 index, int32* totalItems)
-{
-    // Add split folders at a time, then we will be called again (MessageReceived:M_ADD_ITEMS), Any messages
-    // inbetween can be processed this way -- for smaller archives (< split folders) add all at once */
-    int32 count = m_dirList->CountItems();
-    *totalItems = count;
-    int32 limit = 0, split = 60;
-
-    if (count >= split * 2)
-    {
-        if (index + (count / split) > count)
-            limit = count;
-        else
-            limit = index + (count / split);
-
-        for (; index < limit; index++)
-        {
-            ListEntry* dirEntry = ((HashEntry*)m_dirList->ItemAtFast(index))->m_clvItem;
-            HashEntry* parent = m_archiver->Table()->Find(dirEntry->m_dirPath.String());
-            if (parent)
-                m_listView->AddUnderFast(dirEntry, parent->m_clvItem);
-            else
-                m_listView->AddItemFastHierarchical(dirEntry);
-
-            dirEntry->m_added = true;
-        }
-
-        return index;
-    }
-    else
-    {
-        int32 i = 0L;
-        for (; i < count; i++)
-        {
-            ListEntry* dirEntry = (ListEntry*)(((HashEntry*)m_dirList->ItemAtFast(i))->m_clvItem);
-            HashEntry* parent = m_archiver->Table()->Find(dirEntry->m_dirPath.String());
-            if (parent)
-                m_listView->AddUnderFast(dirEntry, parent->m_clvItem);
-            else
-                m_listView->AddItemFastHierarchical(dirEntry);
-
-            dirEntry->m_added = true;
-        }
-
-        return i;
-    }
-}
-
-
-int32 MainWindow::AddItemsFromList(int32 index, int32* totalItems)
-{
-    // Add split files at a time, then we will be called again (MessageReceived:M_ADD_ITEMS), Any messages
-    // inbetween can be processed this way -- for smaller archives (< split files) add all at once */
-    int32 count = m_fileList->CountItems();
-    *totalItems = count;
-    int32 limit = 0, split = 300;
-
-    if (count >= split * 2)
-    {
-        if (index + (count / split) > count)
-            limit = count;
-        else
-            limit = index + (count / split);
-
-        for (; index < limit; index++)
-        {
-            ListEntry* item = ((HashEntry*)m_fileList->ItemAtFast(index))->m_clvItem;
-            HashEntry* parentHash = m_archiver->Table()->Find(item->m_dirPath.String());
-
-            // In case the entry doesn't have a parent folder at all
-            if (parentHash)
-                m_listView->AddUnderFast(item, parentHash->m_clvItem);
-            else
-                m_listView->AddItemFastHierarchical(item);
-
-            item->m_added = true;
-        }
-
-        // We have added index number of files
-        return index;
-    }
-    else
-    {
-        int32 i = 0L, c = m_fileList->CountItems();
-        for (; i < c; i++)
-        {
-            ListEntry* item = ((HashEntry*)m_fileList->ItemAtFast(i))->m_clvItem;
-            HashEntry* parentHash = m_archiver->Table()->Find(item->m_dirPath.String());
-
-            // In case the entry doesn't have a parent folder at all
-            if (parentHash)
-                m_listView->AddUnderFast(item, parentHash->m_clvItem);
-            else
-                m_listView->AddItemFastHierarchical(item);
-
-            item->m_added = true;
-        }
-
-        // We have added all files
-        return i;
-    }
-}
-
-
 void MainWindow::SetupArchiver(entry_ref* ref, char* mimeString)
 {
     // Initialise archiver based either on ref, or on the passed-in mimeString
@@ -3029,62 +2974,109 @@ void MainWindow::OpenArchive()
     openMsg->AddPointer(kArchiverPtr, (void*)m_archiver);
     openMsg->AddRef(kRef, &m_archiveRef);
 
-    thread_info tinfo;
-    bigtime_t pollTime = 50000;           // time interval to check each time if the thread is still running
-    bigtime_t waitTime = pollTime;        // initialize waitTime, this keeps incrementing
-    bigtime_t maxWaitTime = 1600000;    // 1.6 seconds before popping status window
-
-    // What we do below looks ugly but its quite nice What happens is , we see if the load
-    // process (Open thread) runs for more than "maxWaitTime" usecs, if so we pop-up the status window
-    // to keep the mainwindow's drawing still functional and blocking the user from closing the window
-    // which would lead to the worker thread not being quit. Otherwise it does a normal open
+    // Add-ons that stream their listing send us BZR_ENTRIES_READY as entries come in, which we show
+    // right away. The status window only pops up (M_OPEN_SLOW) if nothing at all was listed in
+    // that time, and keeps the user from closing the window while the worker thread runs
+    m_openInProgress = true;
+    m_listingShown = false;
+    m_archiver->SetEntriesMessenger(BMessenger(this));
 
     m_criticalSection = true;        // Tells QuitRequested() not to grant permission to close window
     m_statusWnd = new StatusWindow(B_TRANSLATE("Preparing to open" B_UTF8_ELLIPSIS), this, B_TRANSLATE("Please wait" B_UTF8_ELLIPSIS), NULL, false);
     thread_id tid = spawn_thread(_opener, "_opener", B_NORMAL_PRIORITY, (void*)openMsg);
     resume_thread(tid);
-    while (1)
+
+    BMessage slowMsg(M_OPEN_SLOW);
+    BMessageRunner::StartSending(BMessenger(this), &slowMsg, 1600000, 1);
+}
+
+
+void MainWindow::OpenArchivePartTwo(status_t result)
+{
+    // Whatever was listed after the last batch, or everything for add-ons that don't stream
+    ShowListing();
+    m_archiver->FillLists(&m_listedFileList, &m_listedDirList);
+    m_archiver->SetEntriesMessenger(BMessenger());
+    m_openInProgress = false;
+
+    if (result == BZR_ERRSTREAM_FOUND)
+        m_badArchive = true;
+
+    UpdateNewWindow();
+    m_criticalSection = false;
+}
+
+
+void MainWindow::ShowListing()
+{
+    if (m_listingShown == true)
+        return;
+
+    // Bug-fix: we can't use m_statusWnd->PostMessage(M_CLOSE) when it is NOT Show()ing
+    // therefore quit manually
+    if (m_statusWnd != NULL && m_statusWnd->Lock())
     {
-        status_t isAlive = get_thread_info(tid, &tinfo);
-        if (isAlive == B_OK)
-            snooze(pollTime);
+        if (m_statusWnd->IsHidden())
+            m_statusWnd->Quit();
         else
         {
-            // Bug-fix: we can't use m_statusWnd->PostMessage(M_CLOSE) when it is NOT Show()ing
-            // therefore quit manually
-            if (m_statusWnd->Lock())
-            {
-                m_statusWnd->Quit();
-                m_statusWnd = NULL;
-            }
-            m_criticalSection = false;
-            break;
+            m_statusWnd->Unlock();
+            m_statusWnd->PostMessage(M_CLOSE);
         }
 
-        waitTime += pollTime;
-        if (waitTime >= maxWaitTime)
-        {
-            m_statusWnd->Show();
-            break;
-        }
+        m_statusWnd = NULL;
     }
+
+    m_listingShown = true;
+    m_archiver->GetLists(m_fileList, m_dirList);
+    SetBusyState(true);
+    AdjustColumns();
+    UpdateIfNeeded();
 }
 
 
-void MainWindow::OpenArchivePartTwo(status_t result)
+bool MainWindow::AddListedEntries()
 {
-    if (m_statusWnd)
-        m_statusWnd->PostMessage(M_CLOSE);
+    // Add a slice of what has been listed at a time, so the window stays responsive while large
+    // archives load; folders go first so that files always find their parent already added
+    int32 const kListedSlice = 2000;
+    int32 const dirCount = min_c(m_listedDirList.CountItems(), kListedSlice);
+    for (int32 i = 0; i < dirCount; i++)
+    {
+        ListEntry* dirEntry = ((HashEntry*)m_listedDirList.ItemAtFast(i))->m_clvItem;
+        HashEntry* parent = m_archiver->Table()->Find(dirEntry->m_dirPath.String());
+        if (parent)
+            m_listView->AddUnderFast(dirEntry, parent->m_clvItem);
+        else
+            m_listView->AddItemFastHierarchical(dirEntry);
 
-    SetBusyState(true);
-    AdjustColumns();
-    UpdateIfNeeded();
+        dirEntry->m_added = true;
+    }
 
-    if (result == BZR_ERRSTREAM_FOUND)
-        m_badArchive = true;
+    m_listedDirList.RemoveItems(0, dirCount);
 
-    UpdateNewWindow();
-    m_criticalSection = false;
+    int32 const fileCount = min_c(m_listedFileList.CountItems(), kListedSlice - dirCount);
+    for (int32 i = 0; i < fileCount; i++)
+    {
+        ListEntry* item = ((HashEntry*)m_listedFileList.ItemAtFast(i))->m_clvItem;
+        HashEntry* parentHash = m_archiver->Table()->Find(item->m_dirPath.String());
+
+        // In case the entry doesn't have a parent folder at all
+        if (parentHash)
+            m_listView->AddUnderFast(item, parentHash->m_clvItem);
+        else
+            m_listView->AddItemFastHierarchical(item);
+
+        item->m_added = true;
+        m_archiveSize += item->m_length;
+    }
+
+    m_listedFileList.RemoveItems(0, fileCount);
+
+    m_infoBar->UpdateFilesDisplay(0L, m_fileList->CountItems() + m_dirList->CountItems(), true);
+    m_infoBar->UpdateBytesDisplay(0L, m_archiveSize, true);
+
+    return m_listedDirList.IsEmpty() == false || m_listedFileList.IsEmpty() == false;
 }
 
 
@@ -3945,9 +3937,11 @@ int32 MainWindow::_counter(void* arg)
 
 int32 MainWindow::_copier(void* arg)
 {
-    // Copies files to kLaunchDir directory before adding to the archive
+    // Stages files in kLaunchDir directory before adding to the archive
     // This is done so that files/folder can be added to any dir inside the archive
-    // as we will be launching archive from kLaunchDir
+    // as we will be launching archive from kLaunchDir. Files are hard linked where
+    // the file system allows it, else symbolic linked when the archiver will follow
+    // the links, and only copied otherwise.
     BMessage* msg = reinterpret_cast<BMessage*>(arg);
     status_t result = BZR_DONE;
     volatile bool* cancel;
@@ -3971,6 +3965,20 @@ int32 MainWindow::_copier(void* arg)
 
     BDirectory destDir(tempDir);
 
+    // An archiver told to follow the staged links would follow links in the files being added too,
+    // so those are staged as copies to keep their links stored as links
+    bool stagedLinks = msg->FindBool(kStagedLinks);
+    for (int32 i = 0; i < count && stagedLinks == true; i++)
+        if (msg->FindRef("refs", i, &ref) == B_OK)
+        {
+            BEntry entry(&ref, false);
+            if (ContainsLinks(&entry, cancel) == true)
+                stagedLinks = false;
+        }
+
+    msg->RemoveName(kStagedLinks);
+    msg->AddBool(kStagedLinks, stagedLinks);
+
     for (int32 i = --count; i >= 0; i--)
         if (msg->FindRef("refs", i, &ref) == B_OK)
         {
@@ -3978,9 +3986,12 @@ int32 MainWindow::_copier(void* arg)
 
             BEntry entry(&ref, false);         // Do NOT TRAVERSE LINKS
             if (entry.IsDirectory() == true)
-                result = CopyDirectory(&entry, &destDir, &messenger, cancel);
+                result = LinkDirectory(&entry, &destDir, &messenger, cancel, stagedLinks);
             else
-                result = CopyFile(&entry, &destDir, &messenger, cancel);
+                result = LinkFile(&entry, &destDir, &messenger, cancel, stagedLinks);
+
+            if (result != BZR_DONE)
+                break;
 
             // Make message have new relative paths as THOSE are the refs that will
             // be added to the archive as they are copied now to a temp dir
@@ -4174,6 +4185,34 @@ int32 MainWindow::_opener(void* arg)
 //
 
 
+void MainWindow::CompareWith(MainWindow* otherWnd)
+{
+    // The menu may be older than the window it names, so only a window that is still registered
+    // is locked; the compare window copies what it needs while the lock is held
+    BAutolock autolocker(_wnd_locker);
+    bool registered = false;
+    for (int32 i = 0; i < m_windowMgr->CountWindows(); i++)
+    {
+        if (m_windowMgr->WindowAt(i) == otherWnd)
+            registered = true;
+    }
+
+    if (registered == false || otherWnd == this || m_archiver == NULL || m_openInProgress == true
+        || otherWnd->LockWithTimeout(1000000) != B_OK)
+    {
+        beep();
+        return;
+    }
+
+    if (otherWnd->m_archiver != NULL && otherWnd->m_openInProgress == false)
+        new CompareWindow(this, m_archiver, &m_archiveRef, otherWnd->m_archiver, &otherWnd->m_archiveRef);
+    else
+        beep();
+
+    otherWnd->Unlock();
+}
+
+
 void MainWindow::EditComment(bool failIfNoComment)
 {
     if (m_archiver && m_archiver->SupportsComment() == true)
@@ -114,6 +114,8 @@ class MainWindow : public BWindow
         void                AdjustColumns();
         void                OpenArchive();
         void                OpenArchivePartTwo(status_t result);
+        void                ShowListing();
+        bool                AddListedEntries();
         void                ViewFile(BMessage* message);
         void                ExtractArchive(entry_ref *refToDir, bool fullArchive);
         bool                IsExtractPathValid(const char* path, bool throwAlertErrorIfAny) const;
@@ -123,11 +125,13 @@ class MainWindow : public BWindow
         void                CancelDelete();
         void                DeleteDone(BMessage* message);
         void                DeleteUpdate();
+        void                RemoveDeadEntries(BList* hashEntryList);
         void                ExtractDone(BMessage* message);
         void                TestArchive();
         void                TestDone(BMessage* message);
         void                ClearDeleteLists();
         void                EditComment(bool failIfNoComment);
+        void                CompareWith(MainWindow* otherWnd);
         void                SetBusyState(bool on) const;
         void                EmptyListViewIfNeeded();
         void                ShowOpNotSupported() const;
@@ -137,8 +141,6 @@ class MainWindow : public BWindow
         bool                CanAddFiles() const;
         const char*         MakeTempDirectory();
         void                AddNewFolder();
-        int32               AddItemsFromList(int32 start, int32* totalItems);
-        int32               AddFoldersFromList(int32 start, int32* totalItems);
         int32               AddItemsFromList(BList* list, int32 start);
         int32               AddFoldersFromList(BList* list, int32 start);
         int32               AddFolderToMessage(ListEntry* item, BMessage* message, bool countOnlyFiles,
@@ -180,7 +182,10 @@ class MainWindow : public BWindow
                             m_badArchive,
                             m_createMode,
                             m_addStarted,
-                            m_dragExtract;
+                            m_dragExtract,
+                            m_openInProgress,
+                            m_listingShown,
+                            m_addingListed;
         BDirectory*         m_archiversDir,
                             *m_tempDir;
         const char*         m_tempDirPath;
@@ -188,6 +193,8 @@ class MainWindow : public BWindow
                             *m_dirList,
                             m_addedFileList,
                             m_addedDirList,
+                            m_listedFileList,
+                            m_listedDirList,
                             m_columnList,
                             *m_deleteFileList,
                             *m_deleteDirList;
@@ -66,6 +66,7 @@ const char* const kSuperItem =          "sitem",
 *const kListItem =                      "list_item",
 *const kBytes =                         "sel_bytes",
 *const kArchivePath =                   "archive_path",
+*const kBatchSlot =                     "batch_slot",
 
 // Drag and drop constants
 *const kFieldFull =                     "bzr:full",
@@ -103,8 +104,8 @@ enum
     M_ARK_TYPE_SELECTED = 0xbe05,
     M_STOP_OPERATION,
     M_REPLY,
-    M_ADD_ITEMS,
-    M_ADD_FOLDERS,
+    M_ADD_LISTED,
+    M_OPEN_SLOW,
     M_ADD_ITEMS_LIST,
     M_ADD_FOLDERS_LIST,
     M_COPY_LISTS,
@@ -153,6 +154,7 @@ enum
     M_ACTIONS_DELETE,
     M_ACTIONS_RENAME,
     M_ACTIONS_CREATE_FOLDER,
+    M_ACTIONS_COMPARE,
 
     M_TOOLS_LIST,
     M_TOOLS_FILE_SPLITTER,
@@ -256,6 +258,16 @@ enum
     M_SEARCH_TEXT_MODIFIED,
     M_SEARCH_CLOSED,
 
+    M_COMPARE_FILTER,
+    M_COMPARE_CONTENTS,
+    M_COMPARE_CONTENTS_DONE,
+
+    M_BATCH_JOB_STARTED,
+    M_BATCH_JOB_DONE,
+    M_BATCH_SLOT_RESET,
+    M_BATCH_DONE,
+    M_CLOSE_BATCH,
+
     M_CLOSE_STARTUP
 };
 
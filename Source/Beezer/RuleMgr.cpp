@@ -5,6 +5,7 @@
 
 #include "RuleMgr.h"
 #include "RuleDefaults.h"
+#include "FormatSniffer.h"
 
 #include <List.h>
 #include <NodeInfo.h>
@@ -125,7 +126,9 @@ char* RuleMgr::ValidateFileType(BPath* filePath) const
     BString fileName = filePath->Leaf();
     BNode node(filePath->Path());
     BNodeInfo nodeInfo(&node);
-    nodeInfo.GetType(type);
+    bool const hasType = nodeInfo.GetType(type) == B_OK && type[0] != '\0';
+    if (hasType == false)
+        type[0] = '\0';
 
     int32 extensionIndex = -1;
     for (int32 i = 0; i < m_ruleList->CountItems(); i++)
@@ -160,6 +163,17 @@ char* RuleMgr::ValidateFileType(BPath* filePath) const
         }
     }
 
+    // Use the type the content gives away, but only write it to an untyped file; formats built
+    // on zip (jar, docx, epub...) keep their own type on disk
+    const char* sniffedType = SniffArchiveType(filePath->Path());
+    if (sniffedType != NULL)
+    {
+        if (hasType == false)
+            nodeInfo.SetType(sniffedType);
+        strcpy(mime, sniffedType);
+        return mime;
+    }
+
     // No rules matched the extension for the mime type,
     // remove mime type and ask BeOS to set the correct type
     // This will also take place in case the rules file could not be opened (deleted,renamed or moved etc)
@@ -40,6 +40,8 @@ BeezerListView::BeezerListView(BRect frame, CLVContainerView** containerView, co
 {
     m_contextMenu = NULL;
     m_cachedCount = -1L;
+    m_cachedBytes = 0;
+    m_totalsGeneration = ItemsGeneration();
     m_sendSelectionMessage = true;
 
     // The following are related to drag-drop from outside sources (like Tracker)
@@ -139,10 +141,7 @@ void BeezerListView::KeyDown(const char* bytes, int32 numBytes)
         // Remove selection when user presses left/right without SHIFT when all items are selected
         if (bytes[0] == B_ESCAPE || bytes[0] == B_LEFT_ARROW || bytes[0] == B_RIGHT_ARROW)
         {
-            int32 i = 0;
-            while (FullListCurrentSelection(i) >= 0)
-                i++;
-
+            int32 i = CountSelectedItems();
             if ((i == FullListCountItems() || i == CountItems()) && i > 1)
             {
                 DeselectAll();
@@ -151,18 +150,7 @@ void BeezerListView::KeyDown(const char* bytes, int32 numBytes)
         }
         else
         {
-            // Don't mind the repeat of the above code as this is for performance, by duplicating
-            // (almost if (i>1) is extra) we avoid recounting items when user presses up/down which
-            // will be the MOST frequently used keys we count only on "rarer" keys like ESCAPE,LEFT,RIGHT
-            int32 i = 0;
-            while (FullListCurrentSelection(i) >= 0)
-            {
-                i++;
-                if (i > 1)
-                    break;
-            }
-
-            if (i > 1)
+            if (CountSelectedItems() > 1)
             {
                 // User is allowed to move up/down when everything is selected - left/right deselects though
                 BScrollBar* vScrollBar = ScrollBar(B_VERTICAL);
@@ -188,25 +176,14 @@ void BeezerListView::KeyDown(const char* bytes, int32 numBytes)
     {
         case B_RIGHT_ARROW: case B_LEFT_ARROW: case B_ENTER:
         {
-            // Calculate selection again - speed boost as we calculate (count) selection only
-            // when user presses LEFT/RIGHT ARROW/ENTER not up/down which will be used all the time
-            int32 i = 0;
-            while (FullListCurrentSelection(i) >= 0)     // No need to count fully here as we only check
-            {
-                // if more than one selection is present
-                i++;
-                if (i > 1)
-                    break;
-            }
-
             // Don't collapse folders when multi-selection is there and user pressed LEFT arrow
-            if (i > 1 && (bytes[0] == B_LEFT_ARROW || bytes[0] == B_RIGHT_ARROW))
+            if (CountSelectedItems() > 1 && (bytes[0] == B_LEFT_ARROW || bytes[0] == B_RIGHT_ARROW))
                 break;
 
             // When shift is NOT held down, pretty confusing?
             if ((modifiers() & B_SHIFT_KEY) == 0)        // removed i == 1 &&
             {
-                CLVListItem* item = FullListItemAt(FullListCurrentSelection(0L));
+                CLVListItem* item = SelectedItemAt(0L);
                 if (!item)
                     return;
 
@@ -404,7 +381,7 @@ void BeezerListView::MouseDown(BPoint point)
     previousButton = button;
 
     if (clickCount == 1L && (point.y >= previousPoint.y - 3 && point.y <= previousPoint.y + 3)
-            && FullListCurrentSelection() == FullListIndexOf(point))         // Make sure mouse is over selection
+            && SelectedItemAt(0L) == ItemAt(IndexOf(point)))         // Make sure mouse is over selection
     {
         clickCount = 0;
         BMessage msg2(M_ENTER);
@@ -456,7 +433,7 @@ void BeezerListView::MouseDown(BPoint point)
         CLVEasyItem* selItem = NULL;
         int32 i = 0L;
 
-        while ((selItem = (CLVEasyItem*)FullListItemAt(FullListCurrentSelection(i++))) != NULL)
+        while ((selItem = (CLVEasyItem*)SelectedItemAt(i++)) != NULL)
         {
             if (selItem->IsSuperItem() == false)
             {
@@ -484,16 +461,16 @@ void BeezerListView::MouseDown(BPoint point)
 }
 
 
-void BeezerListView::PostSelectionMessage(int32* count, uint32* bytes)
+void BeezerListView::PostSelectionMessage(int32* count, off_t* bytes)
 {
     BMessage msg(M_SELECTION_CHANGED);
     msg.AddInt32(kCount, *count);
-    msg.AddInt64(kBytes, (int64)(*bytes));
+    msg.AddInt64(kBytes, *bytes);
     Window()->PostMessage(&msg);
 }
 
 
-void BeezerListView::SelectionChanged(int32* count, uint32* bytes)
+void BeezerListView::SelectionChanged(int32* count, off_t* bytes)
 {
     // An extra SelectionChanged that doesn't recount bytes - for performance
     // We leave the OLD SelectionChanged() as IT IS (it will recount bytes whenever called)
@@ -502,30 +479,36 @@ void BeezerListView::SelectionChanged(int32* count, uint32* bytes)
     {
         PostSelectionMessage(count, bytes);
         m_cachedCount = *count;
+        m_cachedBytes = *bytes;
     }
 }
 
 
 void BeezerListView::SelectionChanged()
 {
+    ColumnListView::SelectionChanged();
+
     // Notify our parent window about changes with the selection
     if (m_sendSelectionMessage)
     {
         ListEntry* item = NULL;
         int32 i(0);
-        uint32 val(0);
-        while ((item = (ListEntry*)FullListItemAt(FullListCurrentSelection(i++))) != NULL)
-            val += item->m_length;
+        off_t val(0);
+        UpdateSubtreeTotals();
+        while ((item = (ListEntry*)SelectedItemAt(i++)) != NULL)
+            val += EntryBytes(item);
 
         int32 temp = i - 1;
         PostSelectionMessage(&temp, &val);
 
-        // For speed cache the number of selected items
+        // For speed cache the number of selected items and their size
         // Also send the kCount and kBytes so that MainWindow's UpdateInfoBar()
         // need not calculate it again
         m_cachedCount = temp;
+        m_cachedBytes = val;
     }
-    ColumnListView::SelectionChanged();
+    else
+        m_cachedCount = -1L;
 }
 
 
@@ -536,6 +519,12 @@ void BeezerListView::SelectSubItems(CLVListItem* superItem)
     bool t = m_sendSelectionMessage;
     m_sendSelectionMessage = false;
 
+    // Add what gets newly selected to the cached totals instead of recounting the whole selection
+    bool const cached = m_cachedCount != -1;
+    int32 selCount = m_cachedCount;
+    off_t bytes = m_cachedBytes;
+    UpdateSubtreeTotals();
+
     uint32 parentLevel = superItem->OutlineLevel();
     int32 itemPos = FullListIndexOf(superItem);
     int32 i = 0L;
@@ -548,10 +537,13 @@ void BeezerListView::SelectSubItems(CLVListItem* superItem)
             if (subItem == NULL || subItem->OutlineLevel() <= parentLevel)
                 break;
 
-            if (subItem->IsSelected() == false)
+            int32 index = IndexOf(subItem);
+            if (index >= 0 && subItem->IsSelected() == false)
             {
                 selected = true;
-                Select(IndexOf(subItem), true);
+                selCount++;
+                bytes += EntryBytes((ListEntry*)subItem);
+                Select(index, true);
                 UpdateWindow();
             }
         }
@@ -562,7 +554,12 @@ void BeezerListView::SelectSubItems(CLVListItem* superItem)
     // Optimize sending of messages (faster), send only if the selection was actually CHANGED where
     // selected will be set to true
     if (selected == true)
-        SelectionChanged();
+    {
+        if (cached)
+            SelectionChanged(&selCount, &bytes);
+        else
+            SelectionChanged();
+    }
 }
 
 
@@ -573,6 +570,12 @@ void BeezerListView::DeselectSubItems(CLVListItem* superItem)
     bool t = m_sendSelectionMessage;
     m_sendSelectionMessage = false;
 
+    // Take what gets deselected off the cached totals instead of recounting the whole selection
+    bool const cached = m_cachedCount != -1;
+    int32 selCount = m_cachedCount;
+    off_t bytes = m_cachedBytes;
+    UpdateSubtreeTotals();
+
     uint32 parentLevel = superItem->OutlineLevel();
     int32 itemPos = FullListIndexOf(superItem);
     int32 i = 0L;
@@ -584,13 +587,22 @@ void BeezerListView::DeselectSubItems(CLVListItem* superItem)
             if (subItem == NULL || subItem->OutlineLevel() <= parentLevel)
                 break;
 
+            if (subItem->IsSelected())
+            {
+                selCount--;
+                bytes -= EntryBytes((ListEntry*)subItem);
+            }
+
             Deselect(IndexOf(subItem));
             UpdateWindow();
         }
     }
 
     m_sendSelectionMessage = t;
-    SelectionChanged();
+    if (cached)
+        SelectionChanged(&selCount, &bytes);
+    else
+        SelectionChanged();
 }
 
 
@@ -608,7 +620,8 @@ void BeezerListView::InvertSelection()
 
     int32 count = CountItems();
     int32 selCount = 0L;
-    uint32 bytes = 0L;
+    off_t bytes = 0L;
+    UpdateSubtreeTotals();
     for (int32 i = 0; i < count; i++)
     {
         if (ItemAt(i)->IsSelected())
@@ -616,7 +629,7 @@ void BeezerListView::InvertSelection()
         else
         {
             ListEntry* item = reinterpret_cast<ListEntry*>(ItemAt(i));
-            bytes += item->m_length;
+            bytes += EntryBytes(item);
             selCount++;
             Select(i, true);
         }
@@ -626,7 +639,7 @@ void BeezerListView::InvertSelection()
 
     m_sendSelectionMessage = t;
     // Optimized counting here too - for those terribly large archives
-    PostSelectionMessage(&selCount, &bytes);
+    SelectionChanged(&selCount, &bytes);
 }
 
 
@@ -637,21 +650,20 @@ void BeezerListView::SelectAll()
     m_sendSelectionMessage = false;
 
     int32 count = CountItems();
-    uint32 bytes = 0L;
+    off_t bytes = 0L;
+    UpdateSubtreeTotals();
     for (int32 i = 0; i < count; i++)
     {
-        // Later maybe count the bytes here itself and pass it as a parameter to a new
-        // SelectionChanged() function maybe?? It will improve speed drastically as
-        // SelectionChanged() need not reloop to recount bytes
+        // Count the bytes here itself so that SelectionChanged() need not reloop to recount them
         ListEntry* item = reinterpret_cast<ListEntry*>(ItemAt(i));
-        bytes += item->m_length;
+        bytes += EntryBytes(item);
 
         Select(i, true);
         UpdateWindow();
     }
 
     m_sendSelectionMessage = t;
-    PostSelectionMessage(&count, &bytes);
+    SelectionChanged(&count, &bytes);
 }
 
 
@@ -664,7 +676,28 @@ void BeezerListView::DeselectAll()
     ColumnListView::DeselectAll();
 
     m_sendSelectionMessage = t;
-    SelectionChanged();
+    int32 count = 0L;
+    off_t bytes = 0L;
+    SelectionChanged(&count, &bytes);
+}
+
+
+void BeezerListView::Expand(CLVListItem* item)
+{
+    ColumnListView::Expand(item);
+
+    // A selected folder stands for its contents only while it is collapsed
+    if (item->IsSelected())
+        SelectionChanged();
+}
+
+
+void BeezerListView::Collapse(CLVListItem* item)
+{
+    ColumnListView::Collapse(item);
+
+    if (item->IsSelected())
+        SelectionChanged();
 }
 
 
@@ -710,7 +743,7 @@ void BeezerListView::ToggleSelectedSuperItems(bool expand)
 
     CLVListItem* selEntry = NULL;
     int32 i = 0L;
-    while ((selEntry = FullListItemAt(FullListCurrentSelection(i++))) != NULL)
+    while ((selEntry = SelectedItemAt(i++)) != NULL)
     {
         if (selEntry->IsSuperItem())
             (this->*toggleFunc)(selEntry);
@@ -778,7 +811,7 @@ int32 BeezerListView::Search(const BMessage* message, const char*& errorString)
             CLVEasyItem* selItem = NULL;
             int32 i = 0L;
 
-            while ((selItem = (CLVEasyItem*)FullListItemAt(FullListCurrentSelection(i++))) != NULL)
+            while ((selItem = (CLVEasyItem*)SelectedItemAt(i++)) != NULL)
                 selectedItemsList.AddItem((void*)selItem);
         }
 
@@ -826,7 +859,7 @@ int32 BeezerListView::Search(const BMessage* message, const char*& errorString)
         int32 i = 0L;
 
         // Search through selection without modifying the selections
-        while ((selectedItem = (CLVEasyItem*)FullListItemAt(FullListCurrentSelection(i++))) != NULL)
+        while ((selectedItem = (CLVEasyItem*)SelectedItemAt(i++)) != NULL)
         {
             const char* columnText = selectedItem->GetColumnContentText(columnIndex);
             if (!columnText)
@@ -892,7 +925,7 @@ void BeezerListView::CopyToClipboard(char columnSeparator)
     CLVEasyItem* selectedItem = NULL;
     int32 i = 0L;
 
-    while ((selectedItem = (CLVEasyItem*)FullListItemAt(FullListCurrentSelection(i++))) != NULL)
+    while ((selectedItem = (CLVEasyItem*)SelectedItemAt(i++)) != NULL)
     {
         for (int32 j = 0; j < nVisibleColumns; j++)
         {
@@ -1082,7 +1115,7 @@ void BeezerListView::SelectSubItemsOfSelection(bool select)
 
     // Hold currently selected items in a list, then modify the selection, if we do both in the same
     // loop we may end up in an infinite loop as adding selections will keep the loop going
-    while ((item = FullListItemAt(FullListCurrentSelection(i++))) != NULL)
+    while ((item = SelectedItemAt(i++)) != NULL)
         originalSelectionList.AddItem((void*)item);
 
     // Select the folder level of the selected items
@@ -1110,30 +1143,94 @@ void BeezerListView::SelectSubItemsOfSelection(bool select)
 int32 BeezerListView::FullListSelectionCount() const
 {
     // Return the number of items selected in full list
-    int32 count = 0L, i = 0L;
-    while (FullListCurrentSelection(i++) >= 0L)
-        count++;
-
-    return count;
+    return CountSelectedItems();
 }
 
 
 int32 BeezerListView::SelectionCount() const
 {
-    int32 count = 0L, i = 0L;
-    while (CurrentSelection(i++) >= 0L)
-        count++;
-
-    return count;
+    return CountSelectedItems();
 }
 
 
 bool BeezerListView::HasSelection() const
 {
-    int32 i = 0L;
-    while (FullListCurrentSelection(i++) >= 0L)
-        return true;
-    return false;
+    return CurrentSelection(0L) >= 0L;
+}
+
+
+off_t BeezerListView::EntryBytes(ListEntry* item)
+{
+    // What an entry adds to the selected bytes, a collapsed folder brings in everything under it
+    // as its subitems can't be selected on their own then
+    if (item->IsSuperItem() == false)
+        return item->m_length;
+
+    if (item->IsExpanded())
+        return 0;
+
+    UpdateSubtreeTotals();
+    return item->m_subtreeLength;
+}
+
+
+void BeezerListView::UpdateSubtreeTotals()
+{
+    // Sum up every folder's contents in one pass over the full list; folders are closed once an
+    // item at their level or above shows up and their totals are then added to their parent's
+    if (m_totalsGeneration == ItemsGeneration())
+        return;
+
+    BList openFolders;
+    int32 const count = FullListCountItems();
+    for (int32 i = 0; i <= count; i++)
+    {
+        ListEntry* item = i < count ? (ListEntry*)FullListItemAt(i) : NULL;
+        while (openFolders.IsEmpty() == false)
+        {
+            ListEntry* folder = (ListEntry*)openFolders.LastItem();
+            if (item != NULL && folder->OutlineLevel() < item->OutlineLevel())
+                break;
+
+            openFolders.RemoveItem(openFolders.CountItems() - 1);
+            ListEntry* parent = (ListEntry*)openFolders.LastItem();
+            if (parent != NULL)
+            {
+                parent->m_subtreeLength += folder->m_subtreeLength;
+                parent->m_subtreeFiles += folder->m_subtreeFiles;
+                parent->m_subtreeFolders += folder->m_subtreeFolders + 1;
+            }
+        }
+
+        if (item == NULL)
+            break;
+
+        if (item->IsSuperItem())
+        {
+            item->m_subtreeLength = 0;
+            item->m_subtreeFiles = 0;
+            item->m_subtreeFolders = 0;
+            openFolders.AddItem(item);
+        }
+        else
+        {
+            ListEntry* parent = (ListEntry*)openFolders.LastItem();
+            if (parent != NULL)
+            {
+                parent->m_subtreeLength += item->m_length;
+                parent->m_subtreeFiles++;
+            }
+        }
+    }
+
+    m_totalsGeneration = ItemsGeneration();
+}
+
+
+void BeezerListView::InvalidateSubtreeTotals()
+{
+    // For when entries already in the list change their size
+    m_totalsGeneration = ItemsGeneration() - 1;
 }
 
 
@@ -1249,7 +1346,7 @@ void BeezerListView::CountSelectionDumb(int32& subItems, int32& superItems)
     ListEntry* selEntry(NULL);
     int32 i = 0L, fileCount = 0L, folderCount = 0L;
 
-    while ((selEntry = (ListEntry*)FullListItemAt(FullListCurrentSelection(i))) != NULL)
+    while ((selEntry = (ListEntry*)SelectedItemAt(i)) != NULL)
     {
         if (selEntry->IsSuperItem() == false)
             fileCount++;
@@ -1269,8 +1366,9 @@ void BeezerListView::CountSelectionSmart(int32& subItems, int32& superItems)
     // Recurse into folders only when folder items are collapsed
     ListEntry* selEntry(NULL);
     int32 i = 0L, fileCount = 0L, folderCount = 0L;
+    UpdateSubtreeTotals();
 
-    while ((selEntry = (ListEntry*)FullListItemAt(FullListCurrentSelection(i))) != NULL)
+    while ((selEntry = (ListEntry*)SelectedItemAt(i)) != NULL)
     {
         if (selEntry->IsSuperItem() == false)
             fileCount++;
@@ -1280,8 +1378,11 @@ void BeezerListView::CountSelectionSmart(int32& subItems, int32& superItems)
 
             // If a folder is collapsed and selected add all its subitems to our message
             // this is done in "Smart" version of this counting function
-            //if (selEntry->IsExpanded() == false)
-            //    CountSubItemsOf (fileCount, folderCount, (CLVListItem*)selEntry);
+            if (selEntry->IsExpanded() == false)
+            {
+                fileCount += selEntry->m_subtreeFiles;
+                folderCount += selEntry->m_subtreeFolders;
+            }
         }
         i++;
     }
@@ -1329,7 +1430,8 @@ void BeezerListView::SelectAllEx(bool superItems)
 
     int32 count = CountItems();
     int32 selCount = 0L;
-    uint32 bytes = 0L;
+    off_t bytes = 0L;
+    UpdateSubtreeTotals();
 
     for (int32 i = 0; i < count; i++)
     {
@@ -1338,7 +1440,7 @@ void BeezerListView::SelectAllEx(bool superItems)
         if (item->IsSuperItem() == superItems)
         {
             selCount++;
-            bytes += item->m_length;
+            bytes += EntryBytes(item);
             Select(i, true);
         }
 
@@ -1348,7 +1450,7 @@ void BeezerListView::SelectAllEx(bool superItems)
     m_sendSelectionMessage = t;
 
     // Optimized counting for large archives
-    PostSelectionMessage(&selCount, &bytes);
+    SelectionChanged(&selCount, &bytes);
 }
 
 
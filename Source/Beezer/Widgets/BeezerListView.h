@@ -27,12 +27,14 @@ class BeezerListView : public ColumnListView
         virtual void        MouseMoved(BPoint point, uint32 status, const BMessage* message);
         virtual void        SelectionChanged();
         virtual void        DeselectAll();
+        virtual void        Expand(CLVListItem* item);
+        virtual void        Collapse(CLVListItem* item);
         virtual bool        InitiateDrag(BPoint point, int32 index, bool wasSelected);
         virtual void        MessageReceived(BMessage* message);
 
         // Additional hooks
-        void                SelectionChanged(int32* count, uint32* bytes);
-        void                PostSelectionMessage(int32* count, uint32* bytes);
+        void                SelectionChanged(int32* count, off_t* bytes);
+        void                PostSelectionMessage(int32* count, off_t* bytes);
         void                GetState(BMessage& msg) const;
         void                SetState(BMessage* msg);
         void                SendSelectionMessage(bool send);
@@ -53,6 +55,9 @@ class BeezerListView : public ColumnListView
         void                CountSelectionDumb(int32& subItems, int32& superItems);
         void                CopyToClipboard(char columnSeparator);
         bool                HasSelection() const;
+        off_t               EntryBytes(ListEntry* item);
+        void                UpdateSubtreeTotals();
+        void                InvalidateSubtreeTotals();
 
         // Static functions
         static int          SortFunction(const CLVListItem* a, const CLVListItem* b, BList* columnList,
@@ -70,6 +75,8 @@ class BeezerListView : public ColumnListView
         float               m_dropY;
         ListEntry*          m_dropItem;
         int32               m_cachedCount;
+        off_t               m_cachedBytes;
+        uint32              m_totalsGeneration;
 };
 
 #endif /* _BEEZER_LIST_VIEW_H */
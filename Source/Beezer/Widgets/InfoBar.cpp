@@ -121,7 +121,7 @@ void InfoBar::UpdateFilesDisplay(int32 selectedCount, int32 totalCount, bool set
 }
 
 
-void InfoBar::UpdateBytesDisplay(uint32 selectedBytes, uint32 totalBytes, bool setTotalBytes)
+void InfoBar::UpdateBytesDisplay(off_t selectedBytes, off_t totalBytes, bool setTotalBytes)
 {
     if (setTotalBytes == true)
         m_totalBytes = totalBytes;
@@ -145,7 +145,7 @@ void InfoBar::UpdateBytesDisplay(uint32 selectedBytes, uint32 totalBytes, bool s
 }
 
 
-void InfoBar::UpdateBy(int32 countBy, uint32 bytesBy)
+void InfoBar::UpdateBy(int32 countBy, off_t bytesBy)
 {
     UpdateFilesDisplay(m_selectedFiles + countBy, m_filesTotal, false);
     UpdateBytesDisplay(m_selectedBytes + bytesBy, m_totalBytes, false);
@@ -25,8 +25,8 @@ class InfoBar : public BView
         // Additional hooks
         virtual void        Redraw();
         virtual void        UpdateFilesDisplay(int32 selectedCount, int32 totalCount, bool setTotalCount);
-        virtual void        UpdateBytesDisplay(uint32 selectedCount, uint32 totalBytes, bool setTotalBytes);
-        virtual void        UpdateBy(int32 countBy, uint32 bytesBy);
+        virtual void        UpdateBytesDisplay(off_t selectedBytes, off_t totalBytes, bool setTotalBytes);
+        virtual void        UpdateBy(int32 countBy, off_t bytesBy);
         virtual void        Toggle();
         virtual bool        IsShown() const;
         virtual float       Height() const;
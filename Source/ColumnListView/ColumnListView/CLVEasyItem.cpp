@@ -60,7 +60,6 @@ enum
     CLVColTypesMask =           0x00000007,
 
     CLVColFlagBitmapIsCopy =    0x00000008,
-    CLVColFlagNeedsTruncation =    0x00000010,
     CLVColFlagRightJustify =    0x00000020
 };
 
@@ -73,154 +72,148 @@ CLVEasyItem::CLVEasyItem(uint32 level, bool superitem, bool expanded, float minh
 {
     text_offset = 0.0;
     full_line_select = fullLineSelect;    // Ram
+    m_columns = NULL;
+    m_column_count = 0;
+    m_column_capacity = 0;
 }
 
 
 CLVEasyItem::~CLVEasyItem()
 {
-    int num_columns = m_column_types.CountItems();
-    for (int column = 0; column < num_columns; column++)
-    {
-        int32 type = *m_column_types.ItemAt(column);
-        bool bitmap_is_copy = false;
-        if (type & CLVColFlagBitmapIsCopy)
-            bitmap_is_copy = true;
-        type &= CLVColTypesMask;
-        if (type ==     CLVColStaticText || type == CLVColTruncateText)
-            delete[]((char*)m_column_content.ItemAt(column));
-        if (type == CLVColTruncateText)
-            delete[]((char*)m_aux_content.ItemAt(column));
-        if (type == CLVColBitmap && bitmap_is_copy)
-            delete((BBitmap*)m_column_content.ItemAt(column));
-        delete(BRect*)m_cached_rects.ItemAt(column);
-    }
+    for (int32 column = 0; column < m_column_count; column++)
+        FreeSlotContent(&m_columns[column]);
+    delete[] m_columns;
+}
+
+
+void CLVEasyItem::FreeSlotContent(ColumnSlot* slot)
+{
+    int32 type = slot->type & CLVColTypesMask;
+    if (type == CLVColStaticText || type == CLVColTruncateText)
+        delete[]((char*)slot->content);
+    else if (type == CLVColBitmap && (slot->type & CLVColFlagBitmapIsCopy))
+        delete((BBitmap*)slot->content);
+    slot->type = CLVColNone;
+    slot->content = NULL;
+    slot->truncated_text = NULL;
+    slot->truncated_width = -1;
+    slot->bitmap_offset = 0;
 }
 
 
-void CLVEasyItem::PrepListsForSet(int column_index)
+CLVEasyItem::ColumnSlot* CLVEasyItem::PrepSlotForSet(int column_index)
 {
-    int cur_num_columns = m_column_types.CountItems();
-    bool delete_old = (cur_num_columns >= column_index - 1);
-    while (cur_num_columns <= column_index)
+    if (column_index >= m_column_capacity)
     {
-        m_column_types.AddItem(new int32(CLVColNone));
-        m_column_content.AddItem(NULL);
-        m_aux_content.AddItem(NULL);
-        m_cached_rects.AddItem(new BRect(-1, -1, -1, -1));
-        cur_num_columns++;
+        //Grow the slot array, items usually get their columns set one after the other
+        int32 new_capacity = m_column_capacity > 0 ? m_column_capacity * 2 : 4;
+        if (new_capacity <= column_index)
+            new_capacity = column_index + 1;
+        ColumnSlot* new_columns = new ColumnSlot[new_capacity];
+        for (int32 column = 0; column < m_column_count; column++)
+            new_columns[column] = m_columns[column];
+        delete[] m_columns;
+        m_columns = new_columns;
+        m_column_capacity = new_capacity;
     }
-    if (delete_old)
+    while (m_column_count <= column_index)
     {
-        //Column content exists already so delete the old entries
-        int32 old_type = *m_column_types.ItemAt(column_index);
-        bool bitmap_is_copy = false;
-        if (old_type & CLVColFlagBitmapIsCopy)
-            bitmap_is_copy = true;
-        old_type &= CLVColTypesMask;
-
-        void* old_content = m_column_content.ItemAt(column_index);
-        char* old_truncated = (char*)m_aux_content.ItemAt(column_index);
-        if (old_type == CLVColStaticText || old_type == CLVColTruncateText)
-            delete[]((char*)old_content);
-        if (old_type == CLVColTruncateText)
-            delete[] old_truncated;
-        if (old_type == CLVColBitmap && bitmap_is_copy)
-            delete((BBitmap*)old_content);
-        ((BRect**)m_cached_rects.Items())[column_index]->Set(-1, -1, -1, -1);
+        ColumnSlot* slot = &m_columns[m_column_count++];
+        slot->type = CLVColNone;
+        slot->content = NULL;
+        slot->truncated_text = NULL;
+        slot->truncated_width = -1;
+        slot->bitmap_offset = 0;
+        slot->cached_rect.Set(-1, -1, -1, -1);
     }
+
+    //Column content may exist already so delete the old entry
+    ColumnSlot* slot = &m_columns[column_index];
+    FreeSlotContent(slot);
+    slot->cached_rect.Set(-1, -1, -1, -1);
+    return slot;
 }
 
 
 void CLVEasyItem::SetColumnContent(int column_index, const char* text, bool truncate, bool right_justify)
 {
-    PrepListsForSet(column_index);
+    ColumnSlot* slot = PrepSlotForSet(column_index);
 
     //Create the new entry
-    ((BRect**)m_cached_rects.Items())[column_index]->Set(-1, -1, -1, -1);
     if (text == NULL || text[0] == 0)
-    {
-        m_column_types.ReplaceItem(column_index, new int32(CLVColNone));
-        ((char**)m_column_content.Items())[column_index] = NULL;
-        ((char**)m_aux_content.Items())[column_index] = NULL;
-    }
+        return;
+
+    //The full text and the room for its truncated form share one allocation
+    size_t length = strlen(text);
+    char* copy = new char[truncate ? 2 * length + 4 : length + 1];
+    memcpy(copy, text, length + 1);
+    slot->content = copy;
+
+    if (!truncate)
+        slot->type = CLVColStaticText;
     else
     {
-        char* copy = Strdup_new(text);
-        ((char**)m_column_content.Items())[column_index] = copy;
-
-        if (!truncate)
-        {
-            m_column_types.ReplaceItem(column_index, new int32(CLVColStaticText));
-            ((char**)m_aux_content.Items())[column_index] = NULL;
-        }
-        else
-        {
-            m_column_types.ReplaceItem(column_index, new int32(CLVColTruncateText|CLVColFlagNeedsTruncation));
-            copy = new char[strlen(text)+3];
-            strcpy(copy, text);
-            ((char**)m_aux_content.Items())[column_index] = copy;
-        }
-        if (right_justify)
-            m_column_types.ReplaceItem(column_index, new int32(*m_column_types.ItemAt(column_index) | CLVColFlagRightJustify));
+        slot->type = CLVColTruncateText;
+        slot->truncated_text = copy + length + 1;
+        memcpy(slot->truncated_text, text, length + 1);
     }
+    if (right_justify)
+        slot->type |= CLVColFlagRightJustify;
 }
 
 
 void CLVEasyItem::SetColumnContent(int column_index, const BBitmap* bitmap, float horizontal_offset, bool copy,
                                    bool right_justify)
 {
-    PrepListsForSet(column_index);
+    ColumnSlot* slot = PrepSlotForSet(column_index);
 
     //Create the new entry
     if (bitmap == NULL)
-    {
-        m_column_types.ReplaceItem(column_index, new int32(CLVColNone));
-        ((char**)m_column_content.Items())[column_index] = NULL;
-        ((char**)m_aux_content.Items())[column_index] = NULL;
-    }
+        return;
+
+    if (copy)
+        slot->type = CLVColBitmap|CLVColFlagBitmapIsCopy;
     else
+        slot->type = CLVColBitmap;
+    if (right_justify)
+        slot->type |= CLVColFlagRightJustify;
+    BBitmap* the_bitmap;
+    if (copy)
     {
-        if (copy)
-            m_column_types.ReplaceItem(column_index, new int32(CLVColBitmap|CLVColFlagBitmapIsCopy));
-        else
-            m_column_types.ReplaceItem(column_index, new int32(CLVColBitmap));
-        if (right_justify)
-            m_column_types.ReplaceItem(column_index, new int32(*m_column_types.ItemAt(column_index) | CLVColFlagRightJustify));
-        BBitmap* the_bitmap;
-        if (copy)
-        {
-            the_bitmap = new BBitmap(bitmap->Bounds(), bitmap->ColorSpace());
-            int32 copy_ints = bitmap->BitsLength() / 4;
-            int32* source = (int32*)bitmap->Bits();
-            int32* dest = (int32*)the_bitmap->Bits();
-            for (int32 i = 0; i < copy_ints; i++)
-                dest[i] = source[i];
-        }
-        else
-            the_bitmap = (BBitmap*)bitmap;
-        ((BBitmap**)m_column_content.Items())[column_index] = the_bitmap;
-        ((int32*)m_aux_content.Items())[column_index] = (int32)horizontal_offset;
+        the_bitmap = new BBitmap(bitmap->Bounds(), bitmap->ColorSpace());
+        int32 copy_ints = bitmap->BitsLength() / 4;
+        int32* source = (int32*)bitmap->Bits();
+        int32* dest = (int32*)the_bitmap->Bits();
+        for (int32 i = 0; i < copy_ints; i++)
+            dest[i] = source[i];
     }
+    else
+        the_bitmap = (BBitmap*)bitmap;
+    slot->content = the_bitmap;
+    slot->bitmap_offset = (float)((int32)horizontal_offset);
 }
 
 
 void CLVEasyItem::SetColumnUserTextContent(int column_index, bool truncate, bool right_justify)
 {
-    PrepListsForSet(column_index);
+    ColumnSlot* slot = PrepSlotForSet(column_index);
     if (truncate)
-        m_column_types.ReplaceItem(column_index, new int32(CLVColTruncateUserText));
+        slot->type = CLVColTruncateUserText;
     else
-        m_column_types.ReplaceItem(column_index, new int32(CLVColUserText));
+        slot->type = CLVColUserText;
     if (right_justify)
-            m_column_types.ReplaceItem(column_index, new int32(*m_column_types.ItemAt(column_index) | CLVColFlagRightJustify));
+        slot->type |= CLVColFlagRightJustify;
 }
 
 
 const char* CLVEasyItem::GetColumnContentText(int column_index)
 {
-    int32 type = (*m_column_types.ItemAt(column_index)) & CLVColTypesMask;
+    ColumnSlot* slot = SlotAt(column_index);
+    if (slot == NULL)
+        return NULL;
+    int32 type = slot->type & CLVColTypesMask;
     if (type == CLVColStaticText || type == CLVColTruncateText)
-        return (char*)m_column_content.ItemAt(column_index);
+        return (char*)slot->content;
     if (type == CLVColTruncateUserText || type == CLVColUserText)
         return GetUserText(column_index, -1);
     return NULL;
@@ -229,10 +222,10 @@ const char* CLVEasyItem::GetColumnContentText(int column_index)
 
 const BBitmap* CLVEasyItem::GetColumnContentBitmap(int column_index)
 {
-    int32 type = (*m_column_types.ItemAt(column_index)) & CLVColTypesMask;
-    if (type != CLVColBitmap)
+    ColumnSlot* slot = SlotAt(column_index);
+    if (slot == NULL || (slot->type & CLVColTypesMask) != CLVColBitmap)
         return NULL;
-    return (BBitmap*)m_column_content.ItemAt(column_index);
+    return (BBitmap*)slot->content;
 }
 
 
@@ -267,7 +260,7 @@ void CLVEasyItem::DrawItemColumn(BView* owner, BRect item_column_rect, int32 col
             rect.left += 2.0;
             rect.top += text_offset - ceil(FontAttributes.ascent);
             rect.bottom -= ((text_offset - ceil(FontAttributes.ascent)) / 2.0);
-            rect.right = rect.left + owner->StringWidth((char*)m_column_content.ItemAt(2)) + 6.0;
+            rect.right = rect.left + owner->StringWidth(GetColumnContentText(2)) + 6.0;
 
             owner->FillRect(rect);
         }
@@ -282,12 +275,10 @@ void CLVEasyItem::DrawItemColumn(BView* owner, BRect item_column_rect, int32 col
     if (column_index == -1)
         return;
 
-    int32 type = *m_column_types.ItemAt(column_index);
-    if (type == 0)
+    ColumnSlot* slot = SlotAt(column_index);
+    if (slot == NULL || slot->type == 0)
         return;
-    bool needs_truncation = false;
-    if (type & CLVColFlagNeedsTruncation)
-        needs_truncation = true;
+    int32 type = slot->type;
     bool right_justify = false;
     if (type & CLVColFlagRightJustify)
         right_justify = true;
@@ -297,9 +288,7 @@ void CLVEasyItem::DrawItemColumn(BView* owner, BRect item_column_rect, int32 col
     Region.Include(item_column_rect);
     owner->ConstrainClippingRegion(&Region);
 
-    BRect* cached_rect = (BRect*)m_cached_rects.ItemAt(column_index);
-    if (cached_rect != NULL)
-        *cached_rect = item_column_rect;
+    slot->cached_rect = item_column_rect;
 
     if (type == CLVColStaticText || type == CLVColTruncateText || type == CLVColTruncateUserText ||
             type == CLVColUserText)
@@ -328,17 +317,17 @@ void CLVEasyItem::DrawItemColumn(BView* owner, BRect item_column_rect, int32 col
 
         if (type == CLVColTruncateText)
         {
-            if (needs_truncation)
+            //Truncated lazily, only rows that get drawn at a new width pay for it
+            if (slot->truncated_width != item_column_rect.right - item_column_rect.left)
             {
                 BFont owner_font;
                 owner->GetFont(&owner_font);
                 TruncateText(column_index, item_column_rect.right - item_column_rect.left, &owner_font);
-                m_column_types.ReplaceItem(column_index, new int32(*m_column_types.ItemAt(column_index) & (CLVColFlagNeedsTruncation^0xFFFFFFFF)));
             }
-            text = (const char*)m_aux_content.ItemAt(column_index);
+            text = slot->truncated_text;
         }
         else if (type == CLVColStaticText)
-            text = (const char*)m_column_content.ItemAt(column_index);
+            text = (const char*)slot->content;
         else if (type == CLVColTruncateUserText)
             text = GetUserText(column_index, item_column_rect.right - item_column_rect.left);
         else if (type == CLVColUserText)
@@ -366,9 +355,9 @@ void CLVEasyItem::DrawItemColumn(BView* owner, BRect item_column_rect, int32 col
     }
     else if (type == CLVColBitmap)
     {
-        const BBitmap* bitmap = (BBitmap*)m_column_content.ItemAt(column_index);
+        const BBitmap* bitmap = (BBitmap*)slot->content;
         BRect bounds = bitmap->Bounds();
-        float horizontal_offset = (float)((intptr_t)m_aux_content.ItemAt(column_index));
+        float horizontal_offset = slot->bitmap_offset;
         if (!right_justify)
         {
             item_column_rect.left += horizontal_offset;
@@ -399,6 +388,10 @@ void CLVEasyItem::Update(BView* owner, const BFont* font)
     owner_font.GetHeight(&FontAttributes);
     float FontHeight = ceil(FontAttributes.ascent) + ceil(FontAttributes.descent);
     text_offset = ceil(FontAttributes.ascent) + (Height() - FontHeight) / 2.0;
+
+    //The font may have changed, so truncate again on the next draw
+    for (int32 column = 0; column < m_column_count; column++)
+        m_columns[column].truncated_width = -1;
 }
 
 
@@ -406,12 +399,12 @@ int CLVEasyItem::CompareItems(const CLVListItem* a_Item1, const CLVListItem* a_I
 {
     const CLVEasyItem* Item1 = cast_as(a_Item1, const CLVEasyItem);
     const CLVEasyItem* Item2 = cast_as(a_Item2, const CLVEasyItem);
-    if (Item1 == NULL || Item2 == NULL || Item1->m_column_types.CountItems() <= KeyColumn ||
-            Item2->m_column_types.CountItems() <= KeyColumn)
+    if (Item1 == NULL || Item2 == NULL || Item1->m_column_count <= KeyColumn ||
+            Item2->m_column_count <= KeyColumn)
         return 0;
 
-    int32 type1 = (*Item1->m_column_types.ItemAt(KeyColumn)) & CLVColTypesMask;
-    int32 type2 = (*Item2->m_column_types.ItemAt(KeyColumn)) & CLVColTypesMask;
+    int32 type1 = Item1->m_columns[KeyColumn].type & CLVColTypesMask;
+    int32 type2 = Item2->m_columns[KeyColumn].type & CLVColTypesMask;
 
     if (!((type1 == CLVColStaticText || type1 == CLVColTruncateText || type1 == CLVColTruncateUserText ||
             type1 == CLVColUserText) && (type2 == CLVColStaticText || type2 == CLVColTruncateText ||
@@ -422,12 +415,12 @@ int CLVEasyItem::CompareItems(const CLVListItem* a_Item1, const CLVListItem* a_I
     const char* text2 = NULL;
 
     if (type1 == CLVColStaticText || type1 == CLVColTruncateText)
-        text1 = (const char*)Item1->m_column_content.ItemAt(KeyColumn);
+        text1 = (const char*)Item1->m_columns[KeyColumn].content;
     else if (type1 == CLVColTruncateUserText || type1 == CLVColUserText)
         text1 = Item1->GetUserText(KeyColumn, -1);
 
     if (type2 == CLVColStaticText || type2 == CLVColTruncateText)
-        text2 = (const char*)Item2->m_column_content.ItemAt(KeyColumn);
+        text2 = (const char*)Item2->m_columns[KeyColumn].content;
     else if (type2 == CLVColTruncateUserText || type2 == CLVColUserText)
         text2 = Item2->GetUserText(KeyColumn, -1);
 
@@ -437,20 +430,26 @@ int CLVEasyItem::CompareItems(const CLVListItem* a_Item1, const CLVListItem* a_I
 
 BRect CLVEasyItem::TruncateText(int32 column_index, float column_width, BFont* font)
 {
+    BRect invalid(-1, -1, -1, -1);
+    ColumnSlot* slot = SlotAt(column_index);
+    if (slot == NULL || slot->truncated_text == NULL)
+        return invalid;
+    //Remember the width so the text is only truncated again once the column is drawn at another one
+    slot->truncated_width = column_width;
+
     //column_width -= 4;           // Ram
     column_width -= 12;
     //Because when I draw the text I start drawing 6 pixels to the right from the column's left edge, and want
     //to stop 6 pixels before the right edge
-    BRect invalid(-1, -1, -1, -1);
-    char* full_text = (char*)m_column_content.ItemAt(column_index);
+    char* full_text = (char*)slot->content;
     char new_text[256];
-    char* truncated_text = (char*)m_aux_content.ItemAt(column_index);
+    char* truncated_text = slot->truncated_text;
     GetTruncatedString(full_text, new_text, column_width, 256, font);
     if (strcmp(truncated_text, new_text) != 0)
     {
         //The truncated text has changed
-        BRect* temp = (BRect*)m_cached_rects.ItemAt(column_index);
-        if (temp != NULL && *temp != BRect(-1, -1, -1, -1))
+        BRect* temp = &slot->cached_rect;
+        if (*temp != BRect(-1, -1, -1, -1))
         {
             invalid = *temp;
 
@@ -477,22 +476,22 @@ BRect CLVEasyItem::TruncateText(int32 column_index, float column_width, BFont* f
 
 void CLVEasyItem::ColumnWidthChanged(int32 column_index, float column_width, ColumnListView* the_view)
 {
-    BRect* cached_rect = (BRect*)m_cached_rects.ItemAt(column_index);
-    if (cached_rect == NULL || *cached_rect == BRect(-1, -1, -1, -1))
+    ColumnSlot* slot = SlotAt(column_index);
+    if (slot == NULL || slot->cached_rect == BRect(-1, -1, -1, -1))
         return;
+    BRect* cached_rect = &slot->cached_rect;
     float width_delta = column_width - (cached_rect->right - cached_rect->left);
     cached_rect->right += width_delta;
 
-    int num_columns = m_cached_rects.CountItems();
-    for (int column = 0; column < num_columns; column++)
+    for (int32 column = 0; column < m_column_count; column++)
         if (column != column_index)
         {
-            BRect* other_rect = (BRect*)m_cached_rects.ItemAt(column);
+            BRect* other_rect = &m_columns[column].cached_rect;
             if (other_rect->left > cached_rect->left)
                 other_rect->OffsetBy(width_delta, 0);
         }
 
-    int32 type = *m_column_types.ItemAt(column_index);
+    int32 type = slot->type;
     bool right_justify = (type & CLVColFlagRightJustify);
     type &= CLVColTypesMask;
     BRect invalid;
@@ -505,7 +504,6 @@ void CLVEasyItem::ColumnWidthChanged(int32 column_index, float column_width, Col
             //If it's onscreen, truncate and invalidate the changed area
             the_view->GetFont(&view_font);
             invalid = TruncateText(column_index, column_width, &view_font);
-            m_column_types.ReplaceItem(column_index, new int32(*m_column_types.ItemAt(column_index) & (CLVColFlagNeedsTruncation^0xFFFFFFFF)));
             if (invalid != BRect(-1.0, -1.0, -1.0, -1.0))
             {
                 if (!right_justify)
@@ -514,9 +512,7 @@ void CLVEasyItem::ColumnWidthChanged(int32 column_index, float column_width, Col
                     the_view->Invalidate(*cached_rect);
             }
         }
-        else
-            //If it's not onscreen flag it for truncation the next time it's drawn
-            m_column_types.ReplaceItem(column_index, new int32(*m_column_types.ItemAt(column_index) | CLVColFlagNeedsTruncation));
+        //If it's not onscreen it gets truncated the next time it's drawn, as its width changed
     }
     if (type == CLVColTruncateUserText)
     {
@@ -526,8 +522,8 @@ void CLVEasyItem::ColumnWidthChanged(int32 column_index, float column_width, Col
         Strtcpy(new_text, GetUserText(column_index, column_width), 256);
         if (strcmp(old_text, new_text) != 0)
         {
-            BRect* temp = (BRect*)m_cached_rects.ItemAt(column_index);
-            if (temp != NULL && *temp != BRect(-1, -1, -1, -1))
+            BRect* temp = cached_rect;
+            if (*temp != BRect(-1, -1, -1, -1))
             {
                 invalid = *temp;
                 if (!right_justify)
@@ -551,10 +547,11 @@ void CLVEasyItem::ColumnWidthChanged(int32 column_index, float column_width, Col
 
 void CLVEasyItem::FrameChanged(int32 column_index, BRect new_frame, ColumnListView* the_view)
 {
-    BRect* cached_rect = (BRect*)m_cached_rects.ItemAt(column_index);
-    if (cached_rect == NULL)
+    ColumnSlot* slot = SlotAt(column_index);
+    if (slot == NULL)
         return;
-    int32 type = (*m_column_types.ItemAt(column_index)) & CLVColTypesMask;
+    BRect* cached_rect = &slot->cached_rect;
+    int32 type = slot->type & CLVColTypesMask;
     if (type == CLVColTruncateText)
         if (*cached_rect != new_frame)
         {
@@ -566,13 +563,10 @@ void CLVEasyItem::FrameChanged(int32 column_index, BRect new_frame, ColumnListVi
                 BFont view_font;
                 the_view->GetFont(&view_font);
                 BRect invalid = TruncateText(column_index, new_frame.right - new_frame.left, &view_font);
-                m_column_types.ReplaceItem(column_index, new int32(*m_column_types.ItemAt(column_index) & (CLVColFlagNeedsTruncation^0xFFFFFFFF)));
                 if (invalid != BRect(-1.0, -1.0, -1.0, -1.0))
                     the_view->Invalidate(invalid);
             }
-            else
-                //If it's not onscreen flag it for truncation the next time it's drawn
-                m_column_types.ReplaceItem(column_index, new int32(*m_column_types.ItemAt(column_index) | CLVColFlagNeedsTruncation));
+            //If it's not onscreen it gets truncated the next time it's drawn at its new width
         }
 }
 
@@ -35,7 +35,6 @@
 #include <List.h>
 #include <Font.h> // Ram
 #include <Bitmap.h>    // Ram
-#include <ObjectList.h>
 
 //******************************************************************************************************
 //**** PROJECT HEADER FILES AND CLASS NAME DECLARATIONS
@@ -75,12 +74,29 @@ class CLVEasyItem : public CLVListItem
         virtual const char* GetUserText(int32 column_index, float column_width) const;
 
     private:
-        void PrepListsForSet(int column_index);
+        //One slot per column, all of a row's slots live in a single array
+        struct ColumnSlot
+        {
+            int32 type;                //CLVColumnTypes and flags
+            void* content;             //char* (full text followed by room for the truncated text) or BBitmap*
+            char* truncated_text;      //Points into content, NULL unless the text gets truncated
+            float truncated_width;     //Column width truncated_text was made for, -1 if it is stale
+            float bitmap_offset;       //Horizontal offset for bitmaps
+            BRect cached_rect;         //Where the column was last drawn
+        };
+
+        ColumnSlot* PrepSlotForSet(int column_index);
+        void FreeSlotContent(ColumnSlot* slot);
+        inline ColumnSlot* SlotAt(int32 column_index) const
+        {
+            if (column_index < 0 || column_index >= m_column_count)
+                return NULL;
+            return &m_columns[column_index];
+        }
 
-        BObjectList<int32> m_column_types;    //List of int32's converted from CLVColumnTypes
-        BList m_column_content;    //List of char* (full content) or BBitmap*
-        BList m_aux_content;    //List of char* (truncated content) or int32 for bitmap horizontal offset
-        BList m_cached_rects;    //List of BRect for truncated text
+        ColumnSlot* m_columns;
+        int32 m_column_count;
+        int32 m_column_capacity;
 
     protected:
         float text_offset;
@@ -50,6 +50,7 @@ CLVListItem::CLVListItem(uint32 level, bool superitem, bool expanded, float minh
     fSuperItem = superitem;
     fOutlineLevel = level;
     fMinHeight = minheight;
+    fRemoving = false;
 }
 
 
@@ -102,6 +102,7 @@ class CLVListItem : public BListItem
         BRect fExpanderColumnRect;
         BList* fSortingContextBList;
         ColumnListView* fSortingContextCLV;
+        bool fRemoving;
 };
 
 
@@ -108,7 +108,10 @@ ColumnListView::ColumnListView(BRect Frame, CLVContainerView** ContainerView, co
       fSortKeyList(6),
       fFullItemList(32),
       fRightArrow(BRect(0.0, 0.0, 10.0, 10.0), B_COLOR_8_BIT, CLVRightArrowData, false, false),
-      fDownArrow(BRect(0.0, 0.0, 10.0, 10.0), B_COLOR_8_BIT, CLVDownArrowData, false, false)
+      fDownArrow(BRect(0.0, 0.0, 10.0, 10.0), B_COLOR_8_BIT, CLVDownArrowData, false, false),
+      fSelectedItems(32),
+      fSelectionValid(false),
+      fItemsGeneration(0)
 {
     fHierarchical = hierarchical;
 
@@ -1020,6 +1023,14 @@ void ColumnListView::WindowActivated(bool active)
     BListView::WindowActivated(active);
 }
 
+
+void ColumnListView::SelectionChanged()
+{
+    fSelectionValid = false;
+    BListView::SelectionChanged();
+}
+
+
 bool ColumnListView::AddUnder(BListItem* a_item, BListItem* a_superitem)
 {
     //AssertWindowLocked();
@@ -1115,6 +1126,8 @@ bool ColumnListView::AddItemFastHierarchical(BListItem* a_item)
 bool ColumnListView::AddItemPrivate(CLVListItem* item, int32 fullListIndex)
 {
 //    AssertWindowLocked();    -- Commented out by Ram
+    fSelectionValid = false;
+    fItemsGeneration++;
 
     if (fHierarchical)
     {
@@ -1220,6 +1233,8 @@ bool ColumnListView::AddListPrivate(BList* newItems, int32 fullListIndex)
 bool ColumnListView::RemoveItem(BListItem* a_item)
 {
     //AssertWindowLocked();
+    fSelectionValid = false;
+    fItemsGeneration++;
 
     //Get the CLVListItems
     CLVListItem* item = cast_as(a_item, CLVListItem);
@@ -1240,6 +1255,8 @@ bool ColumnListView::RemoveItem(BListItem* a_item)
 BListItem* ColumnListView::RemoveItem(int32 fullListIndex)
 {
     //AssertWindowLocked();
+    fSelectionValid = false;
+    fItemsGeneration++;
     if (fHierarchical)
     {
         CLVListItem* TheItem = (CLVListItem*)fFullItemList.ItemAt(fullListIndex);
@@ -1262,6 +1279,8 @@ BListItem* ColumnListView::RemoveItem(int32 fullListIndex)
 bool ColumnListView::RemoveItems(int32 fullListIndex, int32 count)
 {
     //AssertWindowLocked();
+    fSelectionValid = false;
+    fItemsGeneration++;
     CLVListItem* TheItem;
     if (fHierarchical)
     {
@@ -1311,6 +1330,76 @@ bool ColumnListView::RemoveItems(int32 fullListIndex, int32 count)
 }
 
 
+int32 ColumnListView::RemoveItemList(const BList* items)
+{
+    //AssertWindowLocked();
+    int32 NumberOfItems = items->CountItems();
+    if (NumberOfItems == 0)
+        return 0;
+    fSelectionValid = false;
+    fItemsGeneration++;
+
+    for (int32 Counter = 0; Counter < NumberOfItems; Counter++)
+        ((CLVListItem*)items->ItemAt(Counter))->fRemoving = true;
+
+    //Compact the full list, whatever lies under a removed superitem goes with it
+    BList RemovedItems(NumberOfItems);
+    if (fHierarchical)
+    {
+        int32 FullCount = fFullItemList.CountItems();
+        BList KeptItems(FullCount);
+        uint32 RemovedLevel = UINT32_MAX;
+        for (int32 Counter = 0; Counter < FullCount; Counter++)
+        {
+            CLVListItem* TheItem = (CLVListItem*)fFullItemList.ItemAt(Counter);
+            if (RemovedLevel != UINT32_MAX && TheItem->fOutlineLevel > RemovedLevel)
+                TheItem->fRemoving = true;
+            else if (TheItem->fRemoving)
+                RemovedLevel = TheItem->fOutlineLevel;
+            else
+                RemovedLevel = UINT32_MAX;
+
+            if (TheItem->fRemoving)
+                RemovedItems.AddItem(TheItem);
+            else
+                KeptItems.AddItem(TheItem);
+        }
+        fFullItemList = KeptItems;
+    }
+
+    //Compact the display list, refilling it in one go rather than shifting it once per item
+    int32 DisplayCount = CountItems();
+    BList KeptDisplayItems(DisplayCount);
+    for (int32 Counter = 0; Counter < DisplayCount; Counter++)
+    {
+        CLVListItem* TheItem = (CLVListItem*)ItemAt(Counter);
+        if (TheItem->fRemoving)
+        {
+            if (!fHierarchical)
+                RemovedItems.AddItem(TheItem);
+        }
+        else
+            KeptDisplayItems.AddItem(TheItem);
+    }
+    if (KeptDisplayItems.CountItems() < DisplayCount)
+    {
+        float Top = Bounds().top;
+        BListView::MakeEmpty();
+        BListView::AddList(&KeptDisplayItems);
+        ScrollTo(BPoint(Bounds().left, Top));
+    }
+
+    int32 RemovedCount = RemovedItems.CountItems();
+    for (int32 Counter = 0; Counter < RemovedCount; Counter++)
+        ((CLVListItem*)RemovedItems.ItemAt(Counter))->fRemoving = false;
+
+    //Items that were asked for but weren't in the list
+    for (int32 Counter = 0; Counter < NumberOfItems; Counter++)
+        ((CLVListItem*)items->ItemAt(Counter))->fRemoving = false;
+    return RemovedCount;
+}
+
+
 CLVListItem* ColumnListView::FullListItemAt(int32 fullListIndex) const
 {
     //AssertWindowLocked();
@@ -1368,6 +1457,8 @@ int32 ColumnListView::FullListCountItems() const
 void ColumnListView::MakeEmpty()
 {
     //AssertWindowLocked();
+    fSelectionValid = false;
+    fItemsGeneration++;
     fFullItemList.MakeEmpty();
     BListView::MakeEmpty();
 }
@@ -1375,6 +1466,8 @@ void ColumnListView::MakeEmpty()
 
 void ColumnListView::MakeEmptyPrivate()
 {
+    fSelectionValid = false;
+    fItemsGeneration++;
     fFullItemList.MakeEmpty();
     BListView::MakeEmpty();
 }
@@ -1390,9 +1483,50 @@ bool ColumnListView::FullListIsEmpty() const
 int32 ColumnListView::FullListCurrentSelection(int32 index) const
 {
     //AssertWindowLocked();
-    int32 Selection = CurrentSelection(index);
-    CLVListItem* SelectedItem = (CLVListItem*)ItemAt(Selection);
-    return FullListIndexOf(SelectedItem);
+    return FullListIndexOf(SelectedItemAt(index));
+}
+
+
+int32 ColumnListView::CountSelectedItems() const
+{
+    //AssertWindowLocked();
+    GatherSelection();
+    return fSelectedItems.CountItems();
+}
+
+
+CLVListItem* ColumnListView::SelectedItemAt(int32 index) const
+{
+    //AssertWindowLocked();
+    GatherSelection();
+    return (CLVListItem*)fSelectedItems.ItemAt(index);
+}
+
+
+uint32 ColumnListView::ItemsGeneration() const
+{
+    return fItemsGeneration;
+}
+
+
+void ColumnListView::GatherSelection() const
+{
+    if (fSelectionValid)
+        return;
+
+    fSelectedItems.MakeEmpty();
+    int32 FirstSelected = CurrentSelection(0);
+    if (FirstSelected >= 0)
+    {
+        int32 NumberOfItems = CountItems();
+        for (int32 Counter = FirstSelected; Counter < NumberOfItems; Counter++)
+        {
+            BListItem* TheItem = ItemAt(Counter);
+            if (TheItem->IsSelected())
+                fSelectedItems.AddItem(TheItem);
+        }
+    }
+    fSelectionValid = true;
 }
 
 
@@ -1472,6 +1606,7 @@ int32 ColumnListView::FullListNumberOfSubitems(const CLVListItem* item) const
 void ColumnListView::Expand(CLVListItem* item)
 {
     //AssertWindowLocked();
+    fSelectionValid = false;
     if (!(item->fSuperItem))
         item->fSuperItem = true;
     if (item->IsExpanded())
@@ -1533,6 +1668,7 @@ void ColumnListView::Expand(CLVListItem* item)
 void ColumnListView::Collapse(CLVListItem* item)
 {
     //AssertWindowLocked();
+    fSelectionValid = false;
     if (!(item->fSuperItem))
         item->fSuperItem = true;
     if (!(item->IsExpanded()))
@@ -1595,6 +1731,7 @@ void ColumnListView::SetSortFunction(CLVCompareFuncPtr compare)
 void ColumnListView::SortItems()
 {
     //AssertWindowLocked();
+    fSelectionValid = false;
 
     int32 NumberOfItems;
     if (!fHierarchical)
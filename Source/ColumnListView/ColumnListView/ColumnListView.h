@@ -177,6 +177,9 @@ class ColumnListView : public BListView
         virtual void MouseMoved(BPoint where, uint32 code, const BMessage* message);
         virtual void WindowActivated(bool active);
 
+        //BListView overrides
+        virtual void SelectionChanged();
+
         //List functions
         virtual bool AddUnder(BListItem* item, BListItem* superitem);
         virtual bool AddUnderFast(BListItem* item, BListItem* superitem); // Ram
@@ -192,6 +195,8 @@ class ColumnListView : public BListView
         virtual bool RemoveItem(BListItem* item);
         virtual BListItem* RemoveItem(int32 fullListIndex);           //Actually returns CLVListItem
         virtual bool RemoveItems(int32 fullListIndex, int32 count);
+        int32 RemoveItemList(const BList* items);    //Removes all the given CLVListItem*'s (and their
+        //subitems) compacting each list once; returns how many items left the list
         virtual void MakeEmpty();
         CLVListItem* FullListItemAt(int32 fullListIndex)  const;
         int32 FullListIndexOf(const CLVListItem* item) const;
@@ -202,6 +207,10 @@ class ColumnListView : public BListView
         int32 FullListCountItems() const;
         bool FullListIsEmpty() const;
         int32 FullListCurrentSelection(int32 index = 0) const;
+        int32 CountSelectedItems() const;
+        CLVListItem* SelectedItemAt(int32 index) const;    //The selection in display order; gathered
+        //once per change so walking it is linear
+        uint32 ItemsGeneration() const;    //Changes whenever items are added or removed
         void FullListDoForEach(bool (*func)(CLVListItem*));
         void FullListDoForEach(bool (*func)(CLVListItem*, void*), void* arg2);
         CLVListItem* Superitem(const CLVListItem* item) const;
@@ -228,6 +237,7 @@ class ColumnListView : public BListView
         void MakeEmptyPrivate();
         bool AddListPrivate(BList* newItems, int32 fullListIndex);
         bool AddItemPrivate(CLVListItem* item, int32 fullListIndex);
+        void GatherSelection() const;
 
         void SortFullListSegment(int32 OriginalListStartIndex, int32 InsertionPoint, BList* NewList);
         BList* SortItemsInThisLevel(int32 OriginalListStartIndex);
@@ -257,6 +267,9 @@ class ColumnListView : public BListView
         rgb_color fSelectedItemForeColorWindowActive;    // Ram
         rgb_color fSelectedItemForeColorWindowInactive; // Ram
         bool fWindowActive;
+        mutable BList fSelectedItems;
+        mutable bool fSelectionValid;
+        uint32 fItemsGeneration;
 };
 
 
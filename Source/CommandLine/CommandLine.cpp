@@ -0,0 +1,581 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2002 Ramshankar (aka Teknomancer).
+// All rights reserved.
+
+#include "CommandLine.h"
+#include "AppConstants.h"
+#include "Archiver.h"
+#include "ArchiverMgr.h"
+#include "FSUtils.h"
+#include "HashTable.h"
+#include "ListEntry.h"
+#include "MsgConstants.h"
+#include "Shared.h"
+
+#include <Entry.h>
+#include <FindDirectory.h>
+#include <Looper.h>
+#include <Messenger.h>
+#include <NodeInfo.h>
+#include <Path.h>
+#include <Roster.h>
+
+#include <cstdio>
+#include <cstdlib>
+
+
+// Prints one line per entry the archiver reports on, it must reply as the archivers wait for it
+class ProgressPrinter : public BLooper
+{
+    public:
+        ProgressPrinter(const char* verb, int32* entryCount)
+            : BLooper("_progress_printer"),
+              m_verb(verb),
+              m_entryCount(entryCount)
+        {
+        }
+
+        virtual void MessageReceived(BMessage* message)
+        {
+            switch (message->what)
+            {
+                case BZR_UPDATE_PROGRESS:
+                {
+                    const char* text;
+                    if (message->FindString("text", &text) == B_OK)
+                        fprintf(stdout, "%s\t%s\n", m_verb, text);
+
+                    (*m_entryCount)++;
+                    message->SendReply('repl');
+                    break;
+                }
+
+                default:
+                    BLooper::MessageReceived(message);
+                    break;
+            }
+        }
+
+    private:
+        const char*         m_verb;
+        int32*              m_entryCount;
+};
+
+
+CommandLine::CommandLine()
+    : BApplication(K_CLI_SIGNATURE),
+    m_archiverMgr(NULL),
+    m_tempDir(NULL),
+    m_showStats(false),
+    m_cancel(false),
+    m_phaseStart(0),
+    m_startupTime(0),
+    m_phaseCount(0),
+    m_entryCount(0),
+    m_byteCount(0)
+{
+    // Same layout as the app, we expect to live next to it and share its add-ons and settings
+    app_info appInfo;
+    GetAppInfo(&appInfo);
+
+    BEntry appEntry(&appInfo.ref);
+    appEntry.GetParent(&appEntry);
+
+    BPath addonsDirPath(&appEntry);
+    if (addonsDirPath.Append(K_ARK_DIR_NAME) == B_OK)
+        m_addonsDir.SetTo(addonsDirPath.Path());
+
+    BPath settingsPath;
+    find_directory(B_USER_SETTINGS_DIRECTORY, &settingsPath);
+    if (settingsPath.Append(K_SETTINGS_DIR_NAME) == B_OK)
+    {
+        create_directory(settingsPath.Path(), 0755);
+        m_settingsDir.SetTo(settingsPath.Path());
+    }
+    m_settingsPathStr = settingsPath.Path();
+
+    // Reported by --stats, run twice after touching the add-ons folder to compare a cold start
+    // (add-on index rebuilt) against a warm one
+    bigtime_t const startTime = system_time();
+    m_archiverMgr = new ArchiverMgr(&m_addonsDir, &m_settingsDir);
+    m_startupTime = system_time() - startTime;
+}
+
+
+CommandLine::~CommandLine()
+{
+    delete m_archiverMgr;
+    if (m_tempDir)
+    {
+        RemoveDirectory(m_tempDir);
+        delete m_tempDir;
+    }
+}
+
+
+int CommandLine::Execute(int argc, char** argv)
+{
+    for (int32 i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--stats") == 0)
+            m_showStats = true;
+        else if (strcmp(argv[i], "--type") == 0 && i + 1 < argc)
+            m_type = argv[++i];
+        else
+            m_args.AddItem(argv[i]);
+    }
+
+    int32 const argCount = m_args.CountItems();
+    if (argCount < 2)
+    {
+        PrintUsage();
+        return 2;
+    }
+
+    const char* command = (const char*)m_args.ItemAtFast(0);
+    const char* archivePath = (const char*)m_args.ItemAtFast(1);
+
+    int exitCode = 2;
+    bigtime_t const startTime = system_time();
+    if (strcmp(command, "list") == 0)
+        exitCode = List(archivePath);
+    else if (strcmp(command, "test") == 0)
+        exitCode = Test(archivePath);
+    else if (strcmp(command, "extract") == 0 && argCount >= 3)
+        exitCode = Extract(archivePath, (const char*)m_args.ItemAtFast(2), 3);
+    else if (strcmp(command, "add") == 0 && argCount >= 3)
+        exitCode = Add(archivePath, 2, false);
+    else if (strcmp(command, "create") == 0 && argCount >= 3)
+        exitCode = Add(archivePath, 2, true);
+    else
+        PrintUsage();
+
+    if (m_showStats)
+    {
+        PrintStats();
+        fprintf(stderr, "stats\ttotal\t%" B_PRIdBIGTIME "\n", system_time() - startTime);
+    }
+
+    return exitCode;
+}
+
+
+int CommandLine::List(const char* archivePath)
+{
+    Archiver* ark = OpenArchive(archivePath);
+    if (ark == NULL)
+        return 1;
+
+    BeginPhase("index");
+    BList* fileList;
+    BList* dirList;
+    ark->FillLists();
+    ark->GetLists(fileList, dirList);
+    EndPhase();
+
+    BeginPhase("print");
+    int32 const dirCount = dirList->CountItems();
+    for (int32 i = 0; i < dirCount; i++)
+    {
+        ListEntry* item = ((HashEntry*)dirList->ItemAtFast(i))->m_clvItem;
+        fprintf(stdout, "d\t0\t0\t0\t%s\n", item->m_fullPath.String());
+    }
+
+    int32 const fileCount = fileList->CountItems();
+    for (int32 i = 0; i < fileCount; i++)
+    {
+        ListEntry* item = ((HashEntry*)fileList->ItemAtFast(i))->m_clvItem;
+        fprintf(stdout, "f\t%" B_PRIdOFF "\t%" B_PRIdOFF "\t%ld\t%s\n", item->m_length, item->m_packed,
+                (long)item->m_timeValue, item->m_fullPath.String());
+        m_byteCount += item->m_length;
+    }
+    m_entryCount = fileCount + dirCount;
+    EndPhase();
+
+    delete ark;
+    return 0;
+}
+
+
+int CommandLine::Extract(const char* archivePath, const char* destPath, int32 firstPathArg)
+{
+    BEntry destEntry(destPath, true);
+    entry_ref destRef;
+    if (destEntry.IsDirectory() == false || destEntry.GetRef(&destRef) != B_OK)
+    {
+        PrintError("destination is not a folder", destPath);
+        return 1;
+    }
+
+    Archiver* ark = OpenArchive(archivePath);
+    if (ark == NULL)
+        return 1;
+
+    // Extract only the given entries if any, otherwise the whole archive
+    BMessage selection;
+    for (int32 i = firstPathArg; i < m_args.CountItems(); i++)
+        selection.AddString(kPath, (const char*)m_args.ItemAtFast(i));
+
+    ProgressPrinter* printer = new ProgressPrinter("extracted", &m_entryCount);
+    printer->Run();
+    BMessenger progress(printer);
+
+    BeginPhase("extract");
+    status_t result = ark->Extract(&destRef, selection.IsEmpty() ? NULL : &selection, &progress, &m_cancel);
+    EndPhase();
+
+    if (printer->Lock())
+        printer->Quit();
+
+    int exitCode = 0;
+    if (Succeeded(result) == false)
+    {
+        PrintError("extraction failed", ark->ErrorMessage()->FindString(kErrorString));
+        exitCode = 1;
+    }
+
+    delete ark;
+    return exitCode;
+}
+
+
+int CommandLine::Test(const char* archivePath)
+{
+    Archiver* ark = OpenArchive(archivePath);
+    if (ark == NULL)
+        return 1;
+
+    ProgressPrinter* printer = new ProgressPrinter("tested", &m_entryCount);
+    printer->Run();
+    BMessenger progress(printer);
+
+    BeginPhase("test");
+    char* output = NULL;
+    status_t result = ark->Test(output, &progress, &m_cancel);
+    EndPhase();
+
+    if (printer->Lock())
+        printer->Quit();
+
+    int exitCode = 0;
+    if (result == BZR_NOT_SUPPORTED)
+    {
+        PrintError("testing is not supported for this archive type");
+        exitCode = 1;
+    }
+    else if (Succeeded(result) == false)
+    {
+        PrintError("test failed", output);
+        exitCode = 1;
+    }
+
+    delete[] output;
+    delete ark;
+    return exitCode;
+}
+
+
+int CommandLine::Add(const char* archivePath, int32 firstPathArg, bool createMode)
+{
+    // The archivers add paths relative to a folder they chdir() into, so group the
+    // given paths by their parent folder and add each group in one go
+    BMessage groups;
+    if (GroupByFolder(firstPathArg, groups) != B_OK)
+        return 1;
+
+    Archiver* ark = NULL;
+    if (createMode)
+    {
+        ark = ArchiverForName(archivePath);
+        if (ark == NULL)
+            return 1;
+    }
+    else
+    {
+        ark = OpenArchive(archivePath);
+        if (ark == NULL)
+            return 1;
+
+        if (ark->CanAddFiles() == false)
+        {
+            PrintError("adding is not supported for this archive type");
+            delete ark;
+            return 1;
+        }
+    }
+
+    ProgressPrinter* printer = new ProgressPrinter("added", &m_entryCount);
+    printer->Run();
+    BMessenger progress(printer);
+
+    BeginPhase(createMode ? "create" : "add");
+    status_t result = BZR_DONE;
+    char* folderPath;
+    for (int32 i = 0; groups.GetInfo(B_STRING_TYPE, i, &folderPath, NULL) == B_OK; i++)
+    {
+        BMessage fileList;
+        const char* leaf;
+        for (int32 j = 0; groups.FindString(folderPath, j, &leaf) == B_OK; j++)
+            fileList.AddString(kPath, leaf);
+
+        BMessage addedPaths;
+        if (createMode && i == 0)
+        {
+            BPath path(archivePath);
+            result = ark->Create(&path, folderPath, &fileList, &addedPaths, &progress, &m_cancel);
+        }
+        else
+            result = ark->Add(false, folderPath, &fileList, &addedPaths, &progress, &m_cancel);
+
+        if (Succeeded(result) == false)
+            break;
+    }
+    EndPhase();
+
+    if (printer->Lock())
+        printer->Quit();
+
+    int exitCode = 0;
+    if (Succeeded(result) == false)
+    {
+        PrintError(createMode ? "creating the archive failed" : "adding failed",
+                   ark->ErrorMessage()->FindString(kErrorString));
+        exitCode = 1;
+    }
+
+    delete ark;
+    return exitCode;
+}
+
+
+Archiver* CommandLine::OpenArchive(const char* archivePath)
+{
+    BEntry entry(archivePath, true);
+    entry_ref ref;
+    if (entry.Exists() == false || entry.GetRef(&ref) != B_OK)
+    {
+        PrintError("no such archive", archivePath);
+        return NULL;
+    }
+
+    BeginPhase("load");
+    BPath path(&entry);
+    char type[B_MIME_TYPE_LENGTH];
+    char* mime = m_archiverMgr->ValidateFileType(&path);
+    if (mime)
+    {
+        strlcpy(type, mime, sizeof(type));
+        delete[] mime;
+    }
+    else
+    {
+        update_mime_info(path.Path(), false, true, false);
+        BNode node(&entry);
+        BNodeInfo nodeInfo(&node);
+        if (nodeInfo.GetType(type) != B_OK)
+            type[0] = '\0';
+    }
+
+    Archiver* ark = m_type.Length() > 0 ? m_archiverMgr->ArchiverForType(m_type.String())
+                    : m_archiverMgr->ArchiverForMime(type);
+    EndPhase();
+
+    if (ark == NULL)
+    {
+        PrintError("not an archive or an unsupported type", archivePath);
+        return NULL;
+    }
+
+    if (ark->InitCheck() == BZR_BINARY_MISSING)
+    {
+        PrintError("archiver binary is missing", ark->ArchiveType());
+        delete ark;
+        return NULL;
+    }
+
+    SetupArchiver(ark);
+
+    BeginPhase("open");
+    status_t result = ark->Open(&ref);
+    EndPhase();
+
+    if (Succeeded(result) == false)
+    {
+        PrintError("couldn't open archive", ark->ErrorMessage()->FindString(kErrorString));
+        delete ark;
+        return NULL;
+    }
+
+    return ark;
+}
+
+
+Archiver* CommandLine::ArchiverForName(const char* archivePath)
+{
+    // Use the explicitly given type, or the archiver whose default extension the name ends with
+    BString type = m_type;
+    if (type.Length() == 0)
+    {
+        BList arkTypes, arkExtensions;
+        m_archiverMgr->ArchiversInstalled(arkTypes, &arkExtensions);
+
+        BString name(archivePath);
+        int32 bestLength = 0;
+        for (int32 i = 0; i < arkExtensions.CountItems(); i++)
+        {
+            const char* extension = (const char*)arkExtensions.ItemAtFast(i);
+            int32 const length = strlen(extension);
+            if (length > bestLength && name.IFindLast(extension) == name.Length() - length)
+            {
+                type = (const char*)arkTypes.ItemAt(i);
+                bestLength = length;
+            }
+        }
+
+        for (int32 i = 0; i < arkTypes.CountItems(); i++)
+            free(arkTypes.ItemAtFast(i));
+        for (int32 i = 0; i < arkExtensions.CountItems(); i++)
+            free(arkExtensions.ItemAtFast(i));
+    }
+
+    if (type.Length() == 0)
+    {
+        PrintError("couldn't tell the archive type from its name, use --type", archivePath);
+        return NULL;
+    }
+
+    status_t result;
+    Archiver* ark = m_archiverMgr->NewArchiver(type.String(), false, &result);
+    if (ark == NULL)
+    {
+        PrintError("unknown archive type", type.String());
+        return NULL;
+    }
+
+    if (result == BZR_BINARY_MISSING)
+    {
+        PrintError("archiver binary is missing", type.String());
+        delete ark;
+        return NULL;
+    }
+
+    SetupArchiver(ark);
+    return ark;
+}
+
+
+void CommandLine::SetupArchiver(Archiver* ark)
+{
+    ark->SetSettingsDirectoryPath(m_settingsPathStr.String());
+    if (ark->NeedsTempDirectory())
+    {
+        if (m_tempDir == NULL)
+            m_tempDirPathStr = CreateTempDirectory(NULL, &m_tempDir, true);
+        ark->SetTempDirectoryPath(m_tempDirPathStr.String());
+    }
+
+    // Settings such as compression level are read off the archiver's menu
+    ark->LoadSettingsMenu();
+}
+
+
+status_t CommandLine::GroupByFolder(int32 firstPathArg, BMessage& groups) const
+{
+    for (int32 i = firstPathArg; i < m_args.CountItems(); i++)
+    {
+        const char* arg = (const char*)m_args.ItemAtFast(i);
+        BEntry entry(arg, false);
+        BPath path, parentPath;
+        if (entry.Exists() == false || entry.GetPath(&path) != B_OK || path.GetParent(&parentPath) != B_OK)
+        {
+            PrintError("no such file", arg);
+            return B_ENTRY_NOT_FOUND;
+        }
+
+        groups.AddString(parentPath.Path(), path.Leaf());
+    }
+
+    return B_OK;
+}
+
+
+bool CommandLine::Succeeded(status_t result) const
+{
+    return result == BZR_DONE || result == B_OK || result == BZR_ERRSTREAM_FOUND;
+}
+
+
+void CommandLine::BeginPhase(const char* name)
+{
+    if (m_phaseCount >= kMaxStatPhases)
+        return;
+
+    m_phaseName[m_phaseCount] = name;
+    m_phaseStart = system_time();
+}
+
+
+void CommandLine::EndPhase()
+{
+    if (m_phaseCount >= kMaxStatPhases)
+        return;
+
+    m_phaseTime[m_phaseCount++] = system_time() - m_phaseStart;
+}
+
+
+void CommandLine::PrintStats() const
+{
+    // Written to stderr to keep stdout parseable
+    fprintf(stderr, "stats\tstartup\t%" B_PRIdBIGTIME "\n", m_startupTime);
+
+    bigtime_t workTime = 0;
+    for (int32 i = 0; i < m_phaseCount; i++)
+    {
+        fprintf(stderr, "stats\t%s\t%" B_PRIdBIGTIME "\n", m_phaseName[i], m_phaseTime[i]);
+        workTime += m_phaseTime[i];
+    }
+
+    fprintf(stderr, "stats\tentries\t%" B_PRId32 "\n", m_entryCount);
+    if (m_byteCount > 0)
+        fprintf(stderr, "stats\tbytes\t%" B_PRIdOFF "\n", m_byteCount);
+    if (workTime > 0)
+        fprintf(stderr, "stats\tentries_per_sec\t%.1f\n", m_entryCount * 1000000.0 / workTime);
+}
+
+
+void CommandLine::PrintError(const char* message, const char* detail) const
+{
+    if (detail != NULL && detail[0] != '\0')
+        fprintf(stderr, "error\t%s\t%s\n", message, detail);
+    else
+        fprintf(stderr, "error\t%s\n", message);
+}
+
+
+void CommandLine::PrintUsage() const
+{
+    fprintf(stderr,
+            "usage: beezer-cli [--stats] [--type <archiver>] <command> <archive> [arguments]\n"
+            "\n"
+            "  list    <archive>                       list entries, tab separated:\n"
+            "                                          kind (f/d), size, packed, mtime, path\n"
+            "  extract <archive> <folder> [entries]    extract all or the given entries\n"
+            "  test    <archive>                       test the archive for errors\n"
+            "  add     <archive> <files>               add files to an existing archive\n"
+            "  create  <archive> <files>               create a new archive, the type is taken\n"
+            "                                          from the name unless --type is given\n"
+            "\n"
+            "  --stats                                 print per-phase timings (usecs) to stderr\n"
+            "\n"
+            "Exit status is 0 on success, 1 on failure and 2 on bad usage.\n");
+}
+
+
+int main(int argc, char** argv)
+{
+    CommandLine* cli = new CommandLine();
+    int exitCode = cli->Execute(argc, argv);
+    delete cli;
+    return exitCode;
+}
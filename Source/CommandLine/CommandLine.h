@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2002 Ramshankar (aka Teknomancer).
+// All rights reserved.
+
+#ifndef _COMMAND_LINE_H
+#define _COMMAND_LINE_H
+
+#include <Application.h>
+#include <Directory.h>
+#include <List.h>
+#include <String.h>
+
+class BPath;
+
+class Archiver;
+class ArchiverMgr;
+
+const int32 kMaxStatPhases = 8;
+
+class CommandLine : public BApplication
+{
+    public:
+        CommandLine();
+        virtual ~CommandLine();
+
+        int                 Execute(int argc, char** argv);
+
+    private:
+        int                 List(const char* archivePath);
+        int                 Extract(const char* archivePath, const char* destPath, int32 firstPathArg);
+        int                 Test(const char* archivePath);
+        int                 Add(const char* archivePath, int32 firstPathArg, bool createMode);
+
+        Archiver*           OpenArchive(const char* archivePath);
+        Archiver*           ArchiverForName(const char* archivePath);
+        void                SetupArchiver(Archiver* ark);
+        status_t            GroupByFolder(int32 firstPathArg, BMessage& groups) const;
+        bool                Succeeded(status_t result) const;
+
+        void                BeginPhase(const char* name);
+        void                EndPhase();
+        void                PrintStats() const;
+        void                PrintError(const char* message, const char* detail = NULL) const;
+        void                PrintUsage() const;
+
+        ArchiverMgr*        m_archiverMgr;
+        BDirectory          m_addonsDir,
+                            m_settingsDir,
+                            *m_tempDir;
+        BString             m_settingsPathStr,
+                            m_tempDirPathStr,
+                            m_type;
+        BList               m_args;
+        bool                m_showStats;
+        volatile bool       m_cancel;
+
+        const char*         m_phaseName[kMaxStatPhases];
+        bigtime_t           m_phaseTime[kMaxStatPhases],
+                            m_phaseStart,
+                            m_startupTime;
+        int32               m_phaseCount,
+                            m_entryCount;
+        off_t               m_byteCount;
+};
+
+#endif /* _COMMAND_LINE_H */
@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2002 Ramshankar (aka Teknomancer).
+// All rights reserved.
+
+#include "FormatSniffer.h"
+
+#include <File.h>
+
+#include <cstring>
+
+
+struct FormatSignature
+{
+    const char*         magic;
+    size_t              length;
+    const char*         mimeType;
+};
+
+
+// MIME types are ones the add-ons list under "FileTypes" in their metadata
+static const FormatSignature kSignatures[] =
+{
+    { "PK\x03\x04",          4, "application/zip" },
+    { "PK\x05\x06",          4, "application/zip" },
+    { "PK\x07\x08",          4, "application/zip" },
+    { "Rar!\x1a\x07",        6, "application/x-rar" },
+    { "7z\xbc\xaf\x27\x1c",  6, "application/x-7z-compressed" },
+    { "\x1f\x8b\x08",        3, "application/gzip" },
+    { "\xfd" "7zXZ\x00",     6, "application/x-xz" },
+    { "\x28\xb5\x2f\xfd",    4, "application/x-zstd" },
+    { "hsqs",                4, "application/x-squashfs-image" },
+    { "hpkg",                4, "application/x-vnd.haiku-package" }
+};
+
+
+static bool IsOctalField(const uint8* field, size_t length, uint32* value)
+{
+    // Tar numbers are octal digits padded with spaces or NULs on either side
+    size_t i = 0;
+    while (i < length && (field[i] == ' ' || field[i] == '\0'))
+        i++;
+
+    if (i == length || field[i] < '0' || field[i] > '7')
+        return false;
+
+    *value = 0;
+    for (; i < length && field[i] >= '0' && field[i] <= '7'; i++)
+        *value = (*value << 3) | (field[i] - '0');
+
+    for (; i < length; i++)
+        if (field[i] != ' ' && field[i] != '\0')
+            return false;
+
+    return true;
+}
+
+
+bool IsTarHeader(const uint8* block, size_t size)
+{
+    if (size < kSniffSize || block[0] == '\0')
+        return false;
+
+    if (memcmp(block + 257, "ustar", 5) == 0)
+        return true;
+
+    // Old v7 tars carry no magic, accept them when the header checksum adds up. Some tars summed
+    // the bytes as signed chars so allow for either
+    uint32 checksum;
+    if (IsOctalField(block + 148, 8, &checksum) == false)
+        return false;
+
+    uint32 unsignedSum = 8 * ' ';
+    int32 signedSum = 8 * ' ';
+    for (size_t i = 0; i < kSniffSize; i++)
+    {
+        if (i >= 148 && i < 156)
+            continue;
+
+        unsignedSum += block[i];
+        signedSum += (int8)block[i];
+    }
+
+    return checksum == unsignedSum || (int32)checksum == signedSum;
+}
+
+
+const char* SniffArchiveType(const uint8* data, size_t size)
+{
+    for (size_t i = 0; i < sizeof(kSignatures) / sizeof(kSignatures[0]); i++)
+    {
+        const FormatSignature& signature = kSignatures[i];
+        if (size >= signature.length && memcmp(data, signature.magic, signature.length) == 0)
+            return signature.mimeType;
+    }
+
+    // "BZh" followed by the block size digit
+    if (size >= 4 && memcmp(data, "BZh", 3) == 0 && data[3] >= '1' && data[3] <= '9')
+        return "application/x-bzip2";
+
+    // LHa headers start with their size and checksum followed by the method, e.g. "-lh5-"
+    if (size >= 7 && data[2] == '-' && data[3] == 'l' && (data[4] == 'h' || data[4] == 'z') && data[6] == '-')
+        return "application/x-lharc";
+
+    // ARJ's two byte magic is followed by the size of the main header, at most 2600 bytes
+    if (size >= 4 && data[0] == 0x60 && data[1] == 0xea && (data[2] | (data[3] << 8)) <= 2600)
+        return "application/x-arj";
+
+    if (IsTarHeader(data, size))
+        return "application/x-tar";
+
+    return NULL;
+}
+
+
+const char* SniffArchiveType(const char* filePath)
+{
+    BFile file(filePath, B_READ_ONLY);
+    if (file.InitCheck() != B_OK)
+        return NULL;
+
+    uint8 data[kSniffSize];
+    ssize_t const bytesRead = file.ReadAt(0, data, sizeof(data));
+    if (bytesRead <= 0)
+        return NULL;
+
+    return SniffArchiveType(data, bytesRead);
+}
@@ -0,0 +1,19 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2002 Ramshankar (aka Teknomancer).
+// All rights reserved.
+
+#ifndef _FORMAT_SNIFFER_H
+#define _FORMAT_SNIFFER_H
+
+#include <SupportDefs.h>
+
+// Bytes from the start of a file needed to identify any of the formats below
+const size_t kSniffSize = 512;
+
+// Return the MIME type of the add-on handling the archive (or NULL when the bytes match no format
+// we know), so that opening an archive need not wait for update_mime_info() and the MIME database
+extern const char*    SniffArchiveType(const char* filePath);
+extern const char*    SniffArchiveType(const uint8* data, size_t size);
+extern bool           IsTarHeader(const uint8* block, size_t size);
+
+#endif /* _FORMAT_SNIFFER_H */
@@ -6,6 +6,7 @@
 #include "GZipArchiver.h"
 #include "ArchiveEntry.h"
 #include "AppUtils.h"
+#include "KeyedMenuItem.h"
 
 #include <NodeInfo.h>
 #include <Messenger.h>
@@ -18,9 +19,15 @@
 #define B_TRANSLATION_CONTEXT "GZipArchiver"
 #else
 #define B_TRANSLATE(x) x
+#define B_TRANSLATE_MARK(x) x
+#define B_TRANSLATE_NOCOLLECT(x) x
 #endif
 
 
+static const char
+    *kAutoLevel        = B_TRANSLATE_MARK("Use fastest level for already compressed data");
+
+
 Archiver* load_archiver(BMessage* metaDataMsg)
 {
     return new GZipArchiver(metaDataMsg);
@@ -39,6 +46,10 @@ GZipArchiver::GZipArchiver(BMessage* metaDataMsg)
         m_error = BZR_BINARY_MISSING;
         return;
     }
+
+    // Optional, compresses on all cores when present
+    if (GetBinaryPath(m_pigzPath, "pigz") == false)
+        m_pigzPath[0] = '\0';
 }
 
 
@@ -82,15 +93,8 @@ status_t GZipArchiver::Open(entry_ref* ref, BMessage* fileList)
     m_archiveRef = *ref;
     m_archivePath.SetTo(ref);
 
-    // We are redirecting (>) shell output to file, therefore we need to use /bin/sh -c <command>
     BString destPath = InitTarFilePath(ref->name);
-    BString cmd;
-    cmd << "\"" << m_gzipPath << "\"" << " -c -d \"" << m_archivePath.Path() << "\" > " << "\"" <<
-    m_tarFilePath << "\"";
-
-    m_pipeMgr.FlushArgs();
-    m_pipeMgr << "/bin/sh" << "-c" << cmd.String();
-    m_pipeMgr.Pipe();
+    DecompressToTemp();
 
     if (TarArchiver::IsTarArchive(destPath.String()))
     {
@@ -176,6 +180,9 @@ status_t GZipArchiver::Extract(entry_ref* refToDir, BMessage* message, BMessenge
     }
     else
     {
+        if (BEntry(m_tarFilePath).Exists() == false)
+            DecompressToTemp();
+
         m_archivePath = m_tarFilePath;
         status_t exitCode = TarArchiver::Extract(refToDir, message, progress, cancel);
         m_archivePath = m_arkFilePath;
@@ -236,6 +243,9 @@ status_t GZipArchiver::Add(bool createMode, const char* relativePath, BMessage*
 {
     if (m_tarArk == true)
     {
+        if (BEntry(m_tarFilePath).Exists() == false)
+            DecompressToTemp();
+
         m_archivePath = m_tarFilePath;
         status_t exitCode = TarArchiver::Add(createMode, relativePath, message, addedPaths, progress, cancel);
         m_archivePath = m_arkFilePath;
@@ -253,6 +263,9 @@ status_t GZipArchiver::Delete(char*& outputStr, BMessage* message, BMessenger* p
 {
     if (m_tarArk == true)
     {
+        if (BEntry(m_tarFilePath).Exists() == false)
+            DecompressToTemp();
+
         m_archivePath = m_tarFilePath;
         status_t exitCode = TarArchiver::Delete(outputStr, message, progress, cancel);
         m_archivePath = m_arkFilePath;
@@ -277,7 +290,14 @@ status_t GZipArchiver::Create(BPath* archivePath, const char* relPath, BMessage*
     strcpy(m_arkFilePath, m_archivePath.Path());
     InitTarFilePath((char*)archivePath->Leaf());
 
-    status_t result = Add(true, relPath, fileList, addedPaths, progress, cancel);
+    // tar is piped straight into the compressor, the tar in temp is only unpacked again if needed later
+    BEntry(m_tarFilePath).Remove();
+    int32 level = GetCompressionLevel();
+    if (m_settingsMenu->FindItem(B_TRANSLATE_NOCOLLECT(kAutoLevel))->IsMarked() == true)
+        level = ContentCompressionLevel(relPath, fileList, 1);
+
+    status_t result = CreateCompressed(CompressProgram(level).String(), relPath, fileList, addedPaths, progress,
+                                       cancel);
 
     // Once creating is done, set m_archiveRef to pointed to the existing archive file
     if (result == BZR_DONE)
@@ -325,6 +345,8 @@ void GZipArchiver::BuildMenu(BMessage& message)
 
     // Add sub-menus to settings menu
     m_settingsMenu->AddItem(m_compressionMenu);
+    m_settingsMenu->AddItem(new KeyedMenuItem("bzr:AutoLevel", B_TRANSLATE_NOCOLLECT(kAutoLevel),
+                                              message, false, new BMessage(BZR_MENUITEM_SELECTED)));
 }
 
 
@@ -368,14 +390,35 @@ BList GZipArchiver::HiddenColumns(BList const& columns) const
 
 void GZipArchiver::CompressFromTemp()
 {
-    // Get the compression ratio from the settings menu
-    BString levelStr;
-    levelStr.SetToFormat(" -%d ", GetCompressionLevel());
-
     // Re-compress file, from .tar in temp to gzip
+    int32 level = GetCompressionLevel();
+    if (m_settingsMenu->FindItem(B_TRANSLATE_NOCOLLECT(kAutoLevel))->IsMarked() == true)
+        level = ContentCompressionLevel(m_tarFilePath, 1);
+
     BString cmd;
-    cmd << "\"" << m_gzipPath << "\"" << " -c " << levelStr << "\"" << m_tarFilePath << "\" > " << "\"" <<
-    m_archivePath.Path() << "\"";
+    cmd << CompressProgram(level) << " -c \"" << m_tarFilePath << "\" > \"" << m_archivePath.Path() << "\"";
+
+    m_pipeMgr.FlushArgs();
+    m_pipeMgr << "/bin/sh" << "-c" << cmd.String();
+    m_pipeMgr.Pipe();
+}
+
+
+BString GZipArchiver::CompressProgram(int32 level)
+{
+    // pigz compresses on all cores and writes plain gzip streams
+    BString program;
+    program.SetToFormat("\"%s\" -%d", m_pigzPath[0] != '\0' ? m_pigzPath : m_gzipPath, level);
+    return program;
+}
+
+
+void GZipArchiver::DecompressToTemp()
+{
+    // We are redirecting (>) shell output to file, therefore we need to use /bin/sh -c <command>
+    BString cmd;
+    cmd << "\"" << m_gzipPath << "\"" << " -c -d \"" << m_archivePath.Path() << "\" > " << "\"" <<
+    m_tarFilePath << "\"";
 
     m_pipeMgr.FlushArgs();
     m_pipeMgr << "/bin/sh" << "-c" << cmd.String();
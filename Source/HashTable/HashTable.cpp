@@ -233,6 +233,30 @@ int32 HashTable::TableSize() const
 }
 
 
+void HashTable::Resize(int32 sizeOfTable)
+{
+    // Relink the existing items into the new buckets, they themselves stay where they are
+    HashEntry** oldTable = m_table;
+    int32 const oldSize = m_tableSize;
+
+    m_tableSize = sizeOfTable;
+    m_table = new HashEntry*[m_tableSize];
+    memset(m_table, 0, m_tableSize * sizeof(HashEntry*));
+
+    for (int32 bucket = 0; bucket < oldSize; bucket++)
+        for (HashEntry* item = oldTable[bucket]; item != NULL; )
+        {
+            HashEntry* next = item->m_next;
+            int32 const hashValue = Hash(item->m_pathStr);
+            item->m_next = m_table[hashValue];
+            m_table[hashValue] = item;
+            item = next;
+        }
+
+    delete[] oldTable;
+}
+
+
 void HashTable::ResetCache(HashEntry* item)
 {
     if (m_lastFoundEntry == item)
@@ -34,6 +34,7 @@ class HashTable
         void                DeleteAll();
         int32               CountItems() const;
         int32               TableSize() const;
+        void                Resize(int32 sizeOfTable);
         HashEntry*          Find(const char* str);
         HashEntry*          Insert(const char* str, bool *added);
         HashEntry*          Add(const char* str);
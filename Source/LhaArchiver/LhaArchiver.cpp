@@ -50,74 +50,71 @@ LhaArchiver::LhaArchiver(BMessage* metaDataMsg)
 
 status_t LhaArchiver::ReadOpen(FILE* fp)
 {
-    char lineString[B_PATH_NAME_LENGTH + 512],
-         permStr[25], sizeStr[25], uidgidStr[20], methodStr[25], packedStr[25], ratioStr[15], dayStr[5],
-         monthStr[5], yearStr[8], hourStr[5], minuteStr[5], secondStr[5], crcStr[25],
-         pathStr[B_PATH_NAME_LENGTH + 1];
+    char lineString[B_PATH_NAME_LENGTH + 512];
     uint16 const len = sizeof(lineString);
 
-
     // Lha doesn't report the time for files (only date) hence we use the modification time of the
     // archive along with the corresponding date reported by lha
     time_t const modTime = ArchiveModificationTime();
-    tm mod_tm;
-    localtime_r(&modTime, &mod_tm);
-    sprintf(hourStr, "%d", mod_tm.tm_hour);
-    sprintf(minuteStr, "%d", mod_tm.tm_min);
-    sprintf(secondStr, "%d", mod_tm.tm_sec);
+    localtime_r(&modTime, &m_modTime);
 
     do
     {
         fgets(lineString, len, fp);
     } while (!feof(fp) && (strstr(lineString, "----------") == NULL));
 
-    fgets(lineString, len, fp);
+    return ReadOpenParallel(fp, "----------");
+}
 
-    while (!feof(fp) && (strstr(lineString, "----------") == NULL))
-    {
-        lineString[strlen(lineString) - 1] = '\0';
 
-        if (strncmp(lineString, "[generic]", 9) == 0)
-        {
-            sscanf(lineString,
+ArchiveEntry* LhaArchiver::ParseOpenLine(char* lineString)
+{
+    char permStr[25], sizeStr[25], uidgidStr[20], methodStr[25], packedStr[25], ratioStr[15], dayStr[5],
+         monthStr[5], yearStr[8], hourStr[5], minuteStr[5], secondStr[5], crcStr[25],
+         pathStr[B_PATH_NAME_LENGTH + 1];
+
+    if (strncmp(lineString, "[generic]", 9) == 0)
+    {
+        if (sscanf(lineString,
                    "%[^ ] %[0-9] %[0-9] %[^ ] %[^ ] %[^ ] %[^ ] %[^ ] %[^ ]%[^\n]", permStr, packedStr, sizeStr,
-                   ratioStr, methodStr, crcStr, monthStr, dayStr, yearStr, pathStr);
-        }
-        else
-        {
-            sscanf(lineString,
+                   ratioStr, methodStr, crcStr, monthStr, dayStr, yearStr, pathStr) != 10)
+            return NULL;
+    }
+    else
+    {
+        if (sscanf(lineString,
                    "%[^ ] %[^ ] %[0-9] %[0-9] %[^ ] %[^ ] %[^ ] %[^ ] %[0-9] %[^ ]%[^\n]",
                    permStr, uidgidStr, packedStr, sizeStr, ratioStr, methodStr, crcStr, monthStr, dayStr, yearStr,
-                   pathStr);
-        }
-
-        // Workaround bug fix for files/folder with space before them
-        BString pathString = pathStr;
-        pathString.Remove(0, 1);
+                   pathStr) != 11)
+            return NULL;
+    }
 
-        BString monthStrCorrect;
-        monthStrCorrect << MonthStrToNum(monthStr);
+    sprintf(hourStr, "%d", m_modTime.tm_hour);
+    sprintf(minuteStr, "%d", m_modTime.tm_min);
+    sprintf(secondStr, "%d", m_modTime.tm_sec);
 
-        // Stupid lha! for directories and some other files reports time in-place of year,
-        // fix that with current system year
-        if (strstr(yearStr, ":"))
-            sprintf(yearStr, "%d", mod_tm.tm_year);
+    // Workaround bug fix for files/folder with space before them
+    BString pathString = pathStr;
+    pathString.Remove(0, 1);
 
-        struct tm timeStruct; time_t timeValue;
-        MakeTime(&timeStruct, &timeValue, dayStr, (char*)monthStrCorrect.String(), yearStr, hourStr,
-                 minuteStr, secondStr);
+    BString monthStrCorrect;
+    monthStrCorrect << MonthStrToNum(monthStr);
 
-        // Check to see if last char of pathStr = '/' add it as folder, else as a file
-        uint16 pathLength = pathString.Length() - 1;
-        if (pathString[pathLength] == '/' || permStr[0] == 'd')
-            m_entriesList.AddItem(new ArchiveEntry(true, pathString.String(), sizeStr, packedStr, timeValue, methodStr, crcStr));
-        else
-            m_entriesList.AddItem(new ArchiveEntry(false, pathString.String(), sizeStr, packedStr, timeValue, methodStr, crcStr));
+    // Stupid lha! for directories and some other files reports time in-place of year,
+    // fix that with current system year
+    if (strstr(yearStr, ":"))
+        sprintf(yearStr, "%d", m_modTime.tm_year);
 
-        fgets(lineString, len, fp);
-    }
+    struct tm timeStruct; time_t timeValue;
+    MakeTime(&timeStruct, &timeValue, dayStr, (char*)monthStrCorrect.String(), yearStr, hourStr,
+             minuteStr, secondStr);
 
-    return BZR_DONE;
+    // Check to see if last char of pathStr = '/' add it as folder, else as a file
+    uint16 pathLength = pathString.Length() - 1;
+    if (pathString[pathLength] == '/' || permStr[0] == 'd')
+        return new ArchiveEntry(true, pathString.String(), sizeStr, packedStr, timeValue, methodStr, crcStr);
+    else
+        return new ArchiveEntry(false, pathString.String(), sizeStr, packedStr, timeValue, methodStr, crcStr);
 }
 
 
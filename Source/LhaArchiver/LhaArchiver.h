@@ -7,6 +7,8 @@
 
 #include "Archiver.h"
 
+#include <ctime>
+
 class BMessenger;
 
 class LhaArchiver : public Archiver
@@ -33,6 +35,7 @@ class LhaArchiver : public Archiver
 
     private:
         status_t           ReadOpen(FILE* fp);
+        ArchiveEntry*      ParseOpenLine(char* lineString);
         status_t           ReadExtract(FILE* fp, BMessenger* progress, volatile bool* cancel);
         status_t           ReadTest(FILE* fp, char*& outputStr, BMessenger* progress, volatile bool* cancel);
         status_t           ReadDelete(FILE* fp, char*& outputStr,    BMessenger* progress, volatile bool* cancel);
@@ -40,6 +43,7 @@ class LhaArchiver : public Archiver
         void               SetMimeType();
 
         char               m_lhaPath[B_PATH_NAME_LENGTH];
+        struct tm          m_modTime;
 };
 
 #endif /* _LHA_ARCHIVER_H */
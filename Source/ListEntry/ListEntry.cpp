@@ -5,15 +5,18 @@
 #include "ListEntry.h"
 #include "ColumnListView.h"
 
+#include <DateTimeFormat.h>
+
 #include <cstdlib>
 
 
 // TODO: Why are these text0..text7 (give them better names?)
 ListEntry::ListEntry(uint32 level, bool superitem, bool expanded, BBitmap* icon, const char* text0,
-                     const char* text1, const char* text2, const char* text3, const char* text4, const char* text5,
-                     const char* text6, const char* text7, const char* dirPath, const char* fullPath, int32 length,
-                     int32 packed, time_t timeValue)
-    : CLVEasyItem(level, superitem, expanded, kListEntryHeight, true)
+                     const char* text1, const char* text2, const char* text3, const char* text4, const char* text6,
+                     const char* text7, const char* dirPath, const char* fullPath, off_t length, off_t packed,
+                     time_t timeValue, const BDateTimeFormat* dateFormat)
+    : CLVEasyItem(level, superitem, expanded, kListEntryHeight, true),
+      m_dateFormat(dateFormat)
 {
     SetColumnContent(1, icon, 2.0, false);
     SetColumnContent(2, text0, true);
@@ -21,7 +24,10 @@ ListEntry::ListEntry(uint32 level, bool superitem, bool expanded, BBitmap* icon,
     SetColumnContent(4, text2, true, true);
     SetColumnContent(5, text3, true, true);
     SetColumnContent(6, text4, true);
-    SetColumnContent(7, text5, true);
+    if (superitem == true)
+        SetColumnContent(7, NULL, true);
+    else
+        SetColumnUserTextContent(7, false);
     SetColumnContent(8, text6, true);
     SetColumnContent(9, text7, true);
 
@@ -37,14 +43,19 @@ ListEntry::ListEntry(uint32 level, bool superitem, bool expanded, BBitmap* icon,
     m_fullPath = fullPath;
     m_added = false;
     m_timeValue = timeValue;
+    m_subtreeLength = 0;
+    m_subtreeFiles = 0;
+    m_subtreeFolders = 0;
 }
 
 
 // TODO: Why are these text0..text7 (give them better names?)
 ListEntry::ListEntry(uint32 level, bool superitem, bool expanded, BBitmap* icon, char* text0, char* text1,
-                     char* text2, char* text3, char* text4, char* text5, char* text6, char* text7,
-                     const char* dirPath, const char* fullPath, int32 length, int32 packed, time_t timeValue)
-    : CLVEasyItem(level, superitem, expanded, kListEntryHeight, true)
+                     char* text2, char* text3, char* text4, char* text6, char* text7,
+                     const char* dirPath, const char* fullPath, off_t length, off_t packed, time_t timeValue,
+                     const BDateTimeFormat* dateFormat)
+    : CLVEasyItem(level, superitem, expanded, kListEntryHeight, true),
+      m_dateFormat(dateFormat)
 {
     SetColumnContent(1, icon, 2.0, false);
     SetColumnContent(2, text0, true);
@@ -52,7 +63,10 @@ ListEntry::ListEntry(uint32 level, bool superitem, bool expanded, BBitmap* icon,
     SetColumnContent(4, text2, true, true);
     SetColumnContent(5, text3, true, true);
     SetColumnContent(6, text4, true);
-    SetColumnContent(7, text5, true);
+    if (superitem == true)
+        SetColumnContent(7, NULL, true);
+    else
+        SetColumnUserTextContent(7, false);
     SetColumnContent(8, text6, true);
     SetColumnContent(9, text7, true);
 
@@ -68,6 +82,9 @@ ListEntry::ListEntry(uint32 level, bool superitem, bool expanded, BBitmap* icon,
     m_fullPath = fullPath;
     m_added = false;
     m_timeValue = timeValue;
+    m_subtreeLength = 0;
+    m_subtreeFiles = 0;
+    m_subtreeFolders = 0;
 }
 
 
@@ -81,19 +98,35 @@ void ListEntry::Update(ListEntry* newItem)
     const char* size = newItem->GetColumnContentText(3);
     const char* packed = newItem->GetColumnContentText(4);
     const char* ratio = newItem->GetColumnContentText(5);
-    const char* date = newItem->GetColumnContentText(7);
     const char* method = newItem->GetColumnContentText(8);
     const char* crc = newItem->GetColumnContentText(9);
     m_length = newItem->m_length;
     m_packed = newItem->m_packed;
     m_ratio = newItem->m_ratio;
     m_timeValue = newItem->m_timeValue;
+    m_dateStr.Truncate(0);
 
     // Update UI
     SetColumnContent(3, size, true, true);
     SetColumnContent(4, packed, true, true);
     SetColumnContent(5, ratio, true, true);
-    SetColumnContent(7, date, true);
     SetColumnContent(8, method, true);
     SetColumnContent(9, crc, true);
 }
+
+
+const char* ListEntry::GetUserText(int32 columnIndex, float /*columnWidth*/) const
+{
+    if (columnIndex != 7)
+        return NULL;
+
+    if (m_dateStr.Length() == 0)
+    {
+        // Format date using system settings
+        if (m_dateFormat == NULL
+            || m_dateFormat->Format(m_dateStr, m_timeValue, B_SHORT_DATE_FORMAT, B_SHORT_TIME_FORMAT) != B_OK)
+            m_dateStr = "???";
+    }
+
+    return m_dateStr.String();
+}
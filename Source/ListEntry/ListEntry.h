@@ -9,6 +9,8 @@
 
 #include <String.h>
 
+class BDateTimeFormat;
+
 const float kListEntryHeight = 20.0f;
 
 class ListEntry : public CLVEasyItem
@@ -21,25 +23,38 @@ class ListEntry : public CLVEasyItem
         // TODO: Why are these text0..text7 (give them better names?)
         ListEntry(uint32 level, bool superitem, bool expanded, BBitmap* icon, const char* text0,
                   const char* text1, const char* text2, const char* text3, const char* text4,
-                  const char* text5, const char* text6, const char* text7, const char* dirPath,
-                  const char* fullPath, int32 length, int32 packed, time_t timeValue);
+                  const char* text6, const char* text7, const char* dirPath, const char* fullPath,
+                  off_t length, off_t packed, time_t timeValue, const BDateTimeFormat* dateFormat);
 
         // TODO: Why are these text0..text7 (give them better names?)
         ListEntry(uint32 level, bool superitem, bool expanded, BBitmap* icon, char* text0, char* text1,
-                  char* text2, char* text3, char* text4, char* text5, char* text6, char* text7,
-                  const char* dirPath, const char* fullPath, int32 length, int32 packed, time_t timeValue);
+                  char* text2, char* text3, char* text4, char* text6, char* text7,
+                  const char* dirPath, const char* fullPath, off_t length, off_t packed, time_t timeValue,
+                  const BDateTimeFormat* dateFormat);
 
         // Public hooks
         void               Update(ListEntry* newItem);
+        virtual const char* GetUserText(int32 columnIndex, float columnWidth) const;
 
         // Public members
         BString            m_dirPath,
                            m_fullPath;
-        int32              m_length,
+        off_t              m_length,
                            m_packed;
         int8               m_ratio;
         bool               m_added;
         time_t             m_timeValue;
+
+        // Totals of everything under a folder, filled in by BeezerListView::UpdateSubtreeTotals()
+        off_t              m_subtreeLength;
+        int32              m_subtreeFiles,
+                           m_subtreeFolders;
+
+    private:
+        // Formatted the first time the date column is drawn or asked for, with the formatter of
+        // the archiver (and so the window) the entry belongs to
+        const BDateTimeFormat* m_dateFormat;
+        mutable BString    m_dateStr;
 };
 
 #endif /* _LIST_ENTRY_H */
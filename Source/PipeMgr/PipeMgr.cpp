@@ -4,13 +4,20 @@
 
 #include "PipeMgr.h"
 
+#include <Autolock.h>
 #include <image.h>
+#include <Locker.h>
 #include <String.h>
 
 #include <cstdlib>
 #include <cstdio>
 
 
+// stdout/stderr are process-wide, serialize redirecting them so that archivers running
+// on different threads (eg. batch extraction) don't hand each other their pipes
+static BLocker _pipe_locker("_pipe_mgr_lock");
+
+
 PipeMgr::PipeMgr()
 {
 }
@@ -39,6 +46,8 @@ status_t PipeMgr::AddArg(const char* arg)
 
 thread_id PipeMgr::Pipe(int* outdes, int* errdes) const
 {
+    BAutolock autoLocker(_pipe_locker);
+
     int oldstdout;
     int oldstderr;
     pipe(outdes);
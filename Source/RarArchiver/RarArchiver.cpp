@@ -6,7 +6,9 @@
 #include "RarArchiver.h"
 #include "AppUtils.h"
 #include "ArchiveEntry.h"
+#include "HashTable.h"
 #include "KeyedMenuItem.h"
+#include "RarHeaderReader.h"
 
 #include <NodeInfo.h>
 #include <Messenger.h>
@@ -66,6 +68,10 @@ status_t RarArchiver::ReadOpen(FILE* fp)
          pathStr[B_PATH_NAME_LENGTH + 1];
     uint16 const len = sizeof(lineString);
 
+    HashTable* pathTable = new HashTable(HashTable::OptimalSize(1024));
+    ArchiveEntry* lastEntry = NULL;
+    off_t lastPacked = 0;
+
     bool parseLine = false;
     while (!feof(fp)) {
         fgets(lineString, len, fp);
@@ -99,26 +105,46 @@ status_t RarArchiver::ReadOpen(FILE* fp)
                 isDir = true;
             }
 
-            // Filter duplicates from multipart volume listings
-            bool isDup = false;
-            for (int i = 0; i < m_entriesList.CountItems(); i++) {
-                ArchiveEntry* entry = reinterpret_cast<ArchiveEntry*>(m_entriesList.ItemAt(i));
-                if (pathString.Compare(entry->m_pathStr) == 0) {
-                    isDup = true;
-                    // Files that span multiple volumes show a ratio of -->, <->, or <--
-                    // Recalculate the packed size and ratio
-                    if (ratioStr[1] == '-') {
-                        sprintf(entry->m_packedStr, "%li", atol(entry->m_packedStr) + atol(packedStr));
-                        entry->RecalculateRatio();
+            // Filter duplicates from multipart volume listings, files that span volumes are listed once
+            // per volume and their ratio shows as -->, <->, or <--
+            bool added;
+            pathTable->Insert(pathString.String(), &added);
+            if (added) {
+                lastEntry = new ArchiveEntry(isDir, pathString.String(), sizeStr, packedStr, timeValue, "-", crcStr);
+                lastPacked = atoll(packedStr);
+                m_entriesList.AddItem(lastEntry);
+
+                // The table doesn't grow on its own, keep its chains short on huge archives
+                if (pathTable->CountItems() > pathTable->TableSize()
+                    && pathTable->TableSize() < HashTable::MaxCapacity()) {
+                    delete pathTable;
+                    pathTable = new HashTable(HashTable::OptimalSize(2 * m_entriesList.CountItems()));
+                    for (int32 i = 0; i < m_entriesList.CountItems(); i++)
+                        pathTable->Add(((ArchiveEntry*)m_entriesList.ItemAtFast(i))->m_pathStr);
+                }
+            } else if (ratioStr[1] == '-') {
+                // The continuation of a spanning file follows its previous part, so it's almost always
+                // the last entry we added
+                if (pathString != lastEntry->m_pathStr) {
+                    for (int32 i = m_entriesList.CountItems() - 1; i >= 0; i--) {
+                        lastEntry = (ArchiveEntry*)m_entriesList.ItemAtFast(i);
+                        if (pathString == lastEntry->m_pathStr)
+                            break;
                     }
+                    lastPacked = atoll(lastEntry->m_packedStr);
                 }
-            }
 
-            if (!isDup)
-                m_entriesList.AddItem(new ArchiveEntry(isDir, pathString.String(), sizeStr, packedStr, timeValue, "-", crcStr));
+                lastPacked += atoll(packedStr);
+                BString packedString;
+                packedString << lastPacked;
+                free(lastEntry->m_packedStr);
+                lastEntry->m_packedStr = strdup(packedString.String());
+                lastEntry->RecalculateRatio();
+            }
         }
     }
 
+    delete pathTable;
     return BZR_DONE;
 }
 
@@ -128,6 +154,12 @@ status_t RarArchiver::Open(entry_ref* ref, BMessage* /*fileList*/)
     m_archiveRef = *ref;
     m_archivePath.SetTo(ref);
 
+    // Listing needs nothing but the block headers, so read those ourselves; unrar is only
+    // needed when they are encrypted or not in a form we know
+    RarHeaderReader headerReader(m_archivePath.Path());
+    if (headerReader.ReadEntries(&m_entriesList, &m_passwordRequired) == B_OK)
+        return BZR_DONE;
+
     m_pipeMgr.FlushArgs();
     m_pipeMgr << m_unrarPath << "v" << "-c-" << "-v" << m_archivePath.Path();
 
@@ -0,0 +1,527 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2002 Ramshankar (aka Teknomancer).
+// All rights reserved.
+
+#include "RarHeaderReader.h"
+#include "ArchiveEntry.h"
+#include "AppUtils.h"
+
+#include <Entry.h>
+#include <File.h>
+#include <UnicodeChar.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+static const uint8 kRar4Signature[] = { 'R', 'a', 'r', '!', 0x1a, 0x07, 0x00 };
+static const uint8 kRar5Signature[] = { 'R', 'a', 'r', '!', 0x1a, 0x07, 0x01, 0x00 };
+static const size_t kMaxRar5HeaderSize = 2 * 1024 * 1024;
+
+
+static inline uint16 ReadLE16(const uint8* data)
+{
+    return data[0] | (data[1] << 8);
+}
+
+
+static inline uint32 ReadLE32(const uint8* data)
+{
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32)data[3] << 24);
+}
+
+
+static bool ReadVInt(const uint8* data, size_t size, size_t& pos, uint64& value)
+{
+    // RAR5 variable length integers, 7 bits per byte with the high bit set on all but the last
+    value = 0;
+    for (uint32 shift = 0; pos < size && shift < 64; shift += 7)
+    {
+        uint8 const byte = data[pos++];
+        value |= (uint64)(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+
+static time_t DosTime(uint32 dosTime)
+{
+    struct tm timeStruct;
+    memset(&timeStruct, 0, sizeof(timeStruct));
+    timeStruct.tm_sec = (dosTime & 0x1f) * 2;
+    timeStruct.tm_min = (dosTime >> 5) & 0x3f;
+    timeStruct.tm_hour = (dosTime >> 11) & 0x1f;
+    timeStruct.tm_mday = (dosTime >> 16) & 0x1f;
+    timeStruct.tm_mon = ((dosTime >> 21) & 0x0f) - 1;
+    timeStruct.tm_year = ((dosTime >> 25) & 0x7f) + 80;
+    timeStruct.tm_isdst = -1;
+    return LocalTimeToTime(&timeStruct);
+}
+
+
+RarHeaderReader::RarHeaderReader(const char* archivePath)
+    : m_archivePath(archivePath),
+      m_lastEntry(NULL),
+      m_lastPacked(0),
+      m_passwordRequired(false),
+      m_buffer(NULL),
+      m_bufferSize(0)
+{
+}
+
+
+RarHeaderReader::~RarHeaderReader()
+{
+    for (int32 i = 0; i < m_entriesList.CountItems(); i++)
+        delete (ArchiveEntry*)m_entriesList.ItemAtFast(i);
+
+    free(m_buffer);
+}
+
+
+status_t RarHeaderReader::ReadEntries(BList* entriesList, bool* passwordRequired)
+{
+    // Nothing is handed over unless every volume was read through, so that the caller can
+    // fall back to unrar from a clean slate
+    BString volumePath(m_archivePath);
+    bool isVolume = false, newNumbering = true, isRar5 = false;
+    status_t result = B_OK;
+
+    for (int32 volume = 0; result == B_OK; volume++)
+    {
+        BFile file(volumePath.String(), B_READ_ONLY);
+        if (file.InitCheck() != B_OK)
+        {
+            // Running out of volumes only ends the listing, except for the one we were given
+            result = volume == 0 ? file.InitCheck() : B_OK;
+            break;
+        }
+
+        uint8 signature[sizeof(kRar5Signature)];
+        ssize_t const bytesRead = file.ReadAt(0, signature, sizeof(signature));
+        if (bytesRead >= (ssize_t)sizeof(kRar5Signature)
+            && memcmp(signature, kRar5Signature, sizeof(kRar5Signature)) == 0
+            && (volume == 0 || isRar5))
+        {
+            isRar5 = true;
+            result = ReadRar5Volume(&file, &isVolume);
+        }
+        else if (bytesRead >= (ssize_t)sizeof(kRar4Signature)
+            && memcmp(signature, kRar4Signature, sizeof(kRar4Signature)) == 0
+            && (volume == 0 || isRar5 == false))
+        {
+            result = ReadRar4Volume(&file, &isVolume, &newNumbering);
+        }
+        else
+            result = volume == 0 ? B_NOT_SUPPORTED : B_BAD_DATA;
+
+        if (result != B_OK || isVolume == false || NextVolumePath(volumePath, newNumbering) == false)
+            break;
+    }
+
+    if (m_passwordRequired)
+        *passwordRequired = true;
+
+    if (result != B_OK)
+        return result;
+
+    entriesList->AddList(&m_entriesList);
+    m_entriesList.MakeEmpty();
+    return B_OK;
+}
+
+
+status_t RarHeaderReader::ReadRar4Volume(BFile* file, bool* isVolume, bool* newNumbering)
+{
+    off_t pos = sizeof(kRar4Signature);
+    for (;;)
+    {
+        // Every block starts with CRC(2) TYPE(1) FLAGS(2) SIZE(2), an archive without an end block
+        // simply ends after its last block
+        uint8 base[7];
+        if (file->ReadAt(pos, base, sizeof(base)) != (ssize_t)sizeof(base))
+            return B_OK;
+
+        uint8 const type = base[2];
+        uint16 const flags = ReadLE16(base + 3);
+        uint16 const headerSize = ReadLE16(base + 5);
+        if (headerSize < sizeof(base) || EnsureBuffer(headerSize) == false
+            || file->ReadAt(pos, m_buffer, headerSize) != headerSize)
+            return B_BAD_DATA;
+
+        off_t dataSize = 0;
+        if (type == 0x74 || type == 0x7a)
+        {
+            if (headerSize < 32)
+                return B_BAD_DATA;
+
+            dataSize = ReadLE32(m_buffer + 7);
+            if ((flags & 0x0100) && headerSize >= 40)
+                dataSize |= (off_t)ReadLE32(m_buffer + 32) << 32;
+        }
+        else if ((flags & 0x8000) && headerSize >= 11)
+            dataSize = ReadLE32(m_buffer + 7);
+
+        if (type == 0x73)
+        {
+            // Main header; with encrypted headers there is nothing more we can read
+            if (flags & 0x0080)
+            {
+                m_passwordRequired = true;
+                return B_NOT_SUPPORTED;
+            }
+
+            *isVolume = (flags & 0x0001) != 0;
+            *newNumbering = (flags & 0x0010) != 0;
+        }
+        else if (type == 0x74)
+        {
+            bool const hasHighSizes = (flags & 0x0100) != 0;
+            uint16 const nameSize = ReadLE16(m_buffer + 26);
+            int32 const nameOffset = hasHighSizes ? 40 : 32;
+            if (nameOffset + nameSize > headerSize)
+                return B_BAD_DATA;
+
+            off_t size = ReadLE32(m_buffer + 11);
+            if (hasHighSizes)
+                size |= (off_t)ReadLE32(m_buffer + 36) << 32;
+
+            BString path;
+            if (flags & 0x0200)
+                path = DecodeRar4Name(m_buffer + nameOffset, nameSize);
+            else
+                path.SetTo((const char*)m_buffer + nameOffset, nameSize);
+
+            // Archives made on DOS, OS/2 and Windows use backslashes
+            if (m_buffer[15] <= 2)
+                path.ReplaceAll('\\', '/');
+
+            if (flags & 0x0004)
+                m_passwordRequired = true;
+
+            AddEntry(path.String(), (flags & 0x00e0) == 0x00e0, size, dataSize, DosTime(ReadLE32(m_buffer + 20)),
+                     ReadLE32(m_buffer + 16), (flags & 0x0001) != 0);
+        }
+        else if (type == 0x7b)
+            return B_OK;
+
+        pos += headerSize + dataSize;
+    }
+}
+
+
+status_t RarHeaderReader::ReadRar5Volume(BFile* file, bool* isVolume)
+{
+    off_t pos = sizeof(kRar5Signature);
+    for (;;)
+    {
+        // CRC32(4) is followed by the header size as a vint of at most 3 bytes
+        uint8 prefix[7];
+        ssize_t const prefixSize = file->ReadAt(pos, prefix, sizeof(prefix));
+        if (prefixSize < 5)
+            return B_OK;
+
+        size_t sizePos = 4;
+        uint64 headerSize;
+        if (ReadVInt(prefix, prefixSize, sizePos, headerSize) == false || headerSize == 0
+            || headerSize > kMaxRar5HeaderSize || EnsureBuffer(headerSize) == false)
+            return B_BAD_DATA;
+
+        off_t const headerStart = pos + sizePos;
+        if (file->ReadAt(headerStart, m_buffer, headerSize) != (ssize_t)headerSize)
+            return B_BAD_DATA;
+
+        size_t at = 0;
+        uint64 type, flags, extraSize = 0, dataSize = 0;
+        if (ReadVInt(m_buffer, headerSize, at, type) == false || ReadVInt(m_buffer, headerSize, at, flags) == false
+            || ((flags & 0x0001) && ReadVInt(m_buffer, headerSize, at, extraSize) == false)
+            || ((flags & 0x0002) && ReadVInt(m_buffer, headerSize, at, dataSize) == false)
+            || extraSize > headerSize)
+            return B_BAD_DATA;
+
+        if (type == 1)
+        {
+            uint64 archiveFlags;
+            if (ReadVInt(m_buffer, headerSize, at, archiveFlags) == false)
+                return B_BAD_DATA;
+
+            *isVolume = (archiveFlags & 0x0001) != 0;
+        }
+        else if (type == 2)
+        {
+            uint64 fileFlags, size, attributes, compression, hostOS, nameSize;
+            uint32 modTime = 0, crc = 0;
+            if (ReadVInt(m_buffer, headerSize, at, fileFlags) == false
+                || ReadVInt(m_buffer, headerSize, at, size) == false
+                || ReadVInt(m_buffer, headerSize, at, attributes) == false)
+                return B_BAD_DATA;
+
+            if (fileFlags & 0x0002)
+            {
+                if (at + 4 > headerSize)
+                    return B_BAD_DATA;
+                modTime = ReadLE32(m_buffer + at);
+                at += 4;
+            }
+
+            if (fileFlags & 0x0004)
+            {
+                if (at + 4 > headerSize)
+                    return B_BAD_DATA;
+                crc = ReadLE32(m_buffer + at);
+                at += 4;
+            }
+
+            if (ReadVInt(m_buffer, headerSize, at, compression) == false
+                || ReadVInt(m_buffer, headerSize, at, hostOS) == false
+                || ReadVInt(m_buffer, headerSize, at, nameSize) == false
+                || at + nameSize > headerSize - extraSize)
+                return B_BAD_DATA;
+
+            BString path((const char*)m_buffer + at, nameSize);
+
+            // Walk the extra area for encryption and the more precise time record
+            size_t extraPos = headerSize - extraSize;
+            while (extraPos < headerSize)
+            {
+                uint64 recordSize, recordType;
+                if (ReadVInt(m_buffer, headerSize, extraPos, recordSize) == false || recordSize == 0
+                    || extraPos + recordSize > headerSize)
+                    break;
+
+                size_t const recordEnd = extraPos + recordSize;
+                if (ReadVInt(m_buffer, recordEnd, extraPos, recordType) == false)
+                    break;
+
+                uint64 timeFlags;
+                if (recordType == 0x01)
+                    m_passwordRequired = true;
+                else if (recordType == 0x03 && ReadVInt(m_buffer, recordEnd, extraPos, timeFlags)
+                         && (timeFlags & 0x0002))
+                {
+                    // Unix seconds, or a Windows FILETIME counting 100ns intervals since 1601
+                    if ((timeFlags & 0x0001) && extraPos + 4 <= recordEnd)
+                        modTime = ReadLE32(m_buffer + extraPos);
+                    else if ((timeFlags & 0x0001) == 0 && extraPos + 8 <= recordEnd)
+                    {
+                        uint64 const fileTime = ReadLE32(m_buffer + extraPos)
+                                                | ((uint64)ReadLE32(m_buffer + extraPos + 4) << 32);
+                        modTime = (uint32)(fileTime / 10000000 - 11644473600ULL);
+                    }
+                }
+
+                extraPos = recordEnd;
+            }
+
+            AddEntry(path.String(), (fileFlags & 0x0001) != 0, size, dataSize, modTime, crc, (flags & 0x0008) != 0);
+        }
+        else if (type == 4)
+        {
+            m_passwordRequired = true;
+            return B_NOT_SUPPORTED;
+        }
+        else if (type == 5)
+            return B_OK;
+
+        pos = headerStart + headerSize + dataSize;
+    }
+}
+
+
+void RarHeaderReader::AddEntry(const char* path, bool isDir, off_t size, off_t packed, time_t timeValue,
+                               uint32 crc, bool continued)
+{
+    // A file spanning volumes has a header in each, only its packed size adds up
+    if (continued && m_lastEntry != NULL && strcmp(m_lastEntry->m_pathStr, path) == 0)
+    {
+        m_lastPacked += packed;
+        BString packedStr;
+        packedStr << m_lastPacked;
+        free(m_lastEntry->m_packedStr);
+        m_lastEntry->m_packedStr = strdup(packedStr.String());
+        m_lastEntry->RecalculateRatio();
+        return;
+    }
+
+    BString pathStr(path), sizeStr, packedStr, crcStr;
+    if (isDir)
+        pathStr << '/';
+    sizeStr << size;
+    packedStr << packed;
+    crcStr.SetToFormat("%08" B_PRIX32, crc);
+
+    m_lastEntry = new ArchiveEntry(isDir, pathStr.String(), sizeStr.String(), packedStr.String(), timeValue, "-",
+                                   crcStr.String());
+    m_lastPacked = packed;
+    m_entriesList.AddItem(m_lastEntry);
+}
+
+
+bool RarHeaderReader::NextVolumePath(BString& path, bool newNumbering) const
+{
+    BString nextPath(path);
+    int32 const dot = nextPath.FindLast('.');
+    if (dot < 0)
+        return false;
+
+    if (newNumbering)
+    {
+        // name.part01.rar -> name.part02.rar, growing the number when it runs out of digits
+        int32 i = dot - 1;
+        for (; i >= 0 && nextPath.ByteAt(i) == '9'; i--)
+            nextPath.SetByteAt(i, '0');
+
+        if (i < 0 || nextPath.ByteAt(i) < '0' || nextPath.ByteAt(i) > '9')
+        {
+            if (i + 1 == dot)
+                return false;
+            nextPath.Insert('1', 1, i + 1);
+        }
+        else
+            nextPath.SetByteAt(i, nextPath.ByteAt(i) + 1);
+    }
+    else
+    {
+        // name.rar -> name.r00 ... name.r99 -> name.s00
+        if (nextPath.Length() - dot != 4)
+            return false;
+
+        if (BString(nextPath.String() + dot + 1).ICompare("rar") == 0)
+            nextPath.Truncate(dot + 2) << "00";
+        else
+        {
+            int32 number = atoi(nextPath.String() + dot + 2) + 1;
+            char letter = nextPath.ByteAt(dot + 1);
+            if (number > 99)
+            {
+                number = 0;
+                letter++;
+            }
+
+            BString extension;
+            extension.SetToFormat("%c%02d", letter, (int)number);
+            nextPath.Truncate(dot + 1) << extension;
+        }
+    }
+
+    if (BEntry(nextPath.String()).Exists() == false)
+        return false;
+
+    path = nextPath;
+    return true;
+}
+
+
+BString RarHeaderReader::DecodeRar4Name(const uint8* name, int32 length) const
+{
+    // The plain name is followed by a NUL and the UTF-16 name compressed against it, see
+    // EncodeFileName::Decode in unrar sources
+    int32 plainLength = 0;
+    while (plainLength < length && name[plainLength] != '\0')
+        plainLength++;
+
+    const uint8* encoded = name + plainLength + 1;
+    int32 const encodedSize = length - plainLength - 1;
+    if (encodedSize <= 0)
+        return BString((const char*)name, plainLength);
+
+    uint16 wide[1024];
+    int32 const maxWide = sizeof(wide) / sizeof(wide[0]);
+    int32 encPos = 0, decPos = 0, flagBits = 0;
+    uint8 flags = 0;
+    uint8 const highByte = encoded[encPos++];
+    while (encPos < encodedSize && decPos < maxWide)
+    {
+        if (flagBits == 0)
+        {
+            flags = encoded[encPos++];
+            flagBits = 8;
+        }
+
+        switch (flags >> 6)
+        {
+            case 0:
+                if (encPos >= encodedSize)
+                    break;
+                wide[decPos++] = encoded[encPos++];
+                break;
+
+            case 1:
+                if (encPos >= encodedSize)
+                    break;
+                wide[decPos++] = encoded[encPos++] + (highByte << 8);
+                break;
+
+            case 2:
+                if (encPos + 1 >= encodedSize)
+                {
+                    encPos = encodedSize;
+                    break;
+                }
+                wide[decPos++] = encoded[encPos] + (encoded[encPos + 1] << 8);
+                encPos += 2;
+                break;
+
+            case 3:
+            {
+                if (encPos >= encodedSize)
+                    break;
+
+                int32 runLength = encoded[encPos++];
+                if (runLength & 0x80)
+                {
+                    if (encPos >= encodedSize)
+                        break;
+
+                    uint8 const correction = encoded[encPos++];
+                    for (runLength = (runLength & 0x7f) + 2; runLength > 0 && decPos < maxWide; runLength--, decPos++)
+                        wide[decPos] = ((name[decPos < plainLength ? decPos : 0] + correction) & 0xff) + (highByte << 8);
+                }
+                else
+                {
+                    for (runLength += 2; runLength > 0 && decPos < maxWide; runLength--, decPos++)
+                        wide[decPos] = decPos < plainLength ? name[decPos] : 0;
+                }
+                break;
+            }
+        }
+
+        flags <<= 2;
+        flagBits -= 2;
+    }
+
+    BString result;
+    for (int32 i = 0; i < decPos; i++)
+    {
+        uint32 c = wide[i];
+        if (c >= 0xd800 && c < 0xdc00 && i + 1 < decPos && wide[i + 1] >= 0xdc00 && wide[i + 1] < 0xe000)
+            c = 0x10000 + ((c - 0xd800) << 10) + (wide[++i] - 0xdc00);
+        if (c == 0)
+            break;
+
+        char utf8[5];
+        char* utf8End = utf8;
+        BUnicodeChar::ToUTF8(c, &utf8End);
+        result.Append(utf8, utf8End - utf8);
+    }
+
+    return result;
+}
+
+
+bool RarHeaderReader::EnsureBuffer(size_t size)
+{
+    if (size <= m_bufferSize)
+        return true;
+
+    uint8* buffer = (uint8*)realloc(m_buffer, size);
+    if (buffer == NULL)
+        return false;
+
+    m_buffer = buffer;
+    m_bufferSize = size;
+    return true;
+}
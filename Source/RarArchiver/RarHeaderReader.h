@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2002 Ramshankar (aka Teknomancer).
+// All rights reserved.
+
+#ifndef _RAR_HEADER_READER_H
+#define _RAR_HEADER_READER_H
+
+#include <List.h>
+#include <String.h>
+
+class BFile;
+
+class ArchiveEntry;
+
+// Lists RAR 1.5-4.x and RAR 5.0 archives (including multi-volume ones) straight from their
+// block headers. Extracting is left to unrar, as is listing archives whose headers are encrypted
+class RarHeaderReader
+{
+    public:
+        RarHeaderReader(const char* archivePath);
+        ~RarHeaderReader();
+
+        status_t            ReadEntries(BList* entriesList, bool* passwordRequired);
+
+    private:
+        status_t            ReadRar4Volume(BFile* file, bool* isVolume, bool* newNumbering);
+        status_t            ReadRar5Volume(BFile* file, bool* isVolume);
+        void                AddEntry(const char* path, bool isDir, off_t size, off_t packed, time_t timeValue,
+                                     uint32 crc, bool continued);
+        bool                NextVolumePath(BString& path, bool newNumbering) const;
+        BString             DecodeRar4Name(const uint8* name, int32 length) const;
+        bool                EnsureBuffer(size_t size);
+
+        BString             m_archivePath;
+        BList               m_entriesList;
+        ArchiveEntry*       m_lastEntry;
+        off_t               m_lastPacked;
+        bool                m_passwordRequired;
+        uint8*              m_buffer;
+        size_t              m_bufferSize;
+};
+
+#endif /* _RAR_HEADER_READER_H */
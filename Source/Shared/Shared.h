@@ -25,17 +25,23 @@
 #define BZR_ARCHIVE_PATH_INIT_ERROR   'apie'
 #define BZR_CANCEL_ARCHIVER           'cana'
 #define BZR_UPDATE_PROGRESS           'upda'
+#define BZR_ENTRIES_READY             'aent'
 
 #define BZR_MENUITEM_SELECTED         'amis'
 
 #define M_LAUNCH_TRACKER_ADDON        'ltad'
+#define M_BATCH_EXTRACT               'btex'
 
 const char* const kPath =             "path";
+const char* const kArchiveSubPath =   "archive_sub_path";
+const char* const kStagedLinks =      "staged_links";
+const char* const kBatchDestination = "batch_dest";
 const int64 kMaxFragmentCount =       32767;
 
 #define K_TRACKER_SIGNATURE           "application/x-vnd.Be-TRAK"
 #define K_APP_SIGNATURE               "application/x-vnd.Ram-Beezer"
 #define K_JOINER_STUB_SIGNATURE       "application/x-vnd.Ram-FileJoiner"
+#define K_CLI_SIGNATURE               "application/x-vnd.Ram-Beezer-cli"
 
 // Digital unit multiplier constants, move elsewhere if needed.
 const uint64 kEiBSize = 0x1000000000000000ULL;
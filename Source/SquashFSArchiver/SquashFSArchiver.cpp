@@ -8,6 +8,7 @@
 #include "AppUtils.h"
 #include "ArchiveEntry.h"
 #include "KeyedMenuItem.h"
+#include "SquashFSReader.h"
 
 #include <NodeInfo.h>
 #include <Messenger.h>
@@ -80,6 +81,11 @@ status_t SquashFSArchiver::Open(entry_ref* ref, BMessage* /*fileList*/)
     m_archiveRef = *ref;
     m_archivePath.SetTo(ref);
 
+    // Walk the image's tables ourselves; unsquashfs is only needed for lzo and lz4 images
+    SquashFSReader reader(m_archivePath.Path());
+    if (reader.ReadEntries(&m_entriesList) == B_OK)
+        return BZR_DONE;
+
     m_pipeMgr.FlushArgs();
     m_pipeMgr << m_unsquashfsPath << "-d" << "" << "-llc" << m_archivePath.Path();
 
@@ -96,7 +102,7 @@ status_t SquashFSArchiver::Open(entry_ref* ref, BMessage* /*fileList*/)
     close(outdes[1]);
 
     out = fdopen(outdes[0], "r");
-    status_t exitCode = ReadOpen(out);
+    status_t exitCode = ReadOpenParallel(out);
 
     close(outdes[0]);
     fclose(out);
@@ -110,9 +116,8 @@ status_t SquashFSArchiver::Open(entry_ref* ref, BMessage* /*fileList*/)
 }
 
 
-status_t SquashFSArchiver::ReadOpen(FILE* fp)
+ArchiveEntry* SquashFSArchiver::ParseOpenLine(char* lineString)
 {
-    char lineString[B_PATH_NAME_LENGTH + 512];
     char permStr[15];
     char ownerStr[100];
     char sizeStr[15];
@@ -122,42 +127,34 @@ status_t SquashFSArchiver::ReadOpen(FILE* fp)
     char hourStr[5];
     char minuteStr[5];
     char pathStr[2 * B_PATH_NAME_LENGTH + 10];
-    uint16 const len = sizeof(lineString);
-
-    while (fgets(lineString, len, fp))
-    {
-        lineString[strlen(lineString) - 1] = '\0';
 
-        sscanf(lineString,
+    if (sscanf(lineString,
                "%[^ ] %[^ ] %[0-9] %[0-9]-%[0-9]-%[0-9] %[0-9]:%[0-9] %[^\n]",
-               permStr, ownerStr, sizeStr, yearStr, monthStr, dayStr, hourStr, minuteStr, pathStr);
+               permStr, ownerStr, sizeStr, yearStr, monthStr, dayStr, hourStr, minuteStr, pathStr) != 9)
+        return NULL;
 
-        struct tm timeStruct; time_t timeValue;
-        MakeTime(&timeStruct, &timeValue, dayStr, monthStr, yearStr, hourStr, minuteStr, "00");
+    struct tm timeStruct; time_t timeValue;
+    MakeTime(&timeStruct, &timeValue, dayStr, monthStr, yearStr, hourStr, minuteStr, "00");
 
-        BString pathString = pathStr;
-        pathString.RemoveFirst("/"); // avoids having an empty first-level dir.
-
-        // Handle linked files/folders
-        if (permStr[0] == 'l')
-        {
-            BString fullPath = pathString;
-            uint16 foundIndex = fullPath.FindLast(" -> ");
-            fullPath.Remove(foundIndex, fullPath.Length() - foundIndex);
-            pathString = fullPath.String();
-        }
+    BString pathString = pathStr;
+    pathString.RemoveFirst("/"); // avoids having an empty first-level dir.
 
-        // Check for emtpy dirs:
-        bool isDir = permStr[0] == 'd';
+    // Handle linked files/folders
+    if (permStr[0] == 'l')
+    {
+        BString fullPath = pathString;
+        uint16 foundIndex = fullPath.FindLast(" -> ");
+        fullPath.Remove(foundIndex, fullPath.Length() - foundIndex);
+        pathString = fullPath.String();
+    }
 
-        if (isDir)
-            pathString.Append("/"); // Without this Beezer doesn't shows the entry for some reason.
+    // Check for emtpy dirs:
+    bool isDir = permStr[0] == 'd';
 
-        m_entriesList.AddItem(
-            new ArchiveEntry(isDir, pathString.String(), sizeStr, "-", timeValue, "-", "-"));
-    }
+    if (isDir)
+        pathString.Append("/"); // Without this Beezer doesn't shows the entry for some reason.
 
-    return BZR_DONE;
+    return new ArchiveEntry(isDir, pathString.String(), sizeStr, "-", timeValue, "-", "-");
 }
 
 
@@ -33,7 +33,7 @@ class SquashFSArchiver: public Archiver
         bool        CanDeleteFiles() const;
 
     private:
-        status_t    ReadOpen(FILE* fp);
+        ArchiveEntry* ParseOpenLine(char* lineString);
         status_t    ReadExtract(FILE* fp, BMessenger* progress, volatile bool* cancel);
 
         char        m_unsquashfsPath[B_PATH_NAME_LENGTH];
@@ -0,0 +1,431 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2002 Ramshankar (aka Teknomancer).
+// Copyright (c) 2024 Oscar Lesta.
+// All rights reserved.
+
+#include "SquashFSReader.h"
+#include "ArchiveEntry.h"
+
+#include <File.h>
+
+#include <lzma.h>
+#include <zlib.h>
+#include <zstd.h>
+
+#include <cstdlib>
+#include <cstring>
+
+static const uint32 kSquashFSMagic = 0x73717368;
+static const size_t kSuperBlockSize = 96;
+static const size_t kMetadataSize = 8192;
+static const uint16 kMetadataUncompressed = 0x8000;
+static const uint64 kNoTable = 0xffffffffffffffffULL;
+static const off_t kMaxTableSize = 256 * 1024 * 1024;
+static const int32 kMaxDirDepth = 512;
+
+// Compressor ids from the superblock
+enum
+{
+    kCompressionGZip = 1,
+    kCompressionLzma = 2,
+    kCompressionLzo = 3,
+    kCompressionXz = 4,
+    kCompressionLz4 = 5,
+    kCompressionZstd = 6
+};
+
+// Inode types
+enum
+{
+    kInodeDir = 1,
+    kInodeFile = 2,
+    kInodeSymlink = 3,
+    kInodeExtDir = 8,
+    kInodeExtFile = 9,
+    kInodeExtSymlink = 10
+};
+
+static const size_t kInodeHeaderSize = 16;
+
+
+static inline uint16 ReadLE16(const uint8* data)
+{
+    return data[0] | (data[1] << 8);
+}
+
+
+static inline uint32 ReadLE32(const uint8* data)
+{
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32)data[3] << 24);
+}
+
+
+static inline uint64 ReadLE64(const uint8* data)
+{
+    return ReadLE32(data) | ((uint64)ReadLE32(data + 4) << 32);
+}
+
+
+static uint64 LookupTableStart(BFile* file, uint64 indexStart, bool hasEntries)
+{
+    // The superblock points at a lookup table's index, which comes after the table's metadata
+    // blocks; the index's first entry is where the table really starts
+    uint8 firstBlock[8];
+    if (hasEntries == false || file->ReadAt(indexStart, firstBlock, sizeof(firstBlock)) != sizeof(firstBlock))
+        return indexStart;
+
+    return min_c(ReadLE64(firstBlock), indexStart);
+}
+
+
+SquashFSReader::SquashFSReader(const char* archivePath)
+    : m_archivePath(archivePath),
+      m_compression(0),
+      m_inodeTable(NULL),
+      m_inodeTableSize(0),
+      m_dirTable(NULL),
+      m_dirTableSize(0)
+{
+}
+
+
+SquashFSReader::~SquashFSReader()
+{
+    free(m_inodeTable);
+    free(m_dirTable);
+}
+
+
+status_t SquashFSReader::ReadEntries(BList* entriesList)
+{
+    BFile file(m_archivePath.String(), B_READ_ONLY);
+    if (file.InitCheck() != B_OK)
+        return file.InitCheck();
+
+    uint8 superBlock[kSuperBlockSize];
+    if (file.ReadAt(0, superBlock, sizeof(superBlock)) != (ssize_t)sizeof(superBlock)
+        || ReadLE32(superBlock) != kSquashFSMagic || ReadLE16(superBlock + 28) != 4)
+        return B_NOT_SUPPORTED;
+
+    m_compression = ReadLE16(superBlock + 20);
+    if (m_compression != kCompressionGZip && m_compression != kCompressionLzma
+        && m_compression != kCompressionXz && m_compression != kCompressionZstd)
+        return B_NOT_SUPPORTED;
+
+    uint64 const rootInode = ReadLE64(superBlock + 32);
+    uint64 const bytesUsed = ReadLE64(superBlock + 40);
+    uint64 const inodeTableStart = ReadLE64(superBlock + 64);
+    uint64 const dirTableStart = ReadLE64(superBlock + 72);
+
+    // The directory table runs up to whichever of the fragment, export, id and xattr tables comes
+    // after it (mksquashfs writes them in that order)
+    struct
+    {
+        uint64          indexStart;
+        bool            hasEntries;
+    } const followingTables[] =
+    {
+        { ReadLE64(superBlock + 80), ReadLE32(superBlock + 16) > 0 },
+        { ReadLE64(superBlock + 88), ReadLE32(superBlock + 4) > 0 },
+        { ReadLE64(superBlock + 48), ReadLE16(superBlock + 26) > 0 },
+        { ReadLE64(superBlock + 56), true }
+    };
+
+    uint64 dirTableEnd = bytesUsed;
+    for (size_t i = 0; i < sizeof(followingTables) / sizeof(followingTables[0]); i++)
+    {
+        if (followingTables[i].indexStart == kNoTable)
+            continue;
+
+        uint64 const tableStart = LookupTableStart(&file, followingTables[i].indexStart,
+                                                   followingTables[i].hasEntries);
+        if (tableStart > dirTableStart && tableStart < dirTableEnd)
+            dirTableEnd = tableStart;
+    }
+
+    if (inodeTableStart >= dirTableStart || dirTableStart >= dirTableEnd)
+        return B_BAD_DATA;
+
+    status_t result = ReadTable(&file, inodeTableStart, dirTableStart, m_inodeTable, m_inodeTableSize,
+                                m_inodeBlocks);
+    if (result == B_OK)
+        result = ReadTable(&file, dirTableStart, dirTableEnd, m_dirTable, m_dirTableSize, m_dirBlocks);
+
+    if (result != B_OK)
+        return result;
+
+    BList entries;
+    result = ReadDirectory(rootInode, "", 0, &entries);
+    if (result == B_OK)
+        entriesList->AddList(&entries);
+    else
+    {
+        for (int32 i = 0; i < entries.CountItems(); i++)
+            delete (ArchiveEntry*)entries.ItemAtFast(i);
+    }
+
+    return result;
+}
+
+
+status_t SquashFSReader::ReadTable(BFile* file, off_t start, off_t end, uint8*& data, size_t& size,
+                                   BList& blockList)
+{
+    off_t const diskSize = end - start;
+    if (diskSize > kMaxTableSize)
+        return B_NOT_SUPPORTED;
+
+    uint8* disk = (uint8*)malloc(diskSize);
+    if (disk == NULL)
+        return B_NO_MEMORY;
+
+    if (file->ReadAt(start, disk, diskSize) != diskSize)
+    {
+        free(disk);
+        return B_BAD_DATA;
+    }
+
+    // Every metadata block but the last unpacks to 8 KiB, so a block's place in the unpacked
+    // table is its index times that; only the block's on-disk offset needs to be kept. A short
+    // block ends the table, whatever follows it belongs to the next one
+    status_t result = B_OK;
+    size_t capacity = 0;
+    off_t pos = 0;
+    while (pos + 2 <= diskSize && (size % kMetadataSize) == 0)
+    {
+        uint16 const header = ReadLE16(disk + pos);
+        size_t const blockSize = header & ~kMetadataUncompressed;
+        if (blockSize == 0 || blockSize > kMetadataSize || pos + 2 + (off_t)blockSize > diskSize)
+        {
+            result = B_BAD_DATA;
+            break;
+        }
+
+        if (size + kMetadataSize > capacity)
+        {
+            capacity = capacity == 0 ? (size_t)diskSize * 2 + kMetadataSize : capacity * 2;
+            uint8* newData = (uint8*)realloc(data, capacity);
+            if (newData == NULL)
+            {
+                result = B_NO_MEMORY;
+                break;
+            }
+            data = newData;
+        }
+
+        size_t outSize = kMetadataSize;
+        if (header & kMetadataUncompressed)
+            memcpy(data + size, disk + pos + 2, outSize = blockSize);
+        else
+            result = DecodeBlock(disk + pos + 2, blockSize, data + size, &outSize);
+
+        if (result != B_OK)
+            break;
+
+        blockList.AddItem((void*)(addr_t)pos);
+        size += outSize;
+        pos += 2 + blockSize;
+    }
+
+    free(disk);
+    return result;
+}
+
+
+status_t SquashFSReader::DecodeBlock(const uint8* in, size_t inSize, uint8* out, size_t* outSize) const
+{
+    switch (m_compression)
+    {
+        case kCompressionGZip:
+        {
+            uLongf destSize = *outSize;
+            if (uncompress(out, &destSize, in, inSize) != Z_OK)
+                return B_BAD_DATA;
+
+            *outSize = destSize;
+            return B_OK;
+        }
+
+        case kCompressionXz:
+        {
+            uint64 memLimit = UINT64_MAX;
+            size_t inPos = 0, outPos = 0;
+            if (lzma_stream_buffer_decode(&memLimit, 0, NULL, in, &inPos, inSize, out, &outPos,
+                                          *outSize) != LZMA_OK)
+                return B_BAD_DATA;
+
+            *outSize = outPos;
+            return B_OK;
+        }
+
+        case kCompressionLzma:
+        {
+            lzma_stream stream = LZMA_STREAM_INIT;
+            if (lzma_alone_decoder(&stream, UINT64_MAX) != LZMA_OK)
+                return B_NO_MEMORY;
+
+            stream.next_in = in;
+            stream.avail_in = inSize;
+            stream.next_out = out;
+            stream.avail_out = *outSize;
+            lzma_ret const ret = lzma_code(&stream, LZMA_FINISH);
+            *outSize -= stream.avail_out;
+            lzma_end(&stream);
+            return ret == LZMA_STREAM_END || ret == LZMA_OK ? B_OK : B_BAD_DATA;
+        }
+
+        case kCompressionZstd:
+        {
+            size_t const destSize = ZSTD_decompress(out, *outSize, in, inSize);
+            if (ZSTD_isError(destSize))
+                return B_BAD_DATA;
+
+            *outSize = destSize;
+            return B_OK;
+        }
+    }
+
+    return B_NOT_SUPPORTED;
+}
+
+
+ssize_t SquashFSReader::TableOffset(const BList& blockList, uint32 blockStart, uint16 offset) const
+{
+    int32 low = 0, high = blockList.CountItems() - 1;
+    while (low <= high)
+    {
+        int32 const mid = (low + high) / 2;
+        uint32 const midStart = (uint32)(addr_t)blockList.ItemAtFast(mid);
+        if (midStart == blockStart)
+            return (ssize_t)mid * kMetadataSize + offset;
+        else if (midStart < blockStart)
+            low = mid + 1;
+        else
+            high = mid - 1;
+    }
+
+    return -1;
+}
+
+
+const uint8* SquashFSReader::InodeAt(uint64 inodeRef, size_t minSize) const
+{
+    ssize_t const offset = TableOffset(m_inodeBlocks, (uint32)(inodeRef >> 16), inodeRef & 0xffff);
+    if (offset < 0 || offset + minSize > m_inodeTableSize)
+        return NULL;
+
+    return m_inodeTable + offset;
+}
+
+
+status_t SquashFSReader::ReadDirectory(uint64 inodeRef, const BString& dirPath, int32 depth,
+                                       BList* entriesList)
+{
+    if (depth > kMaxDirDepth)
+        return B_BAD_DATA;
+
+    const uint8* inode = InodeAt(inodeRef, kInodeHeaderSize + 16);
+    if (inode == NULL)
+        return B_BAD_DATA;
+
+    uint32 blockIndex, listingSize;
+    uint16 blockOffset;
+    switch (ReadLE16(inode))
+    {
+        case kInodeDir:
+            blockIndex = ReadLE32(inode + kInodeHeaderSize);
+            listingSize = ReadLE16(inode + kInodeHeaderSize + 8);
+            blockOffset = ReadLE16(inode + kInodeHeaderSize + 10);
+            break;
+
+        case kInodeExtDir:
+            if (InodeAt(inodeRef, kInodeHeaderSize + 24) == NULL)
+                return B_BAD_DATA;
+
+            listingSize = ReadLE32(inode + kInodeHeaderSize + 4);
+            blockIndex = ReadLE32(inode + kInodeHeaderSize + 8);
+            blockOffset = ReadLE16(inode + kInodeHeaderSize + 18);
+            break;
+
+        default:
+            return B_BAD_DATA;
+    }
+
+    // The stored size counts the "." and ".." entries squashfs leaves out as 3 bytes
+    if (listingSize <= 3)
+        return B_OK;
+
+    listingSize -= 3;
+    ssize_t const listingOffset = TableOffset(m_dirBlocks, blockIndex, blockOffset);
+    if (listingOffset < 0 || (size_t)listingOffset + listingSize > m_dirTableSize)
+        return B_BAD_DATA;
+
+    const uint8* listing = m_dirTable + listingOffset;
+    size_t pos = 0;
+    while (pos + 12 <= listingSize)
+    {
+        uint32 const count = ReadLE32(listing + pos) + 1;
+        uint32 const inodeBlock = ReadLE32(listing + pos + 4);
+        pos += 12;
+
+        for (uint32 i = 0; i < count; i++)
+        {
+            if (pos + 8 > listingSize)
+                return B_BAD_DATA;
+
+            uint16 const inodeOffset = ReadLE16(listing + pos);
+            size_t const nameSize = ReadLE16(listing + pos + 6) + 1;
+            if (pos + 8 + nameSize > listingSize)
+                return B_BAD_DATA;
+
+            BString path(dirPath);
+            path.Append((const char*)listing + pos + 8, nameSize);
+            pos += 8 + nameSize;
+
+            uint64 const childRef = ((uint64)inodeBlock << 16) | inodeOffset;
+            const uint8* child = InodeAt(childRef, kInodeHeaderSize);
+            if (child == NULL)
+                return B_BAD_DATA;
+
+            uint16 const type = ReadLE16(child);
+            time_t const modTime = ReadLE32(child + 8);
+            BString sizeStr, methodStr("-");
+            if (type == kInodeDir || type == kInodeExtDir)
+            {
+                path << '/';
+                entriesList->AddItem(new ArchiveEntry(true, path.String(), "0", "-", modTime, "-", "-"));
+
+                status_t result = ReadDirectory(childRef, path, depth + 1, entriesList);
+                if (result != B_OK)
+                    return result;
+
+                continue;
+            }
+
+            if (type == kInodeFile && InodeAt(childRef, kInodeHeaderSize + 16) != NULL)
+                sizeStr << ReadLE32(child + kInodeHeaderSize + 12);
+            else if (type == kInodeExtFile && InodeAt(childRef, kInodeHeaderSize + 16) != NULL)
+                sizeStr << ReadLE64(child + kInodeHeaderSize + 8);
+            else if ((type == kInodeSymlink || type == kInodeExtSymlink)
+                     && InodeAt(childRef, kInodeHeaderSize + 8) != NULL)
+            {
+                // The target follows the link count and its own size, shown where the method would be
+                uint32 const targetSize = ReadLE32(child + kInodeHeaderSize + 4);
+                sizeStr << targetSize;
+                if (targetSize > 0 && targetSize <= m_inodeTableSize
+                    && InodeAt(childRef, kInodeHeaderSize + 8 + targetSize) != NULL)
+                {
+                    methodStr = "-> ";
+                    methodStr.Append((const char*)child + kInodeHeaderSize + 8, targetSize);
+                }
+            }
+            else
+                sizeStr = "0";
+
+            entriesList->AddItem(new ArchiveEntry(false, path.String(), sizeStr.String(), "-", modTime,
+                                                  methodStr.String(), "-"));
+        }
+    }
+
+    return B_OK;
+}
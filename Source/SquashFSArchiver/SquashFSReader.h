@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2002 Ramshankar (aka Teknomancer).
+// Copyright (c) 2024 Oscar Lesta.
+// All rights reserved.
+
+#ifndef _SQUASHFS_READER_H
+#define _SQUASHFS_READER_H
+
+#include <List.h>
+#include <String.h>
+
+class BFile;
+
+// Lists squashfs 4.0 images by walking their directory and inode tables. Images compressed with
+// lzo or lz4 are left to unsquashfs
+class SquashFSReader
+{
+    public:
+                    SquashFSReader(const char* archivePath);
+                    ~SquashFSReader();
+
+        status_t    ReadEntries(BList* entriesList);
+
+    private:
+        status_t    ReadTable(BFile* file, off_t start, off_t end, uint8*& data, size_t& size,
+                              BList& blockList);
+        status_t    DecodeBlock(const uint8* in, size_t inSize, uint8* out, size_t* outSize) const;
+        status_t    ReadDirectory(uint64 inodeRef, const BString& dirPath, int32 depth,
+                                  BList* entriesList);
+        const uint8* InodeAt(uint64 inodeRef, size_t minSize) const;
+        ssize_t     TableOffset(const BList& blockList, uint32 blockStart, uint16 offset) const;
+
+        BString     m_archivePath;
+        uint16      m_compression;
+        uint8*      m_inodeTable;
+        size_t      m_inodeTableSize;
+        BList       m_inodeBlocks;
+        uint8*      m_dirTable;
+        size_t      m_dirTableSize;
+        BList       m_dirBlocks;
+};
+
+#endif /* _SQUASHFS_READER_H */
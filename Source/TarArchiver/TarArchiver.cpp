@@ -6,10 +6,17 @@
 #include "TarArchiver.h"
 #include "ArchiveEntry.h"
 #include "AppUtils.h"
+#include "FormatSniffer.h"
 
+#include <File.h>
 #include <NodeInfo.h>
 #include <Messenger.h>
 
+#include <fs_attr.h>
+
+#include <cstdlib>
+#include <cstring>
+
 #ifdef HAIKU_ENABLE_I18N
 #include <Catalog.h>
 
@@ -44,51 +51,43 @@ status_t TarArchiver::InitBinaryPath()
 }
 
 
-status_t TarArchiver::ReadOpen(FILE* fp)
+ArchiveEntry* TarArchiver::ParseOpenLine(char* lineString)
 {
-    char lineString[B_PATH_NAME_LENGTH + 512],
-         permStr[15], ownerStr[100], sizeStr[15],
+    char permStr[15], ownerStr[100], sizeStr[15],
          dayStr[5], monthStr[5], yearStr[8], hourStr[5], minuteStr[5],
          pathStr[2 * B_PATH_NAME_LENGTH + 10];
-    uint16 const len = sizeof(lineString);
-
-    while (fgets(lineString, len, fp))
-    {
-        lineString[strlen(lineString) - 1] = '\0';
 
-        sscanf(lineString,
+    if (sscanf(lineString,
                "%[^ ] %[^ ] %[0-9] %[0-9]-%[0-9]-%[0-9] %[0-9]:%[0-9]%[^\n]",
-               permStr, ownerStr, sizeStr, yearStr, monthStr, dayStr, hourStr, minuteStr, pathStr);
+               permStr, ownerStr, sizeStr, yearStr, monthStr, dayStr, hourStr, minuteStr, pathStr) != 9)
+        return NULL;
 
-        struct tm timeStruct; time_t timeValue;
-        MakeTime(&timeStruct, &timeValue, dayStr, monthStr, yearStr, hourStr, minuteStr, "00");
+    struct tm timeStruct; time_t timeValue;
+    MakeTime(&timeStruct, &timeValue, dayStr, monthStr, yearStr, hourStr, minuteStr, "00");
 
-        // Bugfix workaround for files/folders with space before them
-        BString pathString = pathStr;
-        pathString.Remove(0, 1);
+    // Bugfix workaround for files/folders with space before them
+    BString pathString = pathStr;
+    pathString.Remove(0, 1);
 
-        // Handle linked files/folder by tar
-        if (permStr[0] == 'l')
-        {
-            BString fullPath = pathString;
-            uint16 foundIndex = fullPath.FindLast(" -> ");
-            fullPath.Remove(foundIndex, fullPath.Length() - foundIndex);
-            pathString = fullPath.String();
-        }
-
-        // Check to see if last char of pathStr = '/' add it as folder, else as a file
-        uint16 pathLength = pathString.Length() - 1;
-        if (pathString[pathLength] == '/' || permStr[0] == 'd')
-            m_entriesList.AddItem(new ArchiveEntry(true, pathString.String(), sizeStr, sizeStr, timeValue, "-", "-"));
-        else
-            m_entriesList.AddItem(new ArchiveEntry(false, pathString.String(), sizeStr, sizeStr, timeValue, "-", "-"));
+    // Handle linked files/folder by tar
+    if (permStr[0] == 'l')
+    {
+        BString fullPath = pathString;
+        uint16 foundIndex = fullPath.FindLast(" -> ");
+        fullPath.Remove(foundIndex, fullPath.Length() - foundIndex);
+        pathString = fullPath.String();
     }
 
-    return BZR_DONE;
+    // Check to see if last char of pathStr = '/' add it as folder, else as a file
+    uint16 pathLength = pathString.Length() - 1;
+    if (pathString[pathLength] == '/' || permStr[0] == 'd')
+        return new ArchiveEntry(true, pathString.String(), sizeStr, sizeStr, timeValue, "-", "-");
+    else
+        return new ArchiveEntry(false, pathString.String(), sizeStr, sizeStr, timeValue, "-", "-");
 }
 
 
-status_t TarArchiver::Open(entry_ref* ref, BMessage* /*fileList*/)
+status_t TarArchiver::Open(entry_ref* ref, BMessage* fileList)
 {
     m_archiveRef = *ref;
     m_archivePath.SetTo(ref);
@@ -96,9 +95,25 @@ status_t TarArchiver::Open(entry_ref* ref, BMessage* /*fileList*/)
     m_pipeMgr.FlushArgs();
     m_pipeMgr << m_tarPath << "-tv" << "-f" << m_archivePath.Path();
 
-    // Currently, we don't list individual files specified in fileList. This is
-    // because while deleting files from tar, it doesn't report the deleted files thus
-    // the entire archive is reloaded after deleting, so specific files are skipped
+    // When we're given the files that were just added, list only those. Since tar appends
+    // rather than replaces, older members with the same name are listed too, and those are
+    // already with the caller; so only the trailing 'addedCount' entries are kept
+    int32 addedCount = 0;
+    if (fileList)
+    {
+        uint32 type;
+        fileList->GetInfo(kPath, &type, &addedCount);
+        if (addedCount == 0)
+            return BZR_DONE;
+
+        m_pipeMgr << "--no-recursion";
+        for (int32 i = 0; i < addedCount; i++)
+        {
+            const char* path;
+            if (fileList->FindString(kPath, i, &path) == B_OK)
+                m_pipeMgr << SupressWildcards(path);
+        }
+    }
 
     FILE* out, *err;
     int outdes[2], errdes[2];
@@ -114,11 +129,19 @@ status_t TarArchiver::Open(entry_ref* ref, BMessage* /*fileList*/)
     close(outdes[1]);
 
     out = fdopen(outdes[0], "r");
-    exitCode = ReadOpen(out);
+    int32 const prevCount = m_entriesList.CountItems();
+    exitCode = ReadOpenParallel(out);
 
     close(outdes[0]);
     fclose(out);
 
+    if (fileList)
+    {
+        int32 const staleCount = m_entriesList.CountItems() - prevCount - addedCount;
+        for (int32 i = 0; i < staleCount; i++)
+            delete (ArchiveEntry*)m_entriesList.RemoveItem(prevCount);
+    }
+
     err = fdopen(errdes[0], "r");
     exitCode = Archiver::ReadErrStream(err, NULL);
     close(errdes[0]);
@@ -252,8 +275,43 @@ status_t TarArchiver::Add(bool createMode, const char* relativePath, BMessage* m
             return BZR_ARCHIVE_PATH_INIT_ERROR;
     }
 
+    return AddPaths(NULL, relativePath, message, addedPaths, progress, cancel);
+}
+
+
+status_t TarArchiver::CreateCompressed(const char* compressProgram, const char* relativePath, BMessage* message,
+                                       BMessage* addedPaths, BMessenger* progress, volatile bool* cancel)
+{
+    return AddPaths(compressProgram, relativePath, message, addedPaths, progress, cancel);
+}
+
+
+status_t TarArchiver::AddPaths(const char* compressProgram, const char* relativePath, BMessage* message,
+                               BMessage* addedPaths, BMessenger* progress, volatile bool* cancel)
+{
     m_pipeMgr.FlushArgs();
-    m_pipeMgr << m_tarPath << "-pv" << "-f" << m_archivePath.Path() << "-r";
+    if (compressProgram == NULL)
+        m_pipeMgr << m_tarPath << "-pv" << "-f" << m_archivePath.Path() << "-r";
+    else
+    {
+        // tar writes through the compressor as it goes, it can't append to compressed archives
+        BString program;
+        program << "--use-compress-program=" << compressProgram;
+        m_pipeMgr << m_tarPath << "-cpv" << "-f" << m_archivePath.Path() << program;
+    }
+
+    // Prefix member names with the folder inside the archive instead of staging copies of the files
+    // in a temp dir. Symlink targets (S) are left alone, transformed names are what gets reported back.
+    const char* subPath = NULL;
+    if (message->FindString(kArchiveSubPath, &subPath) == B_OK && subPath != NULL && subPath[0] != '\0')
+    {
+        BString prefix = subPath;
+        prefix.CharacterEscape("\\&|", '\\');
+
+        BString transform;
+        transform << "--transform=s|^|" << prefix << "/|S";
+        m_pipeMgr << transform << "--show-transformed-names";
+    }
 
     int32 count = 0L;
     uint32 type;
@@ -343,13 +401,12 @@ status_t TarArchiver::ReadAdd(FILE* fp, BMessage* addedPaths, BMessenger* progre
 status_t TarArchiver::Delete(char*& outputStr, BMessage* message, BMessenger* progress,
                              volatile bool* cancel)
 {
-    // Setup deleting process
+    // We rewrite the archive ourselves rather than use "tar --delete": surviving members are
+    // copied across in large sequential runs, only headers of the rest are ever read
+    outputStr = NULL;
     BEntry archiveEntry(&m_archiveRef, true);
     if (archiveEntry.Exists() == false)
-    {
-        outputStr = NULL;
         return BZR_ARCHIVE_PATH_INIT_ERROR;
-    }
 
     int32 count = 0L;
     if (message)
@@ -360,64 +417,330 @@ status_t TarArchiver::Delete(char*& outputStr, BMessage* message, BMessenger* pr
             return BZR_UNKNOWN;
     }
 
-    m_pipeMgr.FlushArgs();
-    m_pipeMgr << m_tarPath << "-pv" << "-f" << m_archivePath.Path() << "--delete";
+    if (count == 0)
+        return BZR_DONE;
 
-    int32 i = 0L;
-    for (; i < count; i ++)
+    // Sorted so that each member (and each of its parent folders) is a binary search away
+    BList deletePaths(count);
+    for (int32 i = 0; i < count; i++)
     {
         const char* pathString = NULL;
         if (message->FindString(kPath, i, &pathString) == B_OK)
-            m_pipeMgr << SupressWildcards(pathString);
+        {
+            BString* path = new BString(pathString);
+            path->ReplaceAll("\\*", "*");
+            if (path->Length() > 1 && path->ByteAt(path->Length() - 1) == '/')
+                path->Truncate(path->Length() - 1);
+            deletePaths.AddItem(path);
+        }
     }
+    deletePaths.SortItems(&CompareStringPointers);
 
-    FILE* out, *err;
-    int outdes[2], errdes[2];
-    thread_id tid = m_pipeMgr.Pipe(outdes, errdes);
+    BString tempPath(m_archivePath.Path());
+    tempPath << ".bzrtmp";
 
-    if (tid == B_ERROR || tid == B_NO_MEMORY)
+    BFile srcFile(m_archivePath.Path(), B_READ_ONLY);
+    BFile destFile(tempPath.String(), B_READ_WRITE | B_CREATE_FILE | B_ERASE_FILE);
+    status_t exitCode = BZR_DONE;
+    if (srcFile.InitCheck() != B_OK || destFile.InitCheck() != B_OK)
+        exitCode = BZR_ARCHIVE_PATH_INIT_ERROR;
+    else
+        exitCode = RewriteWithout(&srcFile, &destFile, &deletePaths, progress, cancel);
+
+    for (int32 i = 0; i < deletePaths.CountItems(); i++)
+        delete (BString*)deletePaths.ItemAtFast(i);
+
+    if (exitCode == BZR_DONE)
     {
-        outputStr = NULL;        // Handle unloadable error here
-        return B_ERROR;
+        // The rewrite replaces the archive, so it takes over all of its attributes (the type,
+        // comments, Tracker info and our own bzr: state) and its permissions
+        char name[B_ATTR_NAME_LENGTH];
+        srcFile.RewindAttrs();
+        while (srcFile.GetNextAttrName(name) == B_OK)
+        {
+            attr_info info;
+            if (srcFile.GetAttrInfo(name, &info) != B_OK)
+                continue;
+
+            char* buffer = (char*)malloc(info.size);
+            if (buffer == NULL)
+                continue;
+
+            ssize_t const bytesRead = srcFile.ReadAttr(name, info.type, 0, buffer, info.size);
+            if (bytesRead > 0)
+                destFile.WriteAttr(name, info.type, 0, buffer, bytesRead);
+            free(buffer);
+        }
+
+        mode_t perms;
+        if (srcFile.GetPermissions(&perms) == B_OK)
+            destFile.SetPermissions(perms);
+
+        destFile.Unset();
+        BEntry tempEntry(tempPath.String());
+        if (tempEntry.Rename(m_archivePath.Path(), true) != B_OK)
+            exitCode = BZR_ERRSTREAM_FOUND;
     }
 
-    resume_thread(tid);
+    if (exitCode != BZR_DONE)
+    {
+        destFile.Unset();
+        BEntry(tempPath.String()).Remove();
+    }
 
-    close(errdes[1]);
-    close(outdes[1]);
+    return exitCode;
+}
 
-    out = fdopen(outdes[0], "r");
-    status_t exitCode = ReadDelete(out, outputStr, progress, cancel);
-    if (exitCode != BZR_CANCEL_ARCHIVER)
+
+status_t TarArchiver::RewriteWithout(BFile* srcFile, BFile* destFile, BList* deletePaths, BMessenger* progress,
+                                     volatile bool* cancel)
+{
+    BMessage updateMessage(BZR_UPDATE_PROGRESS), reply('DUMB');
+    updateMessage.AddFloat("delta", 1.0f);
+
+    char header[kTarBlockSize];
+    char* buffer = new char[kTarCopyBufferSize];
+    BString longName, paxPath;
+    off_t pos = 0, runStart = 0, groupStart = -1, destSize = 0;
+    status_t exitCode = BZR_DONE;
+
+    while (exitCode == BZR_DONE)
     {
-        err = fdopen(errdes[0], "r");
-        exitCode = Archiver::ReadErrStream(err);
-        close(errdes[0]);
-        fclose(err);
+        if (cancel && *cancel == true)
+        {
+            exitCode = BZR_CANCEL_ARCHIVER;
+            break;
+        }
+
+        // A short read or an all-zero block both mark the end of the archive
+        if (srcFile->ReadAt(pos, header, kTarBlockSize) != kTarBlockSize || header[0] == '\0')
+            break;
+
+        if (IsValidTarHeader(header) == false)
+        {
+            exitCode = BZR_ERRSTREAM_FOUND;
+            break;
+        }
+
+        off_t const dataSize = TarNumber(header + 124, 12);
+        off_t const dataBlocks = (dataSize + kTarBlockSize - 1) / kTarBlockSize;
+        off_t memberEnd = pos + kTarBlockSize * (1 + dataBlocks);
+        char const typeFlag = header[156];
+
+        // GNU long names and pax headers describe the member that follows them; they belong to it
+        if (typeFlag == 'L' || typeFlag == 'K' || typeFlag == 'x')
+        {
+            if (groupStart < 0)
+                groupStart = pos;
+
+            if (typeFlag != 'K')
+            {
+                if (dataSize > kTarCopyBufferSize - 1
+                    || srcFile->ReadAt(pos + kTarBlockSize, buffer, dataSize) != dataSize)
+                {
+                    exitCode = BZR_ERRSTREAM_FOUND;
+                    break;
+                }
+
+                buffer[dataSize] = '\0';
+                if (typeFlag == 'L')
+                    longName = buffer;
+                else
+                    paxPath = PaxValue(buffer, dataSize, "path");
+            }
+
+            pos = memberEnd;
+            continue;
+        }
+
+        // Old GNU sparse members may carry extra header blocks
+        if (typeFlag == 'S')
+        {
+            bool isExtended = header[482] != '\0';
+            off_t extPos = pos + kTarBlockSize;
+            while (isExtended)
+            {
+                char extHeader[kTarBlockSize];
+                if (srcFile->ReadAt(extPos, extHeader, kTarBlockSize) != kTarBlockSize)
+                    break;
+                isExtended = extHeader[504] != '\0';
+                extPos += kTarBlockSize;
+                memberEnd += kTarBlockSize;
+            }
+        }
+
+        BString name;
+        if (longName.Length() > 0)
+            name = longName;
+        else if (paxPath.Length() > 0)
+            name = paxPath;
+        else
+        {
+            // Only POSIX ustar has the prefix field, GNU tar uses that space for other things
+            if (memcmp(header + 257, "ustar\0", 6) == 0 && header[345] != '\0')
+                name.SetTo(header + 345, 155) << '/';
+            name.Append(header, 100);
+        }
+
+        if (groupStart < 0)
+            groupStart = pos;
+
+        if (typeFlag != 'g' && IsPathDeleted(name, deletePaths))
+        {
+            exitCode = CopyTarRange(srcFile, destFile, runStart, groupStart - runStart, buffer);
+            destSize += groupStart - runStart;
+            runStart = memberEnd;
+
+            if (progress && name.ByteAt(name.Length() - 1) != '/')
+            {
+                updateMessage.RemoveName("text");
+                updateMessage.AddString("text", FinalPathComponent(name.String()));
+                progress->SendMessage(&updateMessage, &reply);
+            }
+        }
+
+        longName = "";
+        paxPath = "";
+        groupStart = -1;
+        pos = memberEnd;
     }
-    close(outdes[0]);
-    fclose(out);
 
-    // Send signal to quit thread only AFTER pipes are closed
-    if (exitCode == BZR_CANCEL_ARCHIVER)
-        TerminateThread(tid);
+    if (exitCode == BZR_DONE)
+    {
+        exitCode = CopyTarRange(srcFile, destFile, runStart, pos - runStart, buffer);
+        destSize += pos - runStart;
+    }
 
-    m_pipeMgr.FlushArgs();
+    // End of archive is two zero blocks, then pad up to a whole record like tar does
+    if (exitCode == BZR_DONE)
+    {
+        off_t padSize = 2 * kTarBlockSize;
+        padSize += (kTarRecordSize - (destSize + padSize) % kTarRecordSize) % kTarRecordSize;
+        memset(buffer, 0, padSize);
+        if (destFile->WriteAt(destSize, buffer, padSize) != padSize)
+            exitCode = BZR_ERRSTREAM_FOUND;
+    }
+
+    delete[] buffer;
     return exitCode;
 }
 
 
-status_t TarArchiver::ReadDelete(FILE* fp, char*& /*outputStr*/, BMessenger* /*progress*/,
-                                 volatile bool* /*cancel*/)
+status_t TarArchiver::CopyTarRange(BFile* srcFile, BFile* destFile, off_t offset, off_t length, char* buffer) const
 {
-    char lineString[999];
-    while (!feof(fp) && fgets(lineString, 998, fp))
-        ;
+    // The destination is only ever appended to
+    off_t destOffset;
+    destFile->GetSize(&destOffset);
+
+    while (length > 0)
+    {
+        ssize_t const chunk = min_c(length, (off_t)kTarCopyBufferSize);
+        if (srcFile->ReadAt(offset, buffer, chunk) != chunk || destFile->WriteAt(destOffset, buffer, chunk) != chunk)
+            return BZR_ERRSTREAM_FOUND;
+
+        offset += chunk;
+        destOffset += chunk;
+        length -= chunk;
+    }
 
     return BZR_DONE;
 }
 
 
+bool TarArchiver::IsPathDeleted(BString const& memberName, BList* deletePaths) const
+{
+    // A member goes if it or any of its parent folders were selected
+    BString path(memberName);
+    if (path.Length() > 1 && path.ByteAt(path.Length() - 1) == '/')
+        path.Truncate(path.Length() - 1);
+
+    while (path.Length() > 0)
+    {
+        BString* key = &path;
+        if (bsearch(&key, deletePaths->Items(), deletePaths->CountItems(), sizeof(void*), &CompareStringPointers))
+            return true;
+
+        int32 const slash = path.FindLast('/');
+        if (slash <= 0)
+            break;
+        path.Truncate(slash);
+    }
+
+    return false;
+}
+
+
+bool TarArchiver::IsValidTarHeader(const char* header) const
+{
+    // The checksum is the byte sum of the header with the checksum field itself taken as spaces,
+    // some old tars summed signed bytes so accept that too
+    int32 sum = 0, signedSum = 0;
+    for (int32 i = 0; i < kTarBlockSize; i++)
+    {
+        bool const isChecksum = i >= 148 && i < 156;
+        sum += isChecksum ? ' ' : (uint8)header[i];
+        signedSum += isChecksum ? ' ' : (int8)header[i];
+    }
+
+    off_t const checksum = TarNumber(header + 148, 8);
+    return sum == checksum || signedSum == checksum;
+}
+
+
+off_t TarArchiver::TarNumber(const char* field, int32 length) const
+{
+    // Numbers are octal text, except large ones which GNU tar stores as base-256 with the top bit set
+    off_t value = 0;
+    if ((uint8)field[0] & 0x80)
+    {
+        value = (uint8)field[0] & 0x7f;
+        for (int32 i = 1; i < length; i++)
+            value = (value << 8) | (uint8)field[i];
+        return value;
+    }
+
+    for (int32 i = 0; i < length && field[i] != '\0'; i++)
+    {
+        if (field[i] >= '0' && field[i] <= '7')
+            value = (value << 3) | (field[i] - '0');
+    }
+
+    return value;
+}
+
+
+BString TarArchiver::PaxValue(const char* records, off_t length, const char* key) const
+{
+    // Records are "<length> <key>=<value>\n" where <length> counts the whole record
+    size_t const keyLength = strlen(key);
+    off_t pos = 0;
+    while (pos < length)
+    {
+        char* valueStart;
+        long recordLength = strtol(records + pos, &valueStart, 10);
+        if (recordLength <= 0 || pos + recordLength > length)
+            break;
+
+        valueStart++;
+        if (strncmp(valueStart, key, keyLength) == 0 && valueStart[keyLength] == '=')
+        {
+            valueStart += keyLength + 1;
+            return BString(valueStart, records + pos + recordLength - 1 - valueStart);
+        }
+
+        pos += recordLength;
+    }
+
+    return BString();
+}
+
+
+int TarArchiver::CompareStringPointers(const void* a, const void* b)
+{
+    return strcmp((*(BString**)a)->String(), (*(BString**)b)->String());
+}
+
+
 status_t TarArchiver::Create(BPath* archivePath, const char* relPath, BMessage* fileList, BMessage* addedPaths,
                              BMessenger* progress, volatile bool* cancel)
 {
@@ -441,21 +764,12 @@ status_t TarArchiver::Create(BPath* archivePath, const char* relPath, BMessage*
 
 bool TarArchiver::IsTarArchive(const char *filePath) const
 {
-    // Update mime type of the file.
-    update_mime_info(filePath, false /* recursive */, true /* synchronous */, false /* force */);
-
-    // Get the updated mime type
-    BNode destNode(filePath);
-    BNodeInfo destNodeInfo(&destNode);
-    char mimeBuf[B_MIME_TYPE_LENGTH];
-    destNodeInfo.GetType(mimeBuf);
-
-    // Check if the mime type is that of a tar archive
-    for (int32 i = 0; i < m_mimeList.CountItems(); i++)
-    {
-        if (!strcmp(mimeBuf, (const char *)m_mimeList.ItemAtFast(i)))
-            return true;
-    }
+    // Check the first header rather than waiting on update_mime_info() to do the same
+    BFile file(filePath, B_READ_ONLY);
+    uint8 header[kSniffSize];
+    if (file.InitCheck() == B_OK && file.ReadAt(0, header, sizeof(header)) == (ssize_t)sizeof(header)
+            && IsTarHeader(header, sizeof(header)))
+        return true;
 
     // Check if the file extension is ".tar"
     BString extensionStr = filePath;
@@ -488,7 +802,13 @@ bool TarArchiver::CanReplaceFiles() const
 }
 
 
+bool TarArchiver::CanAddUnderPath() const
+{
+    return true;
+}
+
+
 bool TarArchiver::CanPartiallyOpen() const
 {
-    return false;
+    return true;
 }
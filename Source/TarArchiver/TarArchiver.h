@@ -7,8 +7,13 @@
 
 #include "Archiver.h"
 
+class BFile;
 class BMessenger;
 
+const int32 kTarBlockSize = 512;
+const int32 kTarRecordSize = 20 * kTarBlockSize;
+const int32 kTarCopyBufferSize = 512 * 1024;
+
 class TarArchiver : public Archiver
 {
     public:
@@ -28,13 +33,29 @@ class TarArchiver : public Archiver
         virtual BList      HiddenColumns(BList const& columnList) const;
 
         virtual bool       CanReplaceFiles() const;
+        virtual bool       CanAddUnderPath() const;
         virtual bool       CanPartiallyOpen() const;
 
+    protected:
+        // Creates a new archive with tar writing through 'compressProgram' (stdin to stdout)
+        status_t           CreateCompressed(const char* compressProgram, const char* relPath, BMessage* list,
+                                            BMessage* addedPaths, BMessenger* progress, volatile bool* cancel);
+
     private:
-        status_t           ReadOpen(FILE* fp);
+        status_t           AddPaths(const char* compressProgram, const char* relPath, BMessage* list,
+                                    BMessage* addedPaths, BMessenger* progress, volatile bool* cancel);
+        ArchiveEntry*      ParseOpenLine(char* lineString);
         status_t           ReadExtract(FILE* fp, BMessenger* progress, volatile bool* cancel);
         status_t           ReadAdd(FILE* fp, BMessage* addedPaths, BMessenger* progress, volatile bool* cancel);
-        status_t           ReadDelete(FILE* fp, char*& outputStr, BMessenger* progress, volatile bool* cancel);
+        status_t           RewriteWithout(BFile* srcFile, BFile* destFile, BList* deletePaths,
+                                          BMessenger* progress, volatile bool* cancel);
+        status_t           CopyTarRange(BFile* srcFile, BFile* destFile, off_t offset, off_t length,
+                                        char* buffer) const;
+        bool               IsPathDeleted(BString const& memberName, BList* deletePaths) const;
+        bool               IsValidTarHeader(const char* header) const;
+        off_t              TarNumber(const char* field, int32 length) const;
+        BString            PaxValue(const char* records, off_t length, const char* key) const;
+        static int         CompareStringPointers(const void* a, const void* b);
 
         status_t           InitBinaryPath();
 
@@ -5,6 +5,7 @@
 #include <Roster.h>
 #include <Entry.h>
 #include <Alert.h>
+#include <InterfaceDefs.h>
 #include <TrackerAddOn.h>
 #include <String.h>
 
@@ -13,9 +14,17 @@
 #include "Shared.h"
 
 
-void process_refs(entry_ref, BMessage* message, void*)
+void process_refs(entry_ref dirRef, BMessage* message, void*)
 {
-    message->what = M_LAUNCH_TRACKER_ADDON;
+    // Holding Shift extracts each of the selected archives into the current folder
+    if (modifiers() & B_SHIFT_KEY)
+    {
+        message->what = M_BATCH_EXTRACT;
+        message->AddRef(kBatchDestination, &dirRef);
+    }
+    else
+        message->what = M_LAUNCH_TRACKER_ADDON;
+
     be_roster->Launch(K_APP_SIGNATURE, message);
 }
 
@@ -27,6 +36,7 @@ int main()
     str << "This must be placed in:\n";
     str << "/boot/home/config/add-ons/Tracker\n\n";
     str << "To use this add-on choose the files you with to archive, right-click them and choose this add-on" B_UTF8_ELLIPSIS;
+    str << "\n\nHold Shift while choosing it to extract the selected archives instead.";
 
     str.Prepend("alert \"");
     str.Append("\"");
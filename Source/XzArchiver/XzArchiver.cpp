@@ -6,6 +6,7 @@
 #include "XzArchiver.h"
 #include "ArchiveEntry.h"
 #include "AppUtils.h"
+#include "KeyedMenuItem.h"
 
 #include <Messenger.h>
 #include <MenuItem.h>
@@ -19,9 +20,16 @@
 #define B_TRANSLATION_CONTEXT "XzArchiver"
 #else
 #define B_TRANSLATE(x) x
+#define B_TRANSLATE_MARK(x) x
+#define B_TRANSLATE_NOCOLLECT(x) x
 #endif
 
 
+static const char
+    *kAutoLevel        = B_TRANSLATE_MARK("Use fastest level for already compressed data"),
+    *kDeduplicate      = B_TRANSLATE_MARK("Compress duplicate files only once");
+
+
 Archiver* load_archiver(BMessage* metaDataMsg)
 {
     return new XzArchiver(metaDataMsg);
@@ -83,15 +91,8 @@ status_t XzArchiver::Open(entry_ref* ref, BMessage* fileList)
     m_archiveRef = *ref;
     m_archivePath.SetTo(ref);
 
-    // We are redirecting (>) shell output to file, therefore we need to use /bin/sh -c <command>
     BString destPath = InitTarFilePath(ref->name);
-    BString cmd;
-    cmd << "\"" << m_xzPath << "\"" << " -c -d \"" << m_archivePath.Path() << "\" > " << "\"" <<
-    m_tarFilePath << "\"";
-
-    m_pipeMgr.FlushArgs();
-    m_pipeMgr << "/bin/sh" << "-c" << cmd.String();
-    m_pipeMgr.Pipe();
+    DecompressToTemp();
 
     if (TarArchiver::IsTarArchive(destPath.String()))
     {
@@ -173,6 +174,9 @@ status_t XzArchiver::Extract(entry_ref* refToDir, BMessage* message, BMessenger*
     }
     else
     {
+        if (BEntry(m_tarFilePath).Exists() == false)
+            DecompressToTemp();
+
         m_archivePath = m_tarFilePath;
         status_t exitCode = TarArchiver::Extract(refToDir, message, progress, cancel);
         m_archivePath = m_arkFilePath;
@@ -233,6 +237,9 @@ status_t XzArchiver::Add(bool createMode, const char* relativePath, BMessage* me
 {
     if (m_tarArk == true)
     {
+        if (BEntry(m_tarFilePath).Exists() == false)
+            DecompressToTemp();
+
         m_archivePath = m_tarFilePath;
         status_t exitCode = TarArchiver::Add(createMode, relativePath, message, addedPaths, progress, cancel);
         m_archivePath = m_arkFilePath;
@@ -250,6 +257,9 @@ status_t XzArchiver::Delete(char*& outputStr, BMessage* message, BMessenger* pro
 {
     if (m_tarArk == true)
     {
+        if (BEntry(m_tarFilePath).Exists() == false)
+            DecompressToTemp();
+
         m_archivePath = m_tarFilePath;
         status_t exitCode = TarArchiver::Delete(outputStr, message, progress, cancel);
         m_archivePath = m_arkFilePath;
@@ -274,7 +284,18 @@ status_t XzArchiver::Create(BPath* archivePath, const char* relPath, BMessage* f
     strcpy(m_arkFilePath, m_archivePath.Path());
     InitTarFilePath((char*)archivePath->Leaf());
 
-    status_t result = Add(true, relPath, fileList, addedPaths, progress, cancel);
+    // tar is piped straight into the compressor, the tar in temp is only unpacked again if needed later
+    BEntry(m_tarFilePath).Remove();
+    int32 level = GetCompressionLevel();
+    if (m_settingsMenu->FindItem(B_TRANSLATE_NOCOLLECT(kAutoLevel))->IsMarked() == true)
+        level = ContentCompressionLevel(relPath, fileList, 0);
+
+    // Repeated files only compress to nothing when the window reaches back to the earlier copy
+    bool const wideWindow = m_settingsMenu->FindItem(B_TRANSLATE_NOCOLLECT(kDeduplicate))->IsMarked() == true
+                            && HasDuplicates(relPath, fileList, cancel) == true;
+
+    status_t result = CreateCompressed(CompressProgram(level, wideWindow).String(), relPath, fileList, addedPaths,
+                                       progress, cancel);
 
     // Once creating is done, set m_archiveRef to pointed to the existing archive file
     if (result == BZR_DONE)
@@ -322,6 +343,10 @@ void XzArchiver::BuildMenu(BMessage& message)
 
     // Add sub-menus to settings menu
     m_settingsMenu->AddItem(m_compressionMenu);
+    m_settingsMenu->AddItem(new KeyedMenuItem("bzr:AutoLevel", B_TRANSLATE_NOCOLLECT(kAutoLevel),
+                                              message, false, new BMessage(BZR_MENUITEM_SELECTED)));
+    m_settingsMenu->AddItem(new KeyedMenuItem("bzr:Deduplicate", B_TRANSLATE_NOCOLLECT(kDeduplicate),
+                                              message, true, new BMessage(BZR_MENUITEM_SELECTED)));
 }
 
 
@@ -365,14 +390,41 @@ BList XzArchiver::HiddenColumns(BList const& columns) const
 
 void XzArchiver::CompressFromTemp()
 {
-    // Get the compression ratio from the settings menu
-    BString levelStr;
-    levelStr.SetToFormat(" -%d ", GetCompressionLevel());
-
     // Re-compress file, from .tar in temp to xz
+    int32 level = GetCompressionLevel();
+    if (m_settingsMenu->FindItem(B_TRANSLATE_NOCOLLECT(kAutoLevel))->IsMarked() == true)
+        level = ContentCompressionLevel(m_tarFilePath, 0);
+
+    // The tar is not searched for duplicates, a 64 MiB dictionary needs too much memory on every core to
+    // be used blindly
     BString cmd;
-    cmd << "\"" << m_xzPath << "\"" << " -c " << levelStr << "\"" << m_tarFilePath << "\" > " << "\"" <<
-    m_archivePath.Path() << "\"";
+    cmd << CompressProgram(level, false) << " -c \"" << m_tarFilePath << "\" > \"" << m_archivePath.Path() << "\"";
+
+    m_pipeMgr.FlushArgs();
+    m_pipeMgr << "/bin/sh" << "-c" << cmd.String();
+    m_pipeMgr.Pipe();
+}
+
+
+BString XzArchiver::CompressProgram(int32 level, bool wideWindow)
+{
+    // xz spreads the work over all cores with -T0
+    BString program;
+    if (wideWindow == true)
+        program.SetToFormat("\"%s\" -T0 --lzma2=preset=%d,dict=64MiB", m_xzPath, level);
+    else
+        program.SetToFormat("\"%s\" -T0 -%d", m_xzPath, level);
+
+    return program;
+}
+
+
+void XzArchiver::DecompressToTemp()
+{
+    // We are redirecting (>) shell output to file, therefore we need to use /bin/sh -c <command>
+    BString cmd;
+    cmd << "\"" << m_xzPath << "\"" << " -c -d \"" << m_archivePath.Path() << "\" > " << "\"" <<
+    m_tarFilePath << "\"";
 
     m_pipeMgr.FlushArgs();
     m_pipeMgr << "/bin/sh" << "-c" << cmd.String();
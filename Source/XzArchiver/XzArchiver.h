@@ -40,6 +40,8 @@ class XzArchiver : public TarArchiver
         status_t           ReadDelete(FILE* fp, char*& outputStr,    BMessenger* progress, volatile bool* cancel);
 
         void               CompressFromTemp();
+        BString            CompressProgram(int32 level, bool wideWindow);
+        void               DecompressToTemp();
         BString            InitTarFilePath(char* fileName);
         void               SendProgressMessage(BMessenger* progress) const;
 
@@ -16,11 +16,13 @@
 #include <MenuItem.h>
 
 #include <cstdlib>
+#include <cstring>
 #include <fstream>
 
 #include "ZipArchiver.h"
 #include "ArchiveEntry.h"
 #include "AppUtils.h"
+#include "HashTable.h"
 #include "KeyedMenuItem.h"
 
 #ifdef HAIKU_ENABLE_I18N
@@ -38,6 +40,7 @@
 // keep track of our custom options/menuitems
 static const char
     *kAddAttrs         = B_TRANSLATE_MARK("Add attributes"),
+    *kAutoLevel        = B_TRANSLATE_MARK("Store files that are already compressed"),
     *kExtractAttrs     = B_TRANSLATE_MARK("Extract attributes"),
     *kExtractDirs      = B_TRANSLATE_MARK("Extract folders"),
     *kFreshenFiles     = B_TRANSLATE_MARK("Freshen existing files, create none"),
@@ -45,6 +48,326 @@ static const char
     *kRecurseDirs      = B_TRANSLATE_MARK("Recurse into folders"),
     *kUpdateFiles      = B_TRANSLATE_MARK("Update files, create if needed");
 
+// Testing is split across several unzip processes, each given a set of member name patterns.
+// unzip matches every member against every pattern, so their number is kept small
+static const int32 kMaxTestShards = 8;
+static const int32 kMinTestShardMembers = 256;
+static const int32 kTestGroupsPerShard = 8;
+static const int32 kMaxTestPatterns = 512;
+static const int32 kMaxTestPrefix = 255;
+
+
+// One unzip -t process, testing the members matched by the patterns in its arguments
+struct TestShard
+{
+    ZipArchiver*        archiver;
+    PipeMgr             pipeMgr;
+    BString             output;
+    status_t            exitCode;
+    BMessenger*         progress;
+    volatile bool*      cancel;
+};
+
+
+// A run of sorted member paths sharing a prefix
+struct TestGroup
+{
+    int32               first;
+    int32               count;
+    int32               length;
+};
+
+
+static int CompareTestPaths(const void* a, const void* b)
+{
+    return strcmp(*(const char* const*)a, *(const char* const*)b);
+}
+
+
+static int CompareTestGroups(const void* a, const void* b)
+{
+    return ((const TestGroup*)b)->count - ((const TestGroup*)a)->count;
+}
+
+
+static int32 TestPrefixLength(const char* path, int32 prefixLen)
+{
+    // Don't split a UTF-8 character, the path ends the prefix if it is shorter
+    int32 length = 0;
+    while (path[length] != '\0' && (length < prefixLen || (path[length] & 0xC0) == 0x80))
+        length++;
+
+    return length;
+}
+
+
+static int32 CountTestGroups(const char** paths, int32 count, int32 prefixLen, TestGroup* groups)
+{
+    // A path that is entirely its prefix is a group of its own, matched exactly
+    int32 groupCount = 0;
+    int32 lastLength = 0;
+    bool lastExact = true;
+    for (int32 i = 0; i < count; i++)
+    {
+        int32 const length = TestPrefixLength(paths[i], prefixLen);
+        bool const exact = paths[i][length] == '\0';
+        if (exact || lastExact || length != lastLength
+            || strncmp(paths[i], paths[i - 1], length) != 0)
+        {
+            if (groups != NULL)
+            {
+                groups[groupCount].first = i;
+                groups[groupCount].count = 0;
+                groups[groupCount].length = length;
+            }
+
+            groupCount++;
+        }
+
+        if (groups != NULL)
+            groups[groupCount - 1].count++;
+
+        lastLength = length;
+        lastExact = exact;
+    }
+
+    return groupCount;
+}
+
+
+static int32 BuildTestShards(BList* fileList, TestShard* shards, int32 maxShards)
+{
+    int32 const count = fileList->CountItems();
+    const char** paths = new const char*[count];
+    for (int32 i = 0; i < count; i++)
+        paths[i] = ((HashEntry*)fileList->ItemAtFast(i))->m_pathStr;
+
+    qsort(paths, count, sizeof(const char*), CompareTestPaths);
+
+    // Lengthen the prefix until there are enough groups to balance the shards
+    int32 prefixLen = 0;
+    int32 groupCount = 0;
+    for (int32 len = 1; len <= kMaxTestPrefix; len++)
+    {
+        int32 const groups = CountTestGroups(paths, count, len, NULL);
+        if (groups > kMaxTestPatterns)
+            break;
+
+        prefixLen = len;
+        groupCount = groups;
+        if (groups >= maxShards * kTestGroupsPerShard || groups == count)
+            break;
+    }
+
+    int32 shardCount = min_c(maxShards, groupCount);
+    if (shardCount < 2)
+    {
+        delete[] paths;
+        return 0;
+    }
+
+    TestGroup* groups = new TestGroup[groupCount];
+    CountTestGroups(paths, count, prefixLen, groups);
+    qsort(groups, groupCount, sizeof(TestGroup), CompareTestGroups);
+
+    // Largest groups first, each one to the least loaded shard
+    int32* loads = new int32[shardCount];
+    memset(loads, 0, shardCount * sizeof(int32));
+    for (int32 i = 0; i < groupCount; i++)
+    {
+        int32 shard = 0;
+        for (int32 j = 1; j < shardCount; j++)
+        {
+            if (loads[j] < loads[shard])
+                shard = j;
+        }
+
+        const char* path = paths[groups[i].first];
+        BString pattern = SupressWildcards(BString(path, groups[i].length).String());
+        pattern.ReplaceAll("?", "\\?");
+        if (path[groups[i].length] != '\0')
+            pattern << "?*";
+
+        shards[shard].pipeMgr << pattern;
+        loads[shard] += groups[i].count;
+    }
+
+    delete[] loads;
+    delete[] groups;
+    delete[] paths;
+    return shardCount;
+}
+
+
+// New archives with enough members are zipped as several partial archives at once, which
+// are then spliced together. Splicing rebases 32-bit offsets, so zip64 archives aren't built this way
+static const int32 kMaxCreateWorkers = 8;
+static const int32 kMinCreateShardItems = 512;
+static const int32 kMaxCreateShardItems = 60000;
+static const off_t kCreateItemWeight = 4096;
+static const off_t kMaxCreateBytes = 3LL * 1024 * 1024 * 1024;
+static const size_t kMaxCreateBatchBytes = 32 * 1024;
+static const size_t kMergeBufferSize = 1024 * 1024;
+static const char* kAttrWarning = "zip warning: couldn't write complete file type";
+static const int32 kSampledPerSuffix = 4;
+
+
+struct CreateItem
+{
+    char*               path;
+    off_t               size;
+};
+
+
+// A contiguous run of the items, zipped into a partial archive of its own
+struct CreateShard
+{
+    int32               first;
+    int32               count;
+    BString             partPath;
+    BMessage            addedPaths;
+    BString             errors;
+    status_t            exitCode;
+    off_t               base;
+    uint32              dirOffset;
+    uint32              dirSize;
+    uint16              entryCount;
+};
+
+
+struct CreateJob
+{
+    ZipArchiver*        archiver;
+    BList*              items;
+    BList*              shards;
+    int32               nextShard;
+    BString             levelStr;
+    BString             storeSuffixes;
+    bool                addAttrs;
+    BMessenger*         progress;
+    volatile bool*      cancel;
+};
+
+
+static inline uint16 ReadLE16(const uint8* data)
+{
+    return data[0] | (data[1] << 8);
+}
+
+
+static inline uint32 ReadLE32(const uint8* data)
+{
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32)data[3] << 24);
+}
+
+
+static inline void WriteLE16(uint8* data, uint16 value)
+{
+    data[0] = value & 0xFF;
+    data[1] = value >> 8;
+}
+
+
+static inline void WriteLE32(uint8* data, uint32 value)
+{
+    WriteLE16(data, value & 0xFFFF);
+    WriteLE16(data + 2, value >> 16);
+}
+
+
+static inline void WriteLE64(uint8* data, uint64 value)
+{
+    WriteLE32(data, value & 0xFFFFFFFF);
+    WriteLE32(data + 4, value >> 32);
+}
+
+
+static void CollectCreateItems(const char* path, bool recurse, BList& itemList, off_t& totalBytes)
+{
+    // List folders the way zip -r would recurse into them, links are stored and not followed
+    BEntry entry(path);
+    struct stat st;
+    if (entry.GetStat(&st) != B_OK)
+        return;
+
+    CreateItem* item = new CreateItem;
+    item->path = strdup(path);
+    item->size = S_ISREG(st.st_mode) ? st.st_size : 0;
+    itemList.AddItem(item);
+    totalBytes += item->size;
+
+    if (recurse == false || S_ISDIR(st.st_mode) == false)
+        return;
+
+    BDirectory dir(&entry);
+    BEntry child;
+    char name[B_FILE_NAME_LENGTH];
+    while (dir.GetNextEntry(&child) == B_OK)
+    {
+        if (child.GetName(name) != B_OK)
+            continue;
+
+        BString childPath(path);
+        if (childPath.ByteAt(childPath.Length() - 1) != '/')
+            childPath << '/';
+        childPath << name;
+
+        CollectCreateItems(childPath.String(), true, itemList, totalBytes);
+    }
+}
+
+
+static void FreeCreateItems(BList& itemList)
+{
+    for (int32 i = 0; i < itemList.CountItems(); i++)
+    {
+        CreateItem* item = (CreateItem*)itemList.ItemAtFast(i);
+        free(item->path);
+        delete item;
+    }
+
+    itemList.MakeEmpty();
+}
+
+
+static status_t ReadEndOfDirectory(BFile& file, CreateShard* shard)
+{
+    off_t fileSize;
+    if (file.GetSize(&fileSize) != B_OK || fileSize < 22)
+        return B_BAD_DATA;
+
+    size_t const tailSize = min_c(fileSize, 22 + 65535);
+    uint8* tail = new uint8[tailSize];
+    if (file.ReadAt(fileSize - tailSize, tail, tailSize) != (ssize_t)tailSize)
+    {
+        delete[] tail;
+        return B_IO_ERROR;
+    }
+
+    // Anything needing zip64 records (or spanning disks) can't be rebased
+    status_t result = B_BAD_DATA;
+    for (ssize_t i = tailSize - 22; i >= 0; i--)
+    {
+        const uint8* record = tail + i;
+        if (ReadLE32(record) != 0x06054b50)
+            continue;
+
+        shard->entryCount = ReadLE16(record + 10);
+        shard->dirSize = ReadLE32(record + 12);
+        shard->dirOffset = ReadLE32(record + 16);
+        if (ReadLE16(record + 4) != 0 || ReadLE16(record + 6) != 0 || shard->entryCount == 0xFFFF
+            || shard->dirOffset == 0xFFFFFFFF || (i >= 20 && ReadLE32(record - 20) == 0x07064b50)
+            || (off_t)shard->dirOffset + shard->dirSize > fileSize)
+            result = B_UNSUPPORTED;
+        else
+            result = B_OK;
+        break;
+    }
+
+    delete[] tail;
+    return result;
+}
+
 
 Archiver* load_archiver(BMessage* metaDataMsg)
 {
@@ -76,10 +399,7 @@ ZipArchiver::ZipArchiver(BMessage* metaDataMsg)
 
 status_t ZipArchiver::ReadOpen(FILE* fp)
 {
-    char lineString[B_PATH_NAME_LENGTH + 512],
-         sizeStr[25], methodStr[25], packedStr[25], ratioStr[15], dayStr[5],
-         monthStr[5], yearStr[8], hourStr[5], minuteStr[5], crcStr[25],
-         pathStr[B_PATH_NAME_LENGTH + 1];
+    char lineString[B_PATH_NAME_LENGTH + 512];
     uint16 const len = sizeof(lineString);
 
     do
@@ -87,31 +407,32 @@ status_t ZipArchiver::ReadOpen(FILE* fp)
         fgets(lineString, len, fp);
     } while (!feof(fp) && (strstr(lineString, "--------") == NULL));
 
-    fgets(lineString, len, fp);
+    return ReadOpenParallel(fp, "--------");
+}
 
-    while (!feof(fp) && (strstr(lineString, "--------") == NULL))
-    {
-        lineString[strlen(lineString) - 1] = '\0';
 
-        sscanf(lineString,
-               " %[0-9]  %[^ ] %[0-9]  %[^ ]  %[0-9]-%[0-9]-%[0-9] %[0-9]:%[0-9]  %[^ ]%[^\n]",
-               sizeStr, methodStr, packedStr, ratioStr, monthStr, dayStr, yearStr, hourStr, minuteStr, crcStr, pathStr);
+ArchiveEntry* ZipArchiver::ParseOpenLine(char* lineString)
+{
+    char sizeStr[25], methodStr[25], packedStr[25], ratioStr[15], dayStr[5],
+         monthStr[5], yearStr[8], hourStr[5], minuteStr[5], crcStr[25],
+         pathStr[B_PATH_NAME_LENGTH + 1];
 
-        const char *pathString = &pathStr[2];
+    if (sscanf(lineString,
+               " %[0-9]  %[^ ] %[0-9]  %[^ ]  %[0-9]-%[0-9]-%[0-9] %[0-9]:%[0-9]  %[^ ]%[^\n]",
+               sizeStr, methodStr, packedStr, ratioStr, monthStr, dayStr, yearStr, hourStr, minuteStr, crcStr,
+               pathStr) != 11)
+        return NULL;
 
-        struct tm timeStruct;
-        time_t timeValue;
-        MakeTime(&timeStruct, &timeValue, dayStr, monthStr, yearStr, hourStr, minuteStr, "00");
+    const char *pathString = &pathStr[2];
 
-        if (StrEndsWith(pathString, "/"))
-            m_entriesList.AddItem(new ArchiveEntry(true, pathString, sizeStr, packedStr, timeValue, methodStr, crcStr));
-        else
-            m_entriesList.AddItem(new ArchiveEntry(false, pathString, sizeStr, packedStr, timeValue, methodStr, crcStr));
- 
-        fgets(lineString, len, fp);
-    }
+    struct tm timeStruct;
+    time_t timeValue;
+    MakeTime(&timeStruct, &timeValue, dayStr, monthStr, yearStr, hourStr, minuteStr, "00");
 
-    return BZR_DONE;
+    if (StrEndsWith(pathString, "/"))
+        return new ArchiveEntry(true, pathString, sizeStr, packedStr, timeValue, methodStr, crcStr);
+    else
+        return new ArchiveEntry(false, pathString, sizeStr, packedStr, timeValue, methodStr, crcStr);
 }
 
 
@@ -302,25 +623,105 @@ status_t ZipArchiver::Test(char*& outputStr, BMessenger* progress, volatile bool
         return BZR_ARCHIVE_PATH_INIT_ERROR;
     }
 
-    m_pipeMgr.FlushArgs();
-    m_pipeMgr << m_unzipPath << "-t" << m_archivePath.Path();
+    // Members are tested independently of each other, large archives are split across processes
+    BList* fileList;
+    BList* folderList;
+    GetLists(fileList, folderList);
+
+    system_info sysInfo;
+    int32 maxShards = 1;
+    if (get_system_info(&sysInfo) == B_OK)
+        maxShards = min_c((int32)sysInfo.cpu_count, kMaxTestShards);
+    maxShards = max_c(1, min_c(maxShards, fileList->CountItems() / kMinTestShardMembers));
+
+    TestShard* shards = new TestShard[maxShards];
+    for (int32 i = 0; i < maxShards; i++)
+    {
+        shards[i].archiver = this;
+        shards[i].pipeMgr << m_unzipPath << "-t" << m_archivePath.Path();
+        shards[i].exitCode = B_ERROR;
+        shards[i].progress = progress;
+        shards[i].cancel = cancel;
+    }
+
+    int32 shardCount = maxShards > 1 ? BuildTestShards(fileList, shards, maxShards) : 0;
+    if (shardCount < 2)
+        shards[0].exitCode = RunTest(&shards[0]);
+    else
+    {
+        thread_id* threads = new thread_id[shardCount];
+        for (int32 i = 0; i < shardCount; i++)
+        {
+            threads[i] = spawn_thread(_testShard, "_test_shard", B_NORMAL_PRIORITY, (void*)&shards[i]);
+            if (threads[i] >= B_OK)
+                resume_thread(threads[i]);
+            else
+                shards[i].exitCode = RunTest(&shards[i]);
+        }
+
+        for (int32 i = 0; i < shardCount; i++)
+        {
+            status_t result;
+            if (threads[i] >= B_OK)
+                wait_for_thread(threads[i], &result);
+        }
+
+        delete[] threads;
+    }
+
+    // Merge the reports under a single "Archive:" header, a cancel overrides any error
+    BString fullOutputStr;
+    status_t exitCode = BZR_DONE;
+    for (int32 i = 0; i < max_c(shardCount, 1); i++)
+    {
+        BString& output = shards[i].output;
+        if (i > 0 && output.Compare("Archive:", 8) == 0)
+            output.Remove(0, output.FindFirst('\n') + 1);
+
+        fullOutputStr << output;
+        if (shards[i].exitCode == BZR_CANCEL_ARCHIVER)
+            exitCode = BZR_CANCEL_ARCHIVER;
+        else if (shards[i].exitCode != BZR_DONE && exitCode == BZR_DONE)
+            exitCode = shards[i].exitCode;
+    }
+
+    delete[] shards;
+
+    if (exitCode == B_ERROR)
+    {
+        outputStr = NULL;        // Handle unzip unloadable error here
+        return exitCode;
+    }
+
+    outputStr = new char[fullOutputStr.Length() + 1];
+    strcpy(outputStr, fullOutputStr.String());
+
+    return exitCode;
+}
+
+
+int32 ZipArchiver::_testShard(void* arg)
+{
+    TestShard* shard = reinterpret_cast<TestShard*>(arg);
+    shard->exitCode = shard->archiver->RunTest(shard);
+    return shard->exitCode;
+}
 
+
+status_t ZipArchiver::RunTest(TestShard* shard)
+{
     FILE* out;
     int outdes[2];
-    thread_id tid = m_pipeMgr.Pipe(outdes);
+    thread_id tid = shard->pipeMgr.Pipe(outdes);
 
     if (tid == B_ERROR || tid == B_NO_MEMORY)
-    {
-        outputStr = NULL;        // Handle unzip unloadable error here
         return B_ERROR;
-    }
 
     resume_thread(tid);
 
     close(outdes[1]);
     out = fdopen(outdes[0], "r");
-    status_t exitCode = ReadTest(out, outputStr, progress, cancel);
-    close(outdes[0]);
+    status_t exitCode = ReadTest(out, shard->output, shard->progress, shard->cancel);
     fclose(out);
 
     // Send signal to quit thread only AFTER pipes are closed
@@ -331,14 +732,13 @@ status_t ZipArchiver::Test(char*& outputStr, BMessenger* progress, volatile bool
 }
 
 
-status_t ZipArchiver::ReadTest(FILE* fp, char*& outputStr, BMessenger* progress, volatile bool* cancel)
+status_t ZipArchiver::ReadTest(FILE* fp, BString& outputStr, BMessenger* progress, volatile bool* cancel)
 {
     // Simply read the entire output of the test process and dump it to the error window (though it need not
     // be an error, it will simply report the output of unzip -t
     status_t exitCode = BZR_ERRSTREAM_FOUND;
     char lineString[999];
     int32 lineCount = -1;
-    BString fullOutputStr;
 
     BMessage updateMessage(BZR_UPDATE_PROGRESS), reply('DUMB');
     updateMessage.AddFloat("delta", 1.0f);
@@ -353,7 +753,7 @@ status_t ZipArchiver::ReadTest(FILE* fp, char*& outputStr, BMessenger* progress,
         }
 
         lineString[strlen(lineString) - 1] = '\0';
-        fullOutputStr << lineString << "\n";
+        outputStr << lineString << "\n";
         lineCount++;
 
         // Skip first line which contains Archive: <path of archive> | We don't need this here
@@ -410,9 +810,6 @@ status_t ZipArchiver::ReadTest(FILE* fp, char*& outputStr, BMessenger* progress,
         }
     }
 
-    outputStr = new char[fullOutputStr.Length() + 1];
-    strcpy(outputStr, fullOutputStr.String());
-
     return exitCode;
 }
 
@@ -529,6 +926,13 @@ bool ZipArchiver::SupportsFolderEntity() const
 }
 
 
+bool ZipArchiver::CanAddStagedLinks() const
+{
+    // zip follows links unless given -y
+    return true;
+}
+
+
 status_t ZipArchiver::Add(bool createMode, const char* relativePath, BMessage* message, BMessage* addedPaths,
                           BMessenger* progress, volatile bool* cancel)
 {
@@ -539,12 +943,38 @@ status_t ZipArchiver::Add(bool createMode, const char* relativePath, BMessage* m
         if (archiveEntry.Exists() == false)
             return BZR_ARCHIVE_PATH_INIT_ERROR;
     }
+    else
+    {
+        status_t exitCode = CreateParallel(relativePath, message, addedPaths, progress, cancel);
+        if (exitCode != B_UNSUPPORTED)
+            return exitCode;
+    }
+
+    if (relativePath)
+        chdir(relativePath);
+
+    bool const recurse = m_settingsMenu->FindItem(B_TRANSLATE_NOCOLLECT(kRecurseDirs))->IsMarked();
+    BString storeSuffixes;
+    if (m_settingsMenu->FindItem(B_TRANSLATE_NOCOLLECT(kAutoLevel))->IsMarked() == true)
+    {
+        BList itemList;
+        off_t totalBytes = 0;
+        const char* pathString;
+        for (int32 i = 0; message->FindString(kPath, i, &pathString) == B_OK; i++)
+            CollectCreateItems(pathString, recurse, itemList, totalBytes);
+
+        storeSuffixes = StoredSuffixes(itemList);
+        FreeCreateItems(itemList);
+    }
 
     BString levelStr;
     levelStr.SetToFormat("-%d", GetCompressionLevel());
 
-    m_pipeMgr << m_zipPath << "-y" << levelStr.String();
-    if (m_settingsMenu->FindItem(B_TRANSLATE_NOCOLLECT(kRecurseDirs))->IsMarked() == true)
+    // Staged links stand in for the files themselves, the staged tree has no links of its own
+    AddOptions(m_pipeMgr, levelStr.String(), storeSuffixes.String(),
+               m_settingsMenu->FindItem(B_TRANSLATE_NOCOLLECT(kAddAttrs))->IsMarked(),
+               message->FindBool(kStagedLinks) == false);
+    if (recurse == true)
         m_pipeMgr << "-r";
 
     m_pipeMgr << m_archivePath.Path();
@@ -566,9 +996,6 @@ status_t ZipArchiver::Add(bool createMode, const char* relativePath, BMessage* m
     FILE* out, *err;
     int outdes[2], errdes[2];
 
-    if (relativePath)
-        chdir(relativePath);
-
     thread_id tid = m_pipeMgr.Pipe(outdes, errdes);
 
     if (tid == B_ERROR || tid == B_NO_MEMORY)
@@ -584,7 +1011,7 @@ status_t ZipArchiver::Add(bool createMode, const char* relativePath, BMessage* m
     if (exitCode != BZR_CANCEL_ARCHIVER)
     {
         err = fdopen(errdes[0], "r");
-        exitCode = Archiver::ReadErrStream(err, "zip warning: couldn't write complete file type");
+        exitCode = Archiver::ReadErrStream(err, kAttrWarning);
         close(errdes[0]);
         fclose(err);
     }
@@ -600,6 +1027,393 @@ status_t ZipArchiver::Add(bool createMode, const char* relativePath, BMessage* m
 }
 
 
+void ZipArchiver::AddOptions(PipeMgr& pipeMgr, const char* levelStr, const char* storeSuffixes,
+                             bool addAttrs, bool storeLinks) const
+{
+    pipeMgr << m_zipPath << levelStr;
+    if (storeLinks == true)
+        pipeMgr << "-y";
+
+    if (storeSuffixes[0] != '\0')
+        pipeMgr << "-n" << storeSuffixes;
+
+    if (addAttrs == false)
+        pipeMgr << "-X";
+}
+
+
+BString ZipArchiver::StoredSuffixes(BList& itemList) const
+{
+    // A few files of each extension are sampled, zip stores the extensions that turn out to be
+    // compressed already (media, archives) rather than deflating them again
+    BMessage samples;
+    for (int32 i = 0; i < itemList.CountItems(); i++)
+    {
+        CreateItem* item = (CreateItem*)itemList.ItemAtFast(i);
+        const char* leaf = strrchr(item->path, '/');
+        leaf = leaf != NULL ? leaf + 1 : item->path;
+
+        const char* suffix = strrchr(leaf, '.');
+        if (item->size == 0 || suffix == NULL || suffix == leaf || suffix[1] == '\0'
+            || strpbrk(suffix, ":;") != NULL)
+            continue;
+
+        type_code type;
+        int32 count = 0;
+        if (samples.GetInfo(suffix, &type, &count) == B_OK && count >= kSampledPerSuffix)
+            continue;
+
+        BFile file(item->path, B_READ_ONLY);
+        float const entropy = file.InitCheck() == B_OK ? SampleEntropy(&file, 0) : -1.0f;
+        if (entropy >= 0)
+            samples.AddFloat(suffix, entropy);
+    }
+
+    BString suffixes;
+    char* suffix;
+    type_code type;
+    int32 count;
+    for (int32 i = 0; samples.GetInfo(B_FLOAT_TYPE, i, &suffix, &type, &count) == B_OK; i++)
+    {
+        float total = 0.0f;
+        for (int32 j = 0; j < count; j++)
+            total += samples.GetFloat(suffix, j, 0.0f);
+
+        if (total / count >= kCompressedEntropy)
+        {
+            if (suffixes.Length() > 0)
+                suffixes << ':';
+            suffixes << suffix;
+        }
+    }
+
+    return suffixes;
+}
+
+
+status_t ZipArchiver::CreateParallel(const char* relativePath, BMessage* message, BMessage* addedPaths,
+                                     BMessenger* progress, volatile bool* cancel)
+{
+    system_info sysInfo;
+    if (get_system_info(&sysInfo) != B_OK || sysInfo.cpu_count < 2)
+        return B_UNSUPPORTED;
+
+    // zip adds to an existing archive, only new ones are spliced together from partial archives
+    if (BEntry(m_archivePath.Path()).Exists() == true)
+        return B_UNSUPPORTED;
+
+    if (relativePath)
+        chdir(relativePath);
+
+    bool const recurse = m_settingsMenu->FindItem(B_TRANSLATE_NOCOLLECT(kRecurseDirs))->IsMarked();
+    BList itemList;
+    off_t totalBytes = 0;
+    const char* pathString;
+    for (int32 i = 0; message->FindString(kPath, i, &pathString) == B_OK; i++)
+        CollectCreateItems(pathString, recurse, itemList, totalBytes);
+
+    int32 const itemCount = itemList.CountItems();
+    int32 const workerCount = min_c(min_c((int32)sysInfo.cpu_count, kMaxCreateWorkers),
+                                    itemCount / kMinCreateShardItems);
+
+    status_t exitCode = B_UNSUPPORTED;
+    BList shardList;
+    if (workerCount >= 2 && totalBytes <= kMaxCreateBytes)
+    {
+        // Contiguous runs of about the same weight keep the members in listing order
+        int32 const shardsWanted = max_c(workerCount, itemCount / kMaxCreateShardItems + 1);
+        off_t const shardWeight = (totalBytes + itemCount * kCreateItemWeight) / shardsWanted + 1;
+        CreateShard* shard = NULL;
+        off_t weight = 0;
+        for (int32 i = 0; i < itemCount; i++)
+        {
+            if (shard == NULL || weight >= shardWeight || shard->count == kMaxCreateShardItems)
+            {
+                shard = new CreateShard;
+                shard->first = i;
+                shard->count = 0;
+                shard->partPath.SetToFormat("%s.%" B_PRId32 ".part", m_archivePath.Path(),
+                                            shardList.CountItems());
+                shard->exitCode = B_ERROR;
+                BEntry(shard->partPath.String()).Remove();
+                shardList.AddItem(shard);
+                weight = 0;
+            }
+
+            shard->count++;
+            weight += ((CreateItem*)itemList.ItemAtFast(i))->size + kCreateItemWeight;
+        }
+
+        CreateJob job;
+        job.archiver = this;
+        job.items = &itemList;
+        job.shards = &shardList;
+        job.nextShard = 0;
+        job.levelStr.SetToFormat("-%d", GetCompressionLevel());
+        if (m_settingsMenu->FindItem(B_TRANSLATE_NOCOLLECT(kAutoLevel))->IsMarked() == true)
+            job.storeSuffixes = StoredSuffixes(itemList);
+        job.addAttrs = m_settingsMenu->FindItem(B_TRANSLATE_NOCOLLECT(kAddAttrs))->IsMarked();
+        job.progress = progress;
+        job.cancel = cancel;
+
+        thread_id* workers = new thread_id[workerCount];
+        int32 started = 0;
+        for (int32 i = 0; i < workerCount; i++)
+        {
+            thread_id tid = spawn_thread(_createWorker, "_create_worker", B_NORMAL_PRIORITY, (void*)&job);
+            if (tid < B_OK)
+                break;
+
+            workers[started++] = tid;
+            resume_thread(tid);
+        }
+
+        if (started == 0)
+            _createWorker(&job);
+
+        for (int32 i = 0; i < started; i++)
+        {
+            status_t result;
+            wait_for_thread(workers[i], &result);
+        }
+
+        delete[] workers;
+
+        // A cancel overrides any error, zip's warnings are reported once all of it is merged
+        BString errors;
+        exitCode = BZR_DONE;
+        for (int32 i = 0; i < shardList.CountItems(); i++)
+        {
+            shard = (CreateShard*)shardList.ItemAtFast(i);
+            if (shard->exitCode == BZR_CANCEL_ARCHIVER)
+                exitCode = BZR_CANCEL_ARCHIVER;
+            else if (shard->exitCode != BZR_DONE && exitCode == BZR_DONE)
+                exitCode = shard->exitCode;
+
+            errors << shard->errors;
+        }
+
+        if (exitCode == BZR_DONE)
+        {
+            exitCode = MergeShards(shardList);
+            if (exitCode == B_OK)
+            {
+                for (int32 i = 0; i < shardList.CountItems(); i++)
+                {
+                    shard = (CreateShard*)shardList.ItemAtFast(i);
+                    for (int32 j = 0; shard->addedPaths.FindString(kPath, j, &pathString) == B_OK; j++)
+                        addedPaths->AddString(kPath, pathString);
+                }
+
+                exitCode = ReadErrString(errors, kAttrWarning);
+            }
+            else if (exitCode != B_UNSUPPORTED)
+                exitCode = B_ERROR;
+        }
+    }
+
+    for (int32 i = 0; i < shardList.CountItems(); i++)
+    {
+        CreateShard* shard = (CreateShard*)shardList.ItemAtFast(i);
+        BEntry(shard->partPath.String()).Remove();
+        delete shard;
+    }
+
+    FreeCreateItems(itemList);
+    return exitCode;
+}
+
+
+int32 ZipArchiver::_createWorker(void* arg)
+{
+    CreateJob* job = reinterpret_cast<CreateJob*>(arg);
+    int32 index;
+    while ((index = atomic_add(&job->nextShard, 1)) < job->shards->CountItems())
+    {
+        CreateShard* shard = (CreateShard*)job->shards->ItemAtFast(index);
+        shard->exitCode = job->archiver->CreateShardArchive(job, shard);
+    }
+
+    return B_OK;
+}
+
+
+status_t ZipArchiver::CreateShardArchive(CreateJob* job, CreateShard* shard)
+{
+    // Items are passed in batches small enough for the argument list, each batch after the
+    // first grows the partial archive in place
+    int32 const end = shard->first + shard->count;
+    int32 i = shard->first;
+    while (i < end)
+    {
+        if (job->cancel && *job->cancel == true)
+            return BZR_CANCEL_ARCHIVER;
+
+        PipeMgr pipeMgr;
+        AddOptions(pipeMgr, job->levelStr.String(), job->storeSuffixes.String(), job->addAttrs, true);
+        if (i > shard->first)
+            pipeMgr << "-g";
+
+        pipeMgr << shard->partPath;
+        size_t batchBytes = 0;
+        for (; i < end && batchBytes < kMaxCreateBatchBytes; i++)
+        {
+            const char* path = ((CreateItem*)job->items->ItemAtFast(i))->path;
+            pipeMgr << path;
+            batchBytes += strlen(path) + 1;
+        }
+
+        FILE* out, *err;
+        int outdes[2], errdes[2];
+        thread_id tid = pipeMgr.Pipe(outdes, errdes);
+        if (tid == B_ERROR || tid == B_NO_MEMORY)
+            return B_ERROR;
+
+        resume_thread(tid);
+        close(errdes[1]);
+        close(outdes[1]);
+
+        out = fdopen(outdes[0], "r");
+        status_t exitCode = ReadAdd(out, &shard->addedPaths, job->progress, job->cancel);
+        if (exitCode != BZR_CANCEL_ARCHIVER)
+        {
+            err = fdopen(errdes[0], "r");
+            ReadStream(err, shard->errors);
+            fclose(err);
+        }
+        else
+            close(errdes[0]);
+        fclose(out);
+
+        // Send signal to quit zip only AFTER pipes are closed
+        if (exitCode == BZR_CANCEL_ARCHIVER)
+        {
+            TerminateThread(tid);
+            return exitCode;
+        }
+
+        // The next batch must find the archive complete
+        status_t result;
+        wait_for_thread(tid, &result);
+    }
+
+    return BZR_DONE;
+}
+
+
+status_t ZipArchiver::MergeShards(BList& shardList) const
+{
+    // Local headers and data are copied as they are, the central directories after them with their
+    // local header offsets moved by where each partial archive now starts
+    int32 const shardCount = shardList.CountItems();
+    off_t dirStart = 0;
+    uint64 dirSize = 0;
+    uint64 entryCount = 0;
+    for (int32 i = 0; i < shardCount; i++)
+    {
+        CreateShard* shard = (CreateShard*)shardList.ItemAtFast(i);
+        BFile part(shard->partPath.String(), B_READ_ONLY);
+        if (part.InitCheck() != B_OK || ReadEndOfDirectory(part, shard) != B_OK)
+            return B_UNSUPPORTED;
+
+        shard->base = dirStart;
+        dirStart += shard->dirOffset;
+        dirSize += shard->dirSize;
+        entryCount += shard->entryCount;
+    }
+
+    if (dirStart + dirSize >= 0xFFFFFFFF)
+        return B_UNSUPPORTED;
+
+    BFile archive(m_archivePath.Path(), B_WRITE_ONLY | B_CREATE_FILE | B_ERASE_FILE);
+    status_t result = archive.InitCheck();
+    uint8* buffer = new uint8[kMergeBufferSize];
+    for (int32 i = 0; i < shardCount && result == B_OK; i++)
+    {
+        CreateShard* shard = (CreateShard*)shardList.ItemAtFast(i);
+        BFile part(shard->partPath.String(), B_READ_ONLY);
+        for (off_t pos = 0; pos < shard->dirOffset && result == B_OK; pos += kMergeBufferSize)
+        {
+            size_t const size = (size_t)min_c((off_t)kMergeBufferSize, shard->dirOffset - pos);
+            if (part.ReadAt(pos, buffer, size) != (ssize_t)size
+                || archive.Write(buffer, size) != (ssize_t)size)
+                result = B_IO_ERROR;
+        }
+    }
+
+    for (int32 i = 0; i < shardCount && result == B_OK; i++)
+    {
+        CreateShard* shard = (CreateShard*)shardList.ItemAtFast(i);
+        BFile part(shard->partPath.String(), B_READ_ONLY);
+        uint8* dir = new uint8[shard->dirSize];
+        if (part.ReadAt(shard->dirOffset, dir, shard->dirSize) != (ssize_t)shard->dirSize)
+            result = B_IO_ERROR;
+
+        for (uint32 pos = 0; result == B_OK && pos < shard->dirSize; )
+        {
+            uint8* header = dir + pos;
+            if (pos + 46 > shard->dirSize || ReadLE32(header) != 0x02014b50)
+            {
+                result = B_BAD_DATA;
+                break;
+            }
+
+            WriteLE32(header + 42, ReadLE32(header + 42) + shard->base);
+            pos += 46 + ReadLE16(header + 28) + ReadLE16(header + 30) + ReadLE16(header + 32);
+        }
+
+        if (result == B_OK && archive.Write(dir, shard->dirSize) != (ssize_t)shard->dirSize)
+            result = B_IO_ERROR;
+
+        delete[] dir;
+    }
+
+    delete[] buffer;
+
+    if (result == B_OK)
+    {
+        // More than 65534 entries only fit in the zip64 end records, the offsets themselves don't need them
+        uint8 record[56 + 20 + 22];
+        memset(record, 0, sizeof(record));
+        uint8* end = record;
+        if (entryCount >= 0xFFFF)
+        {
+            WriteLE32(record, 0x06064b50);
+            WriteLE64(record + 4, 44);
+            WriteLE16(record + 12, 45);
+            WriteLE16(record + 14, 45);
+            WriteLE64(record + 24, entryCount);
+            WriteLE64(record + 32, entryCount);
+            WriteLE64(record + 40, dirSize);
+            WriteLE64(record + 48, dirStart);
+
+            WriteLE32(record + 56, 0x07064b50);
+            WriteLE64(record + 64, dirStart + dirSize);
+            WriteLE32(record + 72, 1);
+            end = record + 76;
+        }
+
+        WriteLE32(end, 0x06054b50);
+        WriteLE16(end + 8, min_c(entryCount, 0xFFFF));
+        WriteLE16(end + 10, min_c(entryCount, 0xFFFF));
+        WriteLE32(end + 12, dirSize);
+        WriteLE32(end + 16, dirStart);
+
+        size_t const recordSize = end + 22 - record;
+        if (archive.Write(record, recordSize) != (ssize_t)recordSize)
+            result = B_IO_ERROR;
+    }
+
+    if (result != B_OK)
+    {
+        archive.Unset();
+        BEntry(m_archivePath.Path()).Remove();
+    }
+
+    return result;
+}
+
+
 status_t ZipArchiver::ReadAdd(FILE* fp, BMessage* addedPaths, BMessenger* progress, volatile bool* cancel)
 {
     // Read output while adding files to archive
@@ -812,6 +1626,9 @@ void ZipArchiver::BuildMenu(BMessage& message)
     addMenu->AddItem(new KeyedMenuItem("bzr:RecurseDirs", B_TRANSLATE_NOCOLLECT(kRecurseDirs),
                                        message, true, new BMessage(BZR_MENUITEM_SELECTED)));
 
+    addMenu->AddItem(new KeyedMenuItem("bzr:AutoLevel", B_TRANSLATE_NOCOLLECT(kAutoLevel),
+                                       message, false, new BMessage(BZR_MENUITEM_SELECTED)));
+
     // Build the extract sub-menu
     extractMenu = new BMenu(B_TRANSLATE("While extracting"));
     extractMenu->SetRadioMode(false);
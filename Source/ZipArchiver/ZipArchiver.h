@@ -8,6 +8,9 @@
 #include "Archiver.h"
 
 class BMessenger;
+struct TestShard;
+struct CreateJob;
+struct CreateShard;
 
 class ZipArchiver : public Archiver
 {
@@ -31,13 +34,25 @@ class ZipArchiver : public Archiver
         status_t           SetComment(char* commentStr, const char* tempDirPath);
         bool               SupportsComment() const;
         bool               SupportsFolderEntity() const;
+        bool               CanAddStagedLinks() const;
 
     private:
         status_t           ReadOpen(FILE* fp);
+        ArchiveEntry*      ParseOpenLine(char* lineString);
         status_t           ReadExtract(FILE* fp, BMessenger* progress, volatile bool* cancel);
-        status_t           ReadTest(FILE* fp, char*& outputStr, BMessenger* progress, volatile bool* cancel);
+        status_t           RunTest(TestShard* shard);
+        status_t           ReadTest(FILE* fp, BString& outputStr, BMessenger* progress, volatile bool* cancel);
         status_t           ReadAdd(FILE* fp, BMessage* addedPaths, BMessenger* progress, volatile bool* cancel);
+        void               AddOptions(PipeMgr& pipeMgr, const char* levelStr, const char* storeSuffixes,
+                                      bool addAttrs, bool storeLinks) const;
+        BString            StoredSuffixes(BList& itemList) const;
+        status_t           CreateParallel(const char* relativePath, BMessage* message, BMessage* addedPaths,
+                                          BMessenger* progress, volatile bool* cancel);
+        status_t           CreateShardArchive(CreateJob* job, CreateShard* shard);
+        status_t           MergeShards(BList& shardList) const;
         status_t           ReadDelete(FILE* fp, char*& outputStr,    BMessenger* progress, volatile bool* cancel);
+        static int32       _testShard(void* arg);
+        static int32       _createWorker(void* arg);
 
         char               m_unzipPath[B_PATH_NAME_LENGTH];
         char               m_zipPath[B_PATH_NAME_LENGTH];
@@ -5,6 +5,7 @@
 #include "ZstdArchiver.h"
 #include "ArchiveEntry.h"
 #include "AppUtils.h"
+#include "KeyedMenuItem.h"
 
 #include <Messenger.h>
 #include <MenuItem.h>
@@ -18,9 +19,16 @@
 #define B_TRANSLATION_CONTEXT "ZstdArchiver"
 #else
 #define B_TRANSLATE(x) x
+#define B_TRANSLATE_MARK(x) x
+#define B_TRANSLATE_NOCOLLECT(x) x
 #endif
 
 
+static const char
+    *kAutoLevel        = B_TRANSLATE_MARK("Use fastest level for already compressed data"),
+    *kDeduplicate      = B_TRANSLATE_MARK("Compress duplicate files only once");
+
+
 Archiver* load_archiver(BMessage* metaDataMsg)
 {
     return new ZstdArchiver(metaDataMsg);
@@ -82,14 +90,8 @@ status_t ZstdArchiver::Open(entry_ref* ref, BMessage* fileList)
     m_archiveRef = *ref;
     m_archivePath.SetTo(ref);
 
-    // We are redirecting (>) shell output to file, therefore we need to use /bin/sh -c <command>
     BString destPath = InitTarFilePath(ref->name);
-    BString cmd;
-    cmd << "\"" << m_zstdPath << "\"" << " -c -d \"" << m_archivePath.Path() << "\" > " << "\"" << m_tarFilePath << "\"";
-
-    m_pipeMgr.FlushArgs();
-    m_pipeMgr << "/bin/sh" << "-c" << cmd.String();
-    m_pipeMgr.Pipe();
+    DecompressToTemp();
 
     if (TarArchiver::IsTarArchive(destPath.String()))
     {
@@ -150,6 +152,9 @@ status_t ZstdArchiver::Extract(entry_ref* refToDir, BMessage* message, BMessenge
 {
     if (m_tarArk == true)
     {
+        if (BEntry(m_tarFilePath).Exists() == false)
+            DecompressToTemp();
+
         m_archivePath = m_tarFilePath;
         status_t const exitCode = TarArchiver::Extract(refToDir, message, progress, cancel);
         m_archivePath = m_arkFilePath;
@@ -233,6 +238,9 @@ status_t ZstdArchiver::Add(bool createMode, const char* relativePath, BMessage*
 {
     if (m_tarArk == true)
     {
+        if (BEntry(m_tarFilePath).Exists() == false)
+            DecompressToTemp();
+
         m_archivePath = m_tarFilePath;
         status_t exitCode = TarArchiver::Add(createMode, relativePath, message, addedPaths, progress, cancel);
         m_archivePath = m_arkFilePath;
@@ -250,6 +258,9 @@ status_t ZstdArchiver::Delete(char*& outputStr, BMessage* message, BMessenger* p
 {
     if (m_tarArk == true)
     {
+        if (BEntry(m_tarFilePath).Exists() == false)
+            DecompressToTemp();
+
         m_archivePath = m_tarFilePath;
         status_t exitCode = TarArchiver::Delete(outputStr, message, progress, cancel);
         m_archivePath = m_arkFilePath;
@@ -274,7 +285,18 @@ status_t ZstdArchiver::Create(BPath* archivePath, const char* relPath, BMessage*
     strcpy(m_arkFilePath, m_archivePath.Path());
     InitTarFilePath((char*)archivePath->Leaf());
 
-    status_t result = Add(true, relPath, fileList, addedPaths, progress, cancel);
+    // tar is piped straight into the compressor, the tar in temp is only unpacked again if needed later
+    BEntry(m_tarFilePath).Remove();
+    int32 level = GetCompressionLevel();
+    if (m_settingsMenu->FindItem(B_TRANSLATE_NOCOLLECT(kAutoLevel))->IsMarked() == true)
+        level = ContentCompressionLevel(relPath, fileList, 1);
+
+    // Repeated files only compress to nothing when the window reaches back to the earlier copy. The
+    // files are not searched for duplicates first, a wide window costs zstd little when there are none
+    bool const wideWindow = m_settingsMenu->FindItem(B_TRANSLATE_NOCOLLECT(kDeduplicate))->IsMarked();
+
+    status_t result = CreateCompressed(CompressProgram(level, wideWindow).String(), relPath, fileList, addedPaths,
+                                       progress, cancel);
 
     // Once creating is done, set m_archiveRef to pointed to the existing archive file
     if (result == BZR_DONE)
@@ -325,6 +347,10 @@ void ZstdArchiver::BuildMenu(BMessage& message)
 
     // Add sub-menus to settings menu
     m_settingsMenu->AddItem(m_compressionMenu);
+    m_settingsMenu->AddItem(new KeyedMenuItem("bzr:AutoLevel", B_TRANSLATE_NOCOLLECT(kAutoLevel),
+                                              message, false, new BMessage(BZR_MENUITEM_SELECTED)));
+    m_settingsMenu->AddItem(new KeyedMenuItem("bzr:Deduplicate", B_TRANSLATE_NOCOLLECT(kDeduplicate),
+                                              message, true, new BMessage(BZR_MENUITEM_SELECTED)));
 }
 
 
@@ -366,13 +392,41 @@ BList ZstdArchiver::HiddenColumns(BList const& columns) const
 
 void ZstdArchiver::CompressFromTemp()
 {
-    // Get the compression ratio from the settings menu
-    BString levelStr;
-    levelStr.SetToFormat(" -%d ", GetCompressionLevel());
-
     // Re-compress file, from .tar in temp to zstd
+    int32 level = GetCompressionLevel();
+    if (m_settingsMenu->FindItem(B_TRANSLATE_NOCOLLECT(kAutoLevel))->IsMarked() == true)
+        level = ContentCompressionLevel(m_tarFilePath, 1);
+
+    bool const wideWindow = m_settingsMenu->FindItem(B_TRANSLATE_NOCOLLECT(kDeduplicate))->IsMarked();
+
     BString cmd;
-    cmd << "\"" << m_zstdPath << "\"" << " -c --ultra" << levelStr << "\"" << m_tarFilePath << "\" -o " << "\"" << m_archivePath.Path() << "\"";
+    cmd << CompressProgram(level, wideWindow) << " -c \"" << m_tarFilePath << "\" > \"" << m_archivePath.Path() << "\"";
+
+    m_pipeMgr.FlushArgs();
+    m_pipeMgr << "/bin/sh" << "-c" << cmd.String();
+    m_pipeMgr.Pipe();
+}
+
+
+BString ZstdArchiver::CompressProgram(int32 level, bool wideWindow)
+{
+    // zstd spreads the work over all cores with -T0
+    BString program;
+    program.SetToFormat("\"%s\" -q -T0 --ultra -%d", m_zstdPath, level);
+
+    // A 128 MiB window is the largest zstd still decompresses without being told to
+    if (wideWindow == true)
+        program << " --long=27";
+
+    return program;
+}
+
+
+void ZstdArchiver::DecompressToTemp()
+{
+    // We are redirecting (>) shell output to file, therefore we need to use /bin/sh -c <command>
+    BString cmd;
+    cmd << "\"" << m_zstdPath << "\"" << " -c -d \"" << m_archivePath.Path() << "\" > " << "\"" << m_tarFilePath << "\"";
 
     m_pipeMgr.FlushArgs();
     m_pipeMgr << "/bin/sh" << "-c" << cmd.String();
@@ -7,7 +7,9 @@
 #include "z7Archiver.h"
 #include "ArchiveEntry.h"
 #include "AppUtils.h"
+#include "HashTable.h"
 #include "KeyedMenuItem.h"
+#include "z7HeaderReader.h"
 
 #include <NodeInfo.h>
 #include <Messenger.h>
@@ -28,6 +30,7 @@
 // keep track of our custom options/menuitems
 static const char
     //*kArchiveAttrs     = B_TRANSLATE_MARK("Add attributes"), // unused?
+    *kAutoLevel        = B_TRANSLATE_MARK("Use fastest level for already compressed data"),
     *kMultiThread      = B_TRANSLATE_MARK("Use multi-threading (for multi-core CPUs)"),
     *kNoOverwrite      = B_TRANSLATE_MARK("Never overwrite existing files"),
     *kOverwriteFiles   = B_TRANSLATE_MARK("Always overwrite (default)"),
@@ -43,7 +46,9 @@ Archiver* load_archiver(BMessage* metaDataMsg)
 
 
 z7Archiver::z7Archiver(BMessage* metaDataMsg)
-    : Archiver(metaDataMsg)
+    : Archiver(metaDataMsg),
+      m_hasSolidBlocks(false),
+      m_nativeListing(false)
 {
     // Detect 7z binary
     if (GetBinaryPath(m_7zPath, "7za") == true)
@@ -109,11 +114,55 @@ status_t z7Archiver::ReadOpen(FILE* fp)
 }
 
 
-status_t z7Archiver::Open(entry_ref* ref, BMessage* /*fileList*/)
+status_t z7Archiver::Open(entry_ref* ref, BMessage* fileList)
 {
     m_archiveRef = *ref;
     m_archivePath.SetTo(ref);
 
+    // The header has all a listing needs, so read it ourselves; 7z is only needed when the
+    // header is encrypted or uses a coder we don't decode
+    z7HeaderReader headerReader(m_archivePath.Path());
+    BList entries;
+    m_nativeListing = headerReader.ReadEntries(&entries, &m_passwordRequired) == B_OK;
+    if (m_nativeListing == true)
+    {
+        m_hasSolidBlocks = headerReader.HasSolidBlocks();
+        if (fileList == NULL)
+        {
+            m_entriesList.AddList(&entries);
+            return BZR_DONE;
+        }
+
+        // Keep only what was just added; 7z reports folders without the trailing slash
+        uint32 type;
+        int32 count = 0;
+        fileList->GetInfo(kPath, &type, &count);
+        HashTable addedTable(HashTable::OptimalSize(count));
+        for (int32 i = 0; i < count; i++)
+        {
+            const char* path;
+            if (fileList->FindString(kPath, i, &path) == B_OK)
+                addedTable.Add(path);
+        }
+
+        for (int32 i = 0; i < entries.CountItems(); i++)
+        {
+            ArchiveEntry* entry = (ArchiveEntry*)entries.ItemAtFast(i);
+            BString path(entry->m_pathStr);
+            if (entry->m_isDir)
+                path.RemoveLast("/");
+
+            if (addedTable.Find(path.String()) != NULL)
+                m_entriesList.AddItem(entry);
+            else
+                delete entry;
+        }
+
+        return BZR_DONE;
+    }
+
+    // "7z l" pads the names it lists, so what was just added can't be picked out reliably; the
+    // whole archive is listed again instead (see CanPartiallyOpen())
     m_pipeMgr.FlushArgs();
     m_pipeMgr << m_7zPath << "l" << m_archivePath.Path();
 
@@ -439,10 +488,8 @@ bool z7Archiver::CanReplaceFiles() const
 
 bool z7Archiver::CanPartiallyOpen() const
 {
-    // TODO: when p7zip gets fixed output for progress info, and we can be sure about file names (right now it
-    //    adds space chars after file name, which makes handling file names with space chars at the end impossible),
-    //    make this return true, so there will be no need to list archive each time
-    return false;
+    // Only the header reader gives exact names to filter the added entries by
+    return m_nativeListing;
 }
 
 
@@ -452,6 +499,19 @@ bool z7Archiver::SupportsPassword() const
 }
 
 
+bool z7Archiver::HasSolidBlocks() const
+{
+    return m_hasSolidBlocks;
+}
+
+
+bool z7Archiver::CanAddStagedLinks() const
+{
+    // p7zip stores links as links unless given -l
+    return true;
+}
+
+
 status_t z7Archiver::Add(bool createMode, const char* relativePath, BMessage* message, BMessage* addedPaths,
                          BMessenger* progress, volatile bool* cancel)
 {
@@ -465,8 +525,13 @@ status_t z7Archiver::Add(bool createMode, const char* relativePath, BMessage* me
 
     m_pipeMgr.FlushArgs();
 
+    // 7z has one method per archive (or solid block), so the files are sampled as a whole
+    int32 level = GetCompressionLevel();
+    if (m_settingsMenu->FindItem(B_TRANSLATE_NOCOLLECT(kAutoLevel))->IsMarked() == true)
+        level = ContentCompressionLevel(relativePath, message, 1);
+
     BString levelStr;
-    levelStr.SetToFormat("-mx%d", GetCompressionLevel());
+    levelStr.SetToFormat("-mx%d", level);
     m_pipeMgr << m_7zPath << "a" << levelStr.String();
 
     if (m_settingsMenu->FindItem(B_TRANSLATE_NOCOLLECT(kMultiThread))->IsMarked() == true)
@@ -486,8 +551,13 @@ status_t z7Archiver::Add(bool createMode, const char* relativePath, BMessage* me
     if (m_settingsMenu->FindItem(B_TRANSLATE_NOCOLLECT(kSolidBlocks))->IsMarked() == false)
         m_pipeMgr << "-ms=off";
 
+    // Files staged in temp as links are added as the files they point to
+    if (message->FindBool(kStagedLinks) == true)
+        m_pipeMgr << "-l";
+
     // 0.07: Added "-bd" switch to prevent percentage display in output
-    m_pipeMgr << "-bd" << m_archivePath.Path();
+    // "-bb1" makes p7zip 9.38+ report each added file (as "+ name", without any padding)
+    m_pipeMgr << "-bd" << "-bb1" << m_archivePath.Path();
 
     int32 count = 0L;
     uint32 type;
@@ -555,9 +625,15 @@ status_t z7Archiver::ReadAdd(FILE* fp, BMessage* addedPaths, BMessenger* progres
         }
 
         lineString[strlen(lineString) - 1] = '\0';
-        if (strncmp(lineString, "Compressing  ", 13) == 0)
+        int32 nameOffset = 0;
+        if (strncmp(lineString, "+ ", 2) == 0)
+            nameOffset = 2;
+        else if (strncmp(lineString, "Compressing  ", 13) == 0)
+            nameOffset = 13;
+
+        if (nameOffset > 0)
         {
-            BString filePath = lineString + 13;
+            BString filePath = lineString + nameOffset;
             const char* fileName = FinalPathComponent(filePath.String());
 
             // Don't update progress bar for folders
@@ -830,6 +906,9 @@ void z7Archiver::BuildMenu(BMessage& message)
     addMenu->AddItem(new KeyedMenuItem("bzr:MultiThread", B_TRANSLATE_NOCOLLECT(kMultiThread),
                                        message, true, new BMessage(BZR_MENUITEM_SELECTED)));
 
+    addMenu->AddItem(new KeyedMenuItem("bzr:AutoLevel", B_TRANSLATE_NOCOLLECT(kAutoLevel),
+                                       message, false, new BMessage(BZR_MENUITEM_SELECTED)));
+
     // Build the "While extracting" sub-menu
     extractMenu = new BMenu(B_TRANSLATE("While extracting"));
     extractMenu->SetRadioMode(true);
@@ -32,6 +32,8 @@ class z7Archiver : public Archiver
         bool               CanReplaceFiles() const;
         bool               CanPartiallyOpen() const;
         bool               SupportsPassword() const;
+        bool               HasSolidBlocks() const;
+        bool               CanAddStagedLinks() const;
 
     private:
         status_t           ReadOpen(FILE* fp);
@@ -43,6 +45,8 @@ class z7Archiver : public Archiver
         void               SetMimeType();
 
         char               m_7zPath[B_PATH_NAME_LENGTH];
+        bool               m_hasSolidBlocks;
+        bool               m_nativeListing;
 };
 
 #endif /* _7Z_ARCHIVER_H */
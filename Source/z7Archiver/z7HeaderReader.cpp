@@ -0,0 +1,1088 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2002 Ramshankar (aka Teknomancer).
+// All rights reserved.
+
+#include "z7HeaderReader.h"
+#include "ArchiveEntry.h"
+
+#include <File.h>
+#include <UnicodeChar.h>
+
+#include <lzma.h>
+
+#include <cstdlib>
+#include <cstring>
+
+static const uint8 k7zSignature[] = { '7', 'z', 0xbc, 0xaf, 0x27, 0x1c };
+static const uint64 kMax7zHeaderSize = 256 * 1024 * 1024;
+
+// Property ids of the 7z header
+enum
+{
+    k7zEnd = 0x00,
+    k7zHeader = 0x01,
+    k7zArchiveProperties = 0x02,
+    k7zAdditionalStreamsInfo = 0x03,
+    k7zMainStreamsInfo = 0x04,
+    k7zFilesInfo = 0x05,
+    k7zPackInfo = 0x06,
+    k7zUnpackInfo = 0x07,
+    k7zSubStreamsInfo = 0x08,
+    k7zSize = 0x09,
+    k7zCRC = 0x0a,
+    k7zFolder = 0x0b,
+    k7zCodersUnpackSize = 0x0c,
+    k7zNumUnpackStream = 0x0d,
+    k7zEmptyStream = 0x0e,
+    k7zEmptyFile = 0x0f,
+    k7zName = 0x11,
+    k7zMTime = 0x14,
+    k7zWinAttributes = 0x15,
+    k7zEncodedHeader = 0x17
+};
+
+
+static inline uint32 ReadLE32(const uint8* data)
+{
+    return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32)data[3] << 24);
+}
+
+
+static inline uint64 ReadLE64(const uint8* data)
+{
+    return ReadLE32(data) | ((uint64)ReadLE32(data + 4) << 32);
+}
+
+
+static bool CoderIs(z7Coder const& coder, const uint8* id, int32 idSize)
+{
+    return coder.idSize == idSize && memcmp(coder.id, id, idSize) == 0;
+}
+
+
+static const uint8 kCopyId[] = { 0x00 };
+static const uint8 kLzmaId[] = { 0x03, 0x01, 0x01 };
+static const uint8 kLzma2Id[] = { 0x21 };
+static const uint8 kAesId[] = { 0x06, 0xf1, 0x07, 0x01 };
+
+
+z7StreamsInfo::z7StreamsInfo()
+    : packPos(0),
+      packStreamCount(0),
+      packSizes(NULL),
+      folderCount(0),
+      folders(NULL),
+      subStreamCount(0),
+      subStreamSizes(NULL),
+      subStreamCrcDefined(NULL),
+      subStreamCrcs(NULL)
+{
+}
+
+
+z7StreamsInfo::~z7StreamsInfo()
+{
+    delete[] packSizes;
+    delete[] folders;
+    delete[] subStreamSizes;
+    delete[] subStreamCrcDefined;
+    delete[] subStreamCrcs;
+}
+
+
+z7HeaderReader::z7HeaderReader(const char* archivePath)
+    : m_archivePath(archivePath),
+      m_data(NULL),
+      m_size(0),
+      m_pos(0),
+      m_passwordRequired(false),
+      m_hasSolidBlocks(false)
+{
+}
+
+
+z7HeaderReader::~z7HeaderReader()
+{
+    free(m_data);
+}
+
+
+status_t z7HeaderReader::ReadEntries(BList* entriesList, bool* passwordRequired)
+{
+    BFile file(m_archivePath.String(), B_READ_ONLY);
+    if (file.InitCheck() != B_OK)
+        return file.InitCheck();
+
+    // The signature header points to the real header, which sits at the end of the archive
+    uint8 signature[32];
+    if (file.ReadAt(0, signature, sizeof(signature)) != (ssize_t)sizeof(signature)
+        || memcmp(signature, k7zSignature, sizeof(k7zSignature)) != 0)
+        return B_NOT_SUPPORTED;
+
+    uint64 const headerOffset = ReadLE64(signature + 12);
+    uint64 const headerSize = ReadLE64(signature + 20);
+    if (headerSize == 0)
+        return B_OK;
+
+    if (headerSize > kMax7zHeaderSize)
+        return B_NOT_SUPPORTED;
+
+    m_data = (uint8*)malloc(headerSize);
+    if (m_data == NULL)
+        return B_NO_MEMORY;
+
+    m_size = headerSize;
+    m_pos = 0;
+    if (file.ReadAt(sizeof(signature) + headerOffset, m_data, m_size) != (ssize_t)m_size
+        || lzma_crc32(m_data, m_size, 0) != ReadLE32(signature + 28))
+        return B_BAD_DATA;
+
+    BList entries;
+    status_t result = B_BAD_DATA;
+    for (;;)
+    {
+        uint64 type;
+        if (ReadNumber(type) == false)
+            break;
+
+        if (type == k7zEncodedHeader)
+        {
+            result = DecodeHeader(&file);
+            if (result != B_OK)
+                break;
+        }
+        else
+        {
+            if (type == k7zHeader)
+                result = ReadHeader(&entries);
+            break;
+        }
+    }
+
+    if (m_passwordRequired)
+        *passwordRequired = true;
+
+    if (result != B_OK)
+    {
+        for (int32 i = 0; i < entries.CountItems(); i++)
+            delete (ArchiveEntry*)entries.ItemAtFast(i);
+        return result;
+    }
+
+    entriesList->AddList(&entries);
+    return B_OK;
+}
+
+
+bool z7HeaderReader::HasSolidBlocks() const
+{
+    return m_hasSolidBlocks;
+}
+
+
+status_t z7HeaderReader::ReadHeader(BList* entriesList)
+{
+    uint64 type;
+    if (ReadNumber(type) == false)
+        return B_BAD_DATA;
+
+    if (type == k7zArchiveProperties)
+    {
+        for (;;)
+        {
+            uint64 propType, propSize;
+            if (ReadNumber(propType) == false)
+                return B_BAD_DATA;
+            if (propType == k7zEnd)
+                break;
+            if (ReadNumber(propSize) == false || SkipData(propSize) == false)
+                return B_BAD_DATA;
+        }
+
+        if (ReadNumber(type) == false)
+            return B_BAD_DATA;
+    }
+
+    if (type == k7zAdditionalStreamsInfo)
+    {
+        z7StreamsInfo additionalInfo;
+        status_t result = ReadStreamsInfo(additionalInfo);
+        if (result != B_OK)
+            return result;
+
+        if (ReadNumber(type) == false)
+            return B_BAD_DATA;
+    }
+
+    z7StreamsInfo info;
+    if (type == k7zMainStreamsInfo)
+    {
+        status_t result = ReadStreamsInfo(info);
+        if (result != B_OK)
+            return result;
+
+        if (ReadNumber(type) == false)
+            return B_BAD_DATA;
+    }
+
+    if (type == k7zFilesInfo)
+    {
+        status_t result = ReadFilesInfo(info, entriesList);
+        if (result != B_OK)
+            return result;
+
+        if (ReadNumber(type) == false)
+            return B_BAD_DATA;
+    }
+
+    return type == k7zEnd ? B_OK : B_BAD_DATA;
+}
+
+
+status_t z7HeaderReader::DecodeHeader(BFile* file)
+{
+    // The real header was packed like any other stream, 7-Zip uses a single LZMA coder for it
+    z7StreamsInfo info;
+    status_t result = ReadStreamsInfo(info);
+    if (result != B_OK)
+        return result;
+
+    if (info.folderCount != 1 || info.packStreamCount < 1 || info.folders[0].coderCount != 1
+        || info.folders[0].packedStreamCount != 1)
+        return B_NOT_SUPPORTED;
+
+    z7Folder const& folder = info.folders[0];
+    z7Coder const& coder = folder.coders[0];
+    if (CoderIs(coder, kAesId, sizeof(kAesId)))
+    {
+        m_passwordRequired = true;
+        return B_NOT_SUPPORTED;
+    }
+
+    lzma_filter filters[2];
+    filters[0].options = NULL;
+    filters[1].id = LZMA_VLI_UNKNOWN;
+    if (CoderIs(coder, kLzmaId, sizeof(kLzmaId)))
+        filters[0].id = LZMA_FILTER_LZMA1;
+    else if (CoderIs(coder, kLzma2Id, sizeof(kLzma2Id)))
+        filters[0].id = LZMA_FILTER_LZMA2;
+    else if (CoderIs(coder, kCopyId, sizeof(kCopyId)) == false)
+        return B_NOT_SUPPORTED;
+
+    uint64 const packSize = info.packSizes[0];
+    uint64 const unpackSize = FolderUnpackSize(folder);
+    if (packSize > kMax7zHeaderSize || unpackSize > kMax7zHeaderSize || unpackSize == 0)
+        return B_NOT_SUPPORTED;
+
+    uint8* packed = (uint8*)malloc(packSize);
+    uint8* unpacked = (uint8*)malloc(unpackSize);
+    if (packed == NULL || unpacked == NULL)
+    {
+        free(packed);
+        free(unpacked);
+        return B_NO_MEMORY;
+    }
+
+    result = B_BAD_DATA;
+    if (file->ReadAt(32 + info.packPos, packed, packSize) == (ssize_t)packSize)
+    {
+        if (CoderIs(coder, kCopyId, sizeof(kCopyId)))
+        {
+            if (packSize >= unpackSize)
+            {
+                memcpy(unpacked, packed, unpackSize);
+                result = B_OK;
+            }
+        }
+        else if (lzma_properties_decode(&filters[0], NULL, coder.props, coder.propsSize) == LZMA_OK)
+        {
+            // Raw LZMA streams need not have an end marker, we stop once we have all the bytes
+            lzma_stream stream = LZMA_STREAM_INIT;
+            if (lzma_raw_decoder(&stream, filters) == LZMA_OK)
+            {
+                stream.next_in = packed;
+                stream.avail_in = packSize;
+                stream.next_out = unpacked;
+                stream.avail_out = unpackSize;
+
+                lzma_ret ret = LZMA_OK;
+                while (ret == LZMA_OK && stream.avail_out > 0)
+                {
+                    size_t const availIn = stream.avail_in, availOut = stream.avail_out;
+                    ret = lzma_code(&stream, LZMA_RUN);
+                    if (stream.avail_in == availIn && stream.avail_out == availOut)
+                        break;
+                }
+
+                if (stream.avail_out == 0)
+                    result = B_OK;
+                lzma_end(&stream);
+            }
+            free(filters[0].options);
+        }
+    }
+
+    free(packed);
+    if (result == B_OK && folder.crcDefined && lzma_crc32(unpacked, unpackSize, 0) != folder.crc)
+        result = B_BAD_DATA;
+
+    if (result != B_OK)
+    {
+        free(unpacked);
+        return result;
+    }
+
+    free(m_data);
+    m_data = unpacked;
+    m_size = unpackSize;
+    m_pos = 0;
+    return B_OK;
+}
+
+
+status_t z7HeaderReader::ReadStreamsInfo(z7StreamsInfo& info)
+{
+    uint64 type;
+    if (ReadNumber(type) == false)
+        return B_BAD_DATA;
+
+    status_t result = B_OK;
+    if (type == k7zPackInfo)
+    {
+        if ((result = ReadPackInfo(info)) != B_OK || ReadNumber(type) == false)
+            return result != B_OK ? result : B_BAD_DATA;
+    }
+
+    if (type == k7zUnpackInfo)
+    {
+        if ((result = ReadUnpackInfo(info)) != B_OK || ReadNumber(type) == false)
+            return result != B_OK ? result : B_BAD_DATA;
+    }
+
+    if (type == k7zSubStreamsInfo)
+    {
+        if ((result = ReadSubStreamsInfo(info)) != B_OK || ReadNumber(type) == false)
+            return result != B_OK ? result : B_BAD_DATA;
+    }
+    else if (info.folderCount > 0)
+    {
+        // Without sub-streams every folder holds exactly one file
+        info.subStreamCount = info.folderCount;
+        info.subStreamSizes = new uint64[info.folderCount];
+        info.subStreamCrcDefined = new bool[info.folderCount];
+        info.subStreamCrcs = new uint32[info.folderCount];
+        for (uint64 i = 0; i < info.folderCount; i++)
+        {
+            info.subStreamSizes[i] = FolderUnpackSize(info.folders[i]);
+            info.subStreamCrcDefined[i] = info.folders[i].crcDefined;
+            info.subStreamCrcs[i] = info.folders[i].crc;
+        }
+    }
+
+    return type == k7zEnd ? B_OK : B_BAD_DATA;
+}
+
+
+status_t z7HeaderReader::ReadPackInfo(z7StreamsInfo& info)
+{
+    if (ReadNumber(info.packPos) == false || ReadNumber(info.packStreamCount) == false
+        || info.packStreamCount > m_size)
+        return B_BAD_DATA;
+
+    info.packSizes = new uint64[info.packStreamCount];
+    memset(info.packSizes, 0, info.packStreamCount * sizeof(uint64));
+
+    for (;;)
+    {
+        uint64 type;
+        if (ReadNumber(type) == false)
+            return B_BAD_DATA;
+
+        if (type == k7zEnd)
+            return B_OK;
+
+        if (type == k7zSize)
+        {
+            for (uint64 i = 0; i < info.packStreamCount; i++)
+                if (ReadNumber(info.packSizes[i]) == false)
+                    return B_BAD_DATA;
+        }
+        else if (type == k7zCRC)
+        {
+            bool* defined = new bool[info.packStreamCount];
+            uint32* crcs = new uint32[info.packStreamCount];
+            bool const digestsRead = ReadDigests(info.packStreamCount, defined, crcs);
+            delete[] defined;
+            delete[] crcs;
+            if (digestsRead == false)
+                return B_BAD_DATA;
+        }
+        else
+            return B_BAD_DATA;
+    }
+}
+
+
+status_t z7HeaderReader::ReadUnpackInfo(z7StreamsInfo& info)
+{
+    uint64 type;
+    uint8 external;
+    if (ReadNumber(type) == false || type != k7zFolder || ReadNumber(info.folderCount) == false
+        || info.folderCount > m_size || ReadByte(external) == false)
+        return B_BAD_DATA;
+
+    if (external != 0)
+        return B_NOT_SUPPORTED;
+
+    info.folders = new z7Folder[info.folderCount];
+    memset(info.folders, 0, info.folderCount * sizeof(z7Folder));
+    for (uint64 i = 0; i < info.folderCount; i++)
+    {
+        status_t result = ReadFolder(info.folders[i]);
+        if (result != B_OK)
+            return result;
+    }
+
+    if (ReadNumber(type) == false || type != k7zCodersUnpackSize)
+        return B_BAD_DATA;
+
+    for (uint64 i = 0; i < info.folderCount; i++)
+        for (int32 j = 0; j < info.folders[i].outStreamCount; j++)
+            if (ReadNumber(info.folders[i].unpackSizes[j]) == false)
+                return B_BAD_DATA;
+
+    if (ReadNumber(type) == false)
+        return B_BAD_DATA;
+
+    if (type == k7zCRC)
+    {
+        bool* defined = new bool[info.folderCount];
+        uint32* crcs = new uint32[info.folderCount];
+        bool const digestsRead = ReadDigests(info.folderCount, defined, crcs);
+        for (uint64 i = 0; digestsRead && i < info.folderCount; i++)
+        {
+            info.folders[i].crcDefined = defined[i];
+            info.folders[i].crc = crcs[i];
+        }
+
+        delete[] defined;
+        delete[] crcs;
+        if (digestsRead == false || ReadNumber(type) == false)
+            return B_BAD_DATA;
+    }
+
+    return type == k7zEnd ? B_OK : B_BAD_DATA;
+}
+
+
+status_t z7HeaderReader::ReadFolder(z7Folder& folder)
+{
+    uint64 coderCount;
+    if (ReadNumber(coderCount) == false || coderCount == 0)
+        return B_BAD_DATA;
+
+    if (coderCount > (uint64)kMax7zCoders)
+        return B_NOT_SUPPORTED;
+
+    uint64 inStreams = 0, outStreams = 0;
+    folder.coderCount = coderCount;
+    for (int32 i = 0; i < folder.coderCount; i++)
+    {
+        z7Coder& coder = folder.coders[i];
+        uint8 flags;
+        if (ReadByte(flags) == false)
+            return B_BAD_DATA;
+
+        // Alternative methods were never used by any version of 7-Zip
+        if (flags & 0x80)
+            return B_NOT_SUPPORTED;
+
+        coder.idSize = flags & 0x0f;
+        if (m_pos + coder.idSize > m_size)
+            return B_BAD_DATA;
+        memcpy(coder.id, m_data + m_pos, coder.idSize);
+        m_pos += coder.idSize;
+
+        coder.inStreams = coder.outStreams = 1;
+        if ((flags & 0x10) && (ReadNumber(coder.inStreams) == false || ReadNumber(coder.outStreams) == false))
+            return B_BAD_DATA;
+
+        if (flags & 0x20)
+        {
+            if (ReadNumber(coder.propsSize) == false || coder.propsSize > m_size - m_pos)
+                return B_BAD_DATA;
+            coder.props = m_data + m_pos;
+            m_pos += coder.propsSize;
+        }
+
+        // Each count is checked before it is summed, so a huge one can't wrap the sums back into range
+        if (coder.inStreams > (uint64)kMax7zStreams || coder.outStreams > (uint64)kMax7zStreams)
+            return B_BAD_DATA;
+
+        inStreams += coder.inStreams;
+        outStreams += coder.outStreams;
+        if (inStreams > (uint64)kMax7zStreams || outStreams > (uint64)kMax7zStreams)
+            return B_NOT_SUPPORTED;
+    }
+
+    if (outStreams < 1 || inStreams < outStreams)
+        return B_BAD_DATA;
+
+    folder.outStreamCount = outStreams;
+    folder.bindPairCount = outStreams - 1;
+    for (int32 i = 0; i < folder.bindPairCount; i++)
+        if (ReadNumber(folder.bindPairs[i][0]) == false || ReadNumber(folder.bindPairs[i][1]) == false)
+            return B_BAD_DATA;
+
+    if (inStreams < (uint64)folder.bindPairCount + 1)
+        return B_BAD_DATA;
+
+    folder.packedStreamCount = inStreams - folder.bindPairCount;
+    if (folder.packedStreamCount > kMax7zStreams)
+        return B_BAD_DATA;
+
+    if (folder.packedStreamCount == 1)
+    {
+        // The one in-stream not fed by another coder is the packed stream
+        for (uint64 i = 0; i < inStreams; i++)
+        {
+            bool isBound = false;
+            for (int32 j = 0; j < folder.bindPairCount && isBound == false; j++)
+                isBound = folder.bindPairs[j][0] == i;
+
+            if (isBound == false)
+            {
+                folder.packedStreams[0] = i;
+                break;
+            }
+        }
+    }
+    else
+    {
+        for (int32 i = 0; i < folder.packedStreamCount; i++)
+            if (ReadNumber(folder.packedStreams[i]) == false)
+                return B_BAD_DATA;
+    }
+
+    folder.unpackStreamCount = 1;
+    return B_OK;
+}
+
+
+status_t z7HeaderReader::ReadSubStreamsInfo(z7StreamsInfo& info)
+{
+    uint64 type;
+    if (ReadNumber(type) == false)
+        return B_BAD_DATA;
+
+    if (type == k7zNumUnpackStream)
+    {
+        for (uint64 i = 0; i < info.folderCount; i++)
+            if (ReadNumber(info.folders[i].unpackStreamCount) == false || info.folders[i].unpackStreamCount > m_size)
+                return B_BAD_DATA;
+
+        if (ReadNumber(type) == false)
+            return B_BAD_DATA;
+    }
+
+    for (uint64 i = 0; i < info.folderCount; i++)
+    {
+        info.subStreamCount += info.folders[i].unpackStreamCount;
+        if (info.subStreamCount > m_size)
+            return B_BAD_DATA;
+    }
+
+    info.subStreamSizes = new uint64[info.subStreamCount];
+    info.subStreamCrcDefined = new bool[info.subStreamCount];
+    info.subStreamCrcs = new uint32[info.subStreamCount];
+    memset(info.subStreamCrcDefined, 0, info.subStreamCount * sizeof(bool));
+
+    // Sizes of all but the last file of each folder are stored, the last one gets what remains
+    uint64 index = 0, digestCount = 0;
+    for (uint64 i = 0; i < info.folderCount; i++)
+    {
+        z7Folder const& folder = info.folders[i];
+        if (folder.unpackStreamCount == 0)
+            continue;
+
+        if (folder.unpackStreamCount > 1)
+            m_hasSolidBlocks = true;
+
+        uint64 sum = 0;
+        for (uint64 j = 1; j < folder.unpackStreamCount; j++)
+        {
+            uint64 size;
+            if (type != k7zSize || ReadNumber(size) == false)
+                return B_BAD_DATA;
+            info.subStreamSizes[index++] = size;
+            sum += size;
+        }
+
+        uint64 const folderSize = FolderUnpackSize(folder);
+        if (sum > folderSize)
+            return B_BAD_DATA;
+        info.subStreamSizes[index++] = folderSize - sum;
+
+        if (folder.unpackStreamCount != 1 || folder.crcDefined == false)
+            digestCount += folder.unpackStreamCount;
+    }
+
+    if (type == k7zSize && ReadNumber(type) == false)
+        return B_BAD_DATA;
+
+    // A folder with just one file already has its CRC, the rest are listed here
+    bool digestsRead = false;
+    while (type != k7zEnd)
+    {
+        if (type == k7zCRC)
+        {
+            bool* defined = new bool[digestCount];
+            uint32* crcs = new uint32[digestCount];
+            digestsRead = ReadDigests(digestCount, defined, crcs);
+
+            index = 0;
+            uint64 digestIndex = 0;
+            for (uint64 i = 0; digestsRead && i < info.folderCount; i++)
+            {
+                z7Folder const& folder = info.folders[i];
+                if (folder.unpackStreamCount == 1 && folder.crcDefined)
+                {
+                    info.subStreamCrcDefined[index] = true;
+                    info.subStreamCrcs[index++] = folder.crc;
+                    continue;
+                }
+
+                for (uint64 j = 0; j < folder.unpackStreamCount; j++, index++, digestIndex++)
+                {
+                    info.subStreamCrcDefined[index] = defined[digestIndex];
+                    info.subStreamCrcs[index] = crcs[digestIndex];
+                }
+            }
+
+            delete[] defined;
+            delete[] crcs;
+            if (digestsRead == false)
+                return B_BAD_DATA;
+        }
+        else
+        {
+            uint64 size;
+            if (ReadNumber(size) == false || SkipData(size) == false)
+                return B_BAD_DATA;
+        }
+
+        if (ReadNumber(type) == false)
+            return B_BAD_DATA;
+    }
+
+    if (digestsRead == false)
+    {
+        index = 0;
+        for (uint64 i = 0; i < info.folderCount; i++)
+        {
+            z7Folder const& folder = info.folders[i];
+            if (folder.unpackStreamCount == 1 && folder.crcDefined)
+            {
+                info.subStreamCrcDefined[index] = true;
+                info.subStreamCrcs[index] = folder.crc;
+            }
+            index += folder.unpackStreamCount;
+        }
+    }
+
+    return B_OK;
+}
+
+
+status_t z7HeaderReader::ReadFilesInfo(z7StreamsInfo& info, BList* entriesList)
+{
+    uint64 fileCount;
+    if (ReadNumber(fileCount) == false || fileCount > m_size)
+        return B_BAD_DATA;
+
+    bool* emptyStream = new bool[fileCount];
+    bool* emptyFile = new bool[fileCount];
+    bool* timeDefined = new bool[fileCount];
+    bool* attrDefined = new bool[fileCount];
+    uint64* times = new uint64[fileCount];
+    uint32* attrs = new uint32[fileCount];
+    memset(emptyStream, 0, fileCount * sizeof(bool));
+    memset(emptyFile, 0, fileCount * sizeof(bool));
+    memset(timeDefined, 0, fileCount * sizeof(bool));
+    memset(attrDefined, 0, fileCount * sizeof(bool));
+
+    const uint8* names = NULL;
+    size_t namesSize = 0;
+    uint64 emptyCount = 0;
+    status_t result = B_OK;
+    while (result == B_OK)
+    {
+        uint64 type, size;
+        if (ReadNumber(type) == false)
+        {
+            result = B_BAD_DATA;
+            break;
+        }
+
+        if (type == k7zEnd)
+            break;
+
+        if (ReadNumber(size) == false || size > m_size - m_pos)
+        {
+            result = B_BAD_DATA;
+            break;
+        }
+
+        size_t const propertyEnd = m_pos + size;
+        uint8 external = 0;
+        bool ok = true;
+        switch (type)
+        {
+            case k7zEmptyStream:
+            {
+                ok = ReadBitVector(fileCount, emptyStream);
+                for (uint64 i = 0; i < fileCount; i++)
+                    if (emptyStream[i])
+                        emptyCount++;
+                break;
+            }
+
+            case k7zEmptyFile:
+                ok = ReadBitVector(emptyCount, emptyFile);
+                break;
+
+            case k7zName:
+            {
+                ok = ReadByte(external) && external == 0;
+                names = m_data + m_pos;
+                namesSize = propertyEnd - m_pos;
+                break;
+            }
+
+            case k7zMTime:
+            {
+                ok = ReadDefinedVector(fileCount, timeDefined) && ReadByte(external) && external == 0;
+                for (uint64 i = 0; ok && i < fileCount; i++)
+                    if (timeDefined[i])
+                        ok = ReadUInt64(times[i]);
+                break;
+            }
+
+            case k7zWinAttributes:
+            {
+                ok = ReadDefinedVector(fileCount, attrDefined) && ReadByte(external) && external == 0;
+                for (uint64 i = 0; ok && i < fileCount; i++)
+                    if (attrDefined[i])
+                        ok = ReadUInt32(attrs[i]);
+                break;
+            }
+        }
+
+        if (ok == false || m_pos > propertyEnd)
+            result = external != 0 ? B_NOT_SUPPORTED : B_BAD_DATA;
+        m_pos = propertyEnd;
+    }
+
+    if (result == B_OK && fileCount > 0 && names == NULL)
+        result = B_BAD_DATA;
+
+    // Packed sizes are per folder, and shown against the first file of each like 7z does
+    uint64* folderPacked = new uint64[info.folderCount];
+    uint64 packIndex = 0;
+    for (uint64 i = 0; i < info.folderCount; i++)
+    {
+        folderPacked[i] = 0;
+        for (int32 j = 0; j < info.folders[i].packedStreamCount && packIndex < info.packStreamCount; j++)
+            folderPacked[i] += info.packSizes[packIndex++];
+    }
+
+    size_t namePos = 0;
+    uint64 folderIndex = 0, streamInFolder = 0, streamIndex = 0, emptyIndex = 0;
+    for (uint64 i = 0; result == B_OK && i < fileCount; i++)
+    {
+        BString path;
+        for (;;)
+        {
+            if (namePos + 2 > namesSize)
+            {
+                result = B_BAD_DATA;
+                break;
+            }
+
+            uint32 c = names[namePos] | (names[namePos + 1] << 8);
+            namePos += 2;
+            if (c == 0)
+                break;
+
+            if (c >= 0xd800 && c < 0xdc00 && namePos + 2 <= namesSize)
+            {
+                uint32 const low = names[namePos] | (names[namePos + 1] << 8);
+                if (low >= 0xdc00 && low < 0xe000)
+                {
+                    c = 0x10000 + ((c - 0xd800) << 10) + (low - 0xdc00);
+                    namePos += 2;
+                }
+            }
+
+            char utf8[5];
+            char* utf8End = utf8;
+            BUnicodeChar::ToUTF8(c, &utf8End);
+            path.Append(utf8, utf8End - utf8);
+        }
+
+        if (result != B_OK)
+            break;
+
+        // Archives from Windows don't carry Unix modes and may use backslashes
+        uint32 const attr = attrDefined[i] ? attrs[i] : 0;
+        if ((attr & 0x8000) == 0)
+            path.ReplaceAll('\\', '/');
+
+        bool const hasStream = emptyStream[i] == false;
+        bool isDir = hasStream == false && emptyFile[emptyIndex] == false;
+        if (hasStream == false)
+            emptyIndex++;
+        if (attr & 0x10)
+            isDir = true;
+
+        BString sizeStr("0"), packedStr("0"), crcStr, methodStr;
+        if (hasStream)
+        {
+            while (folderIndex < info.folderCount && streamInFolder >= info.folders[folderIndex].unpackStreamCount)
+            {
+                folderIndex++;
+                streamInFolder = 0;
+            }
+
+            if (folderIndex >= info.folderCount || streamIndex >= info.subStreamCount)
+            {
+                result = B_BAD_DATA;
+                break;
+            }
+
+            z7Folder const& folder = info.folders[folderIndex];
+            sizeStr = "";
+            sizeStr << info.subStreamSizes[streamIndex];
+            if (streamInFolder == 0)
+            {
+                packedStr = "";
+                packedStr << folderPacked[folderIndex];
+            }
+
+            if (info.subStreamCrcDefined[streamIndex])
+                crcStr.SetToFormat("%08" B_PRIX32, info.subStreamCrcs[streamIndex]);
+
+            methodStr = FolderMethod(folder);
+            if (folder.unpackStreamCount > 1)
+                methodStr << " (block " << folderIndex << ")";
+
+            for (int32 j = 0; j < folder.coderCount; j++)
+                if (CoderIs(folder.coders[j], kAesId, sizeof(kAesId)))
+                    m_passwordRequired = true;
+
+            streamIndex++;
+            streamInFolder++;
+        }
+
+        if (isDir)
+            path << '/';
+
+        // FILETIME counts 100ns intervals since 1601
+        time_t timeValue = 0;
+        if (timeDefined[i] && times[i] >= 116444736000000000ULL)
+            timeValue = (times[i] - 116444736000000000ULL) / 10000000;
+
+        entriesList->AddItem(new ArchiveEntry(isDir, path.String(), sizeStr.String(), packedStr.String(), timeValue,
+                                              methodStr.String(), crcStr.String()));
+    }
+
+    delete[] folderPacked;
+    delete[] emptyStream;
+    delete[] emptyFile;
+    delete[] timeDefined;
+    delete[] attrDefined;
+    delete[] times;
+    delete[] attrs;
+    return result;
+}
+
+
+BString z7HeaderReader::FolderMethod(z7Folder const& folder) const
+{
+    static const struct
+    {
+        uint8       id[4];
+        int32       idSize;
+        const char* name;
+    } kMethods[] =
+    {
+        { { 0x00 }, 1, "Copy" },
+        { { 0x21 }, 1, "LZMA2" },
+        { { 0x03, 0x01, 0x01 }, 3, "LZMA" },
+        { { 0x03, 0x03, 0x01, 0x03 }, 4, "BCJ" },
+        { { 0x03, 0x03, 0x01, 0x1b }, 4, "BCJ2" },
+        { { 0x03, 0x04, 0x01 }, 3, "PPMD" },
+        { { 0x04, 0x01, 0x08 }, 3, "Deflate" },
+        { { 0x04, 0x01, 0x09 }, 3, "Deflate64" },
+        { { 0x04, 0x02, 0x02 }, 3, "BZip2" },
+        { { 0x03 }, 1, "Delta" },
+        { { 0x06, 0xf1, 0x07, 0x01 }, 4, "7zAES" }
+    };
+
+    BString method;
+    for (int32 i = 0; i < folder.coderCount; i++)
+    {
+        if (method.Length() > 0)
+            method << ' ';
+
+        bool found = false;
+        for (int32 j = 0; j < (int32)B_COUNT_OF(kMethods) && found == false; j++)
+        {
+            if (CoderIs(folder.coders[i], kMethods[j].id, kMethods[j].idSize))
+            {
+                method << kMethods[j].name;
+                found = true;
+            }
+        }
+
+        if (found == false)
+        {
+            for (int32 k = 0; k < folder.coders[i].idSize; k++)
+                method << BString().SetToFormat("%02X", folder.coders[i].id[k]);
+        }
+    }
+
+    return method;
+}
+
+
+uint64 z7HeaderReader::FolderUnpackSize(z7Folder const& folder) const
+{
+    // The folder's result is the out-stream no other coder consumes
+    for (int32 i = 0; i < folder.outStreamCount; i++)
+    {
+        bool isBound = false;
+        for (int32 j = 0; j < folder.bindPairCount && isBound == false; j++)
+            isBound = folder.bindPairs[j][1] == (uint64)i;
+
+        if (isBound == false)
+            return folder.unpackSizes[i];
+    }
+
+    return 0;
+}
+
+
+bool z7HeaderReader::ReadByte(uint8& value)
+{
+    if (m_pos >= m_size)
+        return false;
+
+    value = m_data[m_pos++];
+    return true;
+}
+
+
+bool z7HeaderReader::ReadNumber(uint64& value)
+{
+    // The leading 1 bits of the first byte tell how many more bytes follow, the rest of
+    // the first byte holds the highest bits
+    uint8 first;
+    if (ReadByte(first) == false)
+        return false;
+
+    value = 0;
+    uint8 mask = 0x80;
+    for (int32 i = 0; i < 8; i++)
+    {
+        if ((first & mask) == 0)
+        {
+            value |= (uint64)(first & (mask - 1)) << (8 * i);
+            return true;
+        }
+
+        uint8 next;
+        if (ReadByte(next) == false)
+            return false;
+        value |= (uint64)next << (8 * i);
+        mask >>= 1;
+    }
+
+    return true;
+}
+
+
+bool z7HeaderReader::ReadUInt32(uint32& value)
+{
+    if (m_pos + 4 > m_size)
+        return false;
+
+    value = ReadLE32(m_data + m_pos);
+    m_pos += 4;
+    return true;
+}
+
+
+bool z7HeaderReader::ReadUInt64(uint64& value)
+{
+    if (m_pos + 8 > m_size)
+        return false;
+
+    value = ReadLE64(m_data + m_pos);
+    m_pos += 8;
+    return true;
+}
+
+
+bool z7HeaderReader::ReadBitVector(uint64 count, bool* bits)
+{
+    uint8 byte = 0;
+    for (uint64 i = 0; i < count; i++)
+    {
+        if ((i & 7) == 0 && ReadByte(byte) == false)
+            return false;
+
+        bits[i] = (byte & (0x80 >> (i & 7))) != 0;
+    }
+
+    return true;
+}
+
+
+bool z7HeaderReader::ReadDefinedVector(uint64 count, bool* defined)
+{
+    uint8 allDefined;
+    if (ReadByte(allDefined) == false)
+        return false;
+
+    if (allDefined == 0)
+        return ReadBitVector(count, defined);
+
+    for (uint64 i = 0; i < count; i++)
+        defined[i] = true;
+
+    return true;
+}
+
+
+bool z7HeaderReader::ReadDigests(uint64 count, bool* defined, uint32* crcs)
+{
+    if (ReadDefinedVector(count, defined) == false)
+        return false;
+
+    for (uint64 i = 0; i < count; i++)
+        if (defined[i] && ReadUInt32(crcs[i]) == false)
+            return false;
+
+    return true;
+}
+
+
+bool z7HeaderReader::SkipData(uint64 size)
+{
+    if (size > m_size - m_pos)
+        return false;
+
+    m_pos += size;
+    return true;
+}
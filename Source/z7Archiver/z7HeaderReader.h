@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: BSD-3-Clause
+// Copyright (c) 2002 Ramshankar (aka Teknomancer).
+// All rights reserved.
+
+#ifndef _7Z_HEADER_READER_H
+#define _7Z_HEADER_READER_H
+
+#include <List.h>
+#include <String.h>
+
+class BFile;
+
+const int32 kMax7zCoders = 4;
+const int32 kMax7zStreams = 8;
+
+struct z7Coder
+{
+    uint8                   id[15];
+    int32                   idSize;
+    uint64                  inStreams,
+                            outStreams;
+    const uint8*            props;
+    uint64                  propsSize;
+};
+
+struct z7Folder
+{
+    z7Coder                 coders[kMax7zCoders];
+    int32                   coderCount;
+    uint64                  bindPairs[kMax7zStreams][2];
+    int32                   bindPairCount;
+    uint64                  packedStreams[kMax7zStreams];
+    int32                   packedStreamCount;
+    uint64                  unpackSizes[kMax7zStreams];
+    int32                   outStreamCount;
+    bool                    crcDefined;
+    uint32                  crc;
+    uint64                  unpackStreamCount;
+};
+
+struct z7StreamsInfo
+{
+    z7StreamsInfo();
+    ~z7StreamsInfo();
+
+    uint64                  packPos;
+    uint64                  packStreamCount;
+    uint64*                 packSizes;
+    uint64                  folderCount;
+    z7Folder*               folders;
+    uint64                  subStreamCount;
+    uint64*                 subStreamSizes;
+    bool*                   subStreamCrcDefined;
+    uint32*                 subStreamCrcs;
+};
+
+// Lists 7z archives by reading their header (decompressing it first when it is encoded, as it
+// usually is), with exact names, sizes, CRCs, times and which solid block each file sits in
+class z7HeaderReader
+{
+    public:
+        z7HeaderReader(const char* archivePath);
+        ~z7HeaderReader();
+
+        status_t            ReadEntries(BList* entriesList, bool* passwordRequired);
+        bool                HasSolidBlocks() const;
+
+    private:
+        status_t            ReadHeader(BList* entriesList);
+        status_t            DecodeHeader(BFile* file);
+        status_t            ReadStreamsInfo(z7StreamsInfo& info);
+        status_t            ReadPackInfo(z7StreamsInfo& info);
+        status_t            ReadUnpackInfo(z7StreamsInfo& info);
+        status_t            ReadFolder(z7Folder& folder);
+        status_t            ReadSubStreamsInfo(z7StreamsInfo& info);
+        status_t            ReadFilesInfo(z7StreamsInfo& info, BList* entriesList);
+        BString             FolderMethod(z7Folder const& folder) const;
+        uint64              FolderUnpackSize(z7Folder const& folder) const;
+
+        bool                ReadByte(uint8& value);
+        bool                ReadNumber(uint64& value);
+        bool                ReadUInt32(uint32& value);
+        bool                ReadUInt64(uint64& value);
+        bool                ReadBitVector(uint64 count, bool* bits);
+        bool                ReadDefinedVector(uint64 count, bool* defined);
+        bool                ReadDigests(uint64 count, bool* defined, uint32* crcs);
+        bool                SkipData(uint64 size);
+
+        BString             m_archivePath;
+        uint8*              m_data;
+        size_t              m_size,
+                            m_pos;
+        bool                m_passwordRequired,
+                            m_hasSolidBlocks;
+};
+
+#endif /* _7Z_HEADER_READER_H */